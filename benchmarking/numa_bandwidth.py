@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# #########################################################################
+# Copyright (c) 2019, UChicago Argonne, LLC. All rights reserved.         #
+#                                                                         #
+# Copyright 2019. UChicago Argonne, LLC. This software was produced       #
+# under U.S. Government contract DE-AC02-06CH11357 for Argonne National   #
+# Laboratory (ANL), which is operated by UChicago Argonne, LLC for the    #
+# U.S. Department of Energy. The U.S. Government has rights to use,       #
+# reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR    #
+# UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR        #
+# ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is     #
+# modified to produce derivative works, such modified software should     #
+# be clearly marked, so as not to confuse it with the version available   #
+# from ANL.                                                               #
+#                                                                         #
+# Additionally, redistribution and use in source and binary forms, with   #
+# or without modification, are permitted provided that the following      #
+# conditions are met:                                                     #
+#                                                                         #
+#     * Redistributions of source code must retain the above copyright    #
+#       notice, this list of conditions and the following disclaimer.     #
+#                                                                         #
+#     * Redistributions in binary form must reproduce the above copyright #
+#       notice, this list of conditions and the following disclaimer in   #
+#       the documentation and/or other materials provided with the        #
+#       distribution.                                                     #
+#                                                                         #
+#     * Neither the name of UChicago Argonne, LLC, Argonne National       #
+#       Laboratory, ANL, the U.S. Government, nor the names of its        #
+#       contributors may be used to endorse or promote products derived   #
+#       from this software without specific prior written permission.     #
+#                                                                         #
+# THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS     #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT       #
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS       #
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago     #
+# Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,        #
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,    #
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;        #
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        #
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT      #
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN       #
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE         #
+# POSSIBILITY OF SUCH DAMAGE.                                             #
+
+"""
+Per-node memory bandwidth and reconstruction time with and without the
+NUMA mode of the TomoPy C library (see tomopy.set_numa_mode).
+
+The bandwidth test first touches a (nslice, npixel) volume with the same
+one-block-per-thread split that the whole-volume kernels use, then times
+every thread reading its block and sums the traffic per NUMA node.
+"""
+
+from __future__ import print_function
+
+import argparse
+import collections
+import time
+
+import numpy as np
+import tomopy
+import tomopy.util.extern as extern
+
+
+def bandwidth(nslice, npixel, nrep, ncore):
+    arr = np.empty((nslice, npixel), dtype=np.float32)
+    extern.c_touch_volume(arr, 1.0, ncore)
+    seconds, node = extern.c_volume_bandwidth(arr, nrep, ncore)
+    nthreads = len(seconds)
+    block = -(-nslice // nthreads)
+    rows = np.clip(nslice - block * np.arange(nthreads), 0, block)
+    traffic = collections.defaultdict(float)
+    elapsed = collections.defaultdict(float)
+    for n, s, r in zip(node, seconds, rows):
+        traffic[n] += r * npixel * 4.0 * nrep
+        elapsed[n] = max(elapsed[n], s)
+    return {n: traffic[n] / elapsed[n] / 1e9
+            for n in sorted(traffic) if elapsed[n] > 0}
+
+
+def reconstruction(size, nslice, algorithms, ncore):
+    obj = tomopy.shepp3d((nslice, size, size))
+    ang = tomopy.angles(size)
+    prj = tomopy.project(obj, ang, pad=False)
+    times = {}
+    for algorithm in algorithms:
+        kwargs = {} if algorithm in ('gridrec', 'fbp') else {'num_iter': 4}
+        start = time.time()
+        tomopy.recon(prj, ang, algorithm=algorithm, ncore=ncore, **kwargs)
+        times[algorithm] = time.time() - start
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('--nslice', type=int, default=2048)
+    parser.add_argument('--npixel', type=int, default=1 << 18)
+    parser.add_argument('--nrep', type=int, default=10)
+    parser.add_argument('--size', type=int, default=256,
+                        help='phantom size for the reconstruction timings')
+    parser.add_argument('--recon-slices', type=int, default=64)
+    parser.add_argument('--algorithms', nargs='+',
+                        default=['gridrec', 'sirt'])
+    parser.add_argument('--ncore', type=int, default=None)
+    args = parser.parse_args()
+
+    for mode in (False, True):
+        tomopy.set_numa_mode(mode)
+        label = 'numa' if mode else 'default'
+        for n, gbps in bandwidth(args.nslice, args.npixel, args.nrep,
+                                 args.ncore).items():
+            where = 'unpinned' if n < 0 else 'node %d' % n
+            print('%-8s read bandwidth %-9s %8.2f GB/s' % (label, where, gbps))
+        for algorithm, sec in reconstruction(
+                args.size, args.recon_slices, args.algorithms,
+                args.ncore).items():
+            print('%-8s %-22s %8.3f s' % (label, algorithm, sec))
+    tomopy.set_numa_mode(False)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,597 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Stand-alone throughput benchmark of the libtomopy kernels.
+//
+// A 3D Shepp-Logan phantom is generated here, projected with project() and
+// reconstructed with gridrec, so every run of a given size sees the same
+// inputs. Each kernel is timed over a list of thread counts, with the
+// untimed resets of in-place inputs between repeats. Results are printed as
+// a table on stderr and as JSON on stdout (or in the -o file): best and mean
+// seconds, slices/s, GB/s of the input and output arrays touched once, the
+// speedup over the first thread count, and the sum of the output, which
+// changes only when the kernel's results do.
+//
+// Built from config with ``make -f Makefile.<os> bench``.
+
+#include "morph.h"
+#include "prep.h"
+#include "profile.h"
+#include "remove_ring.h"
+#include "stripe.h"
+#include "utils.h"
+
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_MAX_THREADS 64
+
+typedef struct
+{
+    int    n, ns, nang, niter;
+    size_t nobj, nsino;
+    float* obj;     // (ns, n, n) phantom
+    float* sino;    // (ns, nang, n) project() of obj
+    float* prj;     // (nang, ns, n) sino in projection order
+    float* rec;     // (ns, n, n) gridrec of sino
+    float* work;    // in-place kernels run on a copy of prj or rec
+    float* out;     // output of the others
+    float* theta;   // nang angles in [0, pi)
+    float* center;  // ns rotation centers
+    float* ind_block;
+    float  reg_pars[10];
+    float  filter_par[2];
+} bench_data;
+
+typedef struct
+{
+    const char* name;
+    const char* algorithm;  // recon_volume algorithm, if any
+    void (*reset)(bench_data*);
+    void (*run)(bench_data*, const char*, int);
+    double (*nbytes)(const bench_data*);
+    const float* (*result)(const bench_data*, size_t*);
+} bench_kernel;
+
+//============================================================================//
+
+// Modified Shepp-Logan ellipsoids as tomopy.misc.phantom: A, a, b, c, x0,
+// y0, z0, phi, theta, psi.
+static const double shepp[10][10] = {
+    { 1.0, .6900, .920, .810, 0.0, 0.0, 0.0, 90.0, 90.0, 90.0 },
+    { -.8, .6624, .874, .780, 0.0, -.0184, 0.0, 90.0, 90.0, 90.0 },
+    { -.2, .1100, .310, .220, .22, 0.0, 0.0, -108.0, 90.0, 100.0 },
+    { -.2, .1600, .410, .280, -.22, 0.0, 0.0, 108.0, 90.0, 100.0 },
+    { .1, .2100, .250, .410, 0.0, .35, -.15, 90.0, 90.0, 90.0 },
+    { .1, .0460, .046, .050, 0.0, .1, .25, 90.0, 90.0, 90.0 },
+    { .1, .0460, .046, .050, 0.0, -.1, .25, 90.0, 90.0, 90.0 },
+    { .1, .0460, .023, .050, -.08, -.605, 0.0, 90.0, 90.0, 90.0 },
+    { .1, .0230, .023, .020, 0.0, -.606, 0.0, 90.0, 90.0, 90.0 },
+    { .1, .0230, .046, .020, .06, -.605, 0.0, 90.0, 90.0, 90.0 }
+};
+
+// The central ns slices of an n^3 phantom (ns^3 when ns > n).
+static void
+make_phantom(float* obj, int ns, int n)
+{
+    int m  = (ns > n) ? ns : n;
+    int s0 = (m - ns) / 2;
+    int e, s, i, j;
+
+    memset(obj, 0, (size_t) ns * n * n * sizeof(float));
+    for(e = 0; e < 10; e++)
+    {
+        const double* p   = shepp[e];
+        const double  deg = M_PI / 180;
+        double        cph = cos(p[7] * deg), sph = sin(p[7] * deg);
+        double        cth = cos(p[8] * deg), sth = sin(p[8] * deg);
+        double        cps = cos(p[9] * deg), sps = sin(p[9] * deg);
+        double        r[3][3] = {
+            { cps * cph - cth * sph * sps, cps * sph + cth * cph * sps,
+              sps * sth },
+            { -sps * cph - cth * sph * cps, -sps * sph + cth * cph * cps,
+              cps * sth },
+            { sth * sph, -sth * cph, cth }
+        };
+
+        for(s = 0; s < ns; s++)
+        {
+            double x = -1.0 + 2.0 * (s + s0) / (m - 1);
+            for(i = 0; i < n; i++)
+            {
+                double y   = -1.0 + 2.0 * i / (n - 1);
+                float* row = obj + ((size_t) s * n + i) * n;
+                for(j = 0; j < n; j++)
+                {
+                    double z = -1.0 + 2.0 * j / (n - 1);
+                    double u = (r[0][0] * x + r[0][1] * y + r[0][2] * z - p[4]);
+                    double v = (r[1][0] * x + r[1][1] * y + r[1][2] * z - p[5]);
+                    double w = (r[2][0] * x + r[2][1] * y + r[2][2] * z - p[6]);
+                    u /= p[1];
+                    v /= p[2];
+                    w /= p[3];
+                    if(u * u + v * v + w * w <= 1.0)
+                        row[j] += (float) p[0];
+                }
+            }
+        }
+    }
+    for(i = 0; i < ns * n * n; i++)
+        if(obj[i] < 0.0f)
+            obj[i] = 0.0f;
+}
+
+//============================================================================//
+
+static void
+reset_out(bench_data* b)
+{
+    memset(b->out, 0, b->nsino * sizeof(float));
+}
+
+static void
+reset_prj(bench_data* b)
+{
+    memcpy(b->work, b->prj, b->nsino * sizeof(float));
+}
+
+static void
+reset_rec(bench_data* b)
+{
+    memcpy(b->work, b->rec, b->nobj * sizeof(float));
+}
+
+static void
+run_project(bench_data* b, const char* alg, int ncore)
+{
+    project(b->obj, b->ns, b->n, b->n, b->out, b->ns, b->nang, b->n,
+            b->center, b->theta, ncore, 0);
+}
+
+static void
+run_project2(bench_data* b, const char* alg, int ncore)
+{
+    project2(b->obj, b->rec, b->ns, b->n, b->n, b->out, b->ns, b->nang, b->n,
+             b->center, b->theta, ncore, 0);
+}
+
+static void
+run_project3(bench_data* b, const char* alg, int ncore)
+{
+    project3(b->obj, b->rec, b->obj, b->ns, b->n, b->n, b->out, b->ns,
+             b->nang, b->n, b->center, b->theta, 0, ncore, 0);
+}
+
+static void
+run_recon(bench_data* b, const char* alg, int ncore)
+{
+    float init = 1e-6f;
+    recon_volume(alg, b->sino, NULL, NULL, NULL, b->ns, b->nang, b->n,
+                 b->center, b->theta, b->out, b->n, b->n, b->niter,
+                 b->reg_pars, 1, b->ind_block, "shepp", b->filter_par, 0,
+                 PAD_CONSTANT, &init, ncore, 0);
+}
+
+static void
+run_remove_ring(bench_data* b, const char* alg, int ncore)
+{
+    float c = (b->n - 1) * 0.5f;
+
+    remove_ring(b->work, c, c, b->n, b->n, b->ns, 300.0f, -100.0f, 300.0f, 30,
+                30, 0, 0, b->ns, ncore);
+}
+
+static void
+run_remove_stripe_sf(bench_data* b, const char* alg, int ncore)
+{
+    remove_stripe_sf(b->work, b->nang, b->ns, b->n, 5, ncore, 0);
+}
+
+static void
+run_normalize_bg(bench_data* b, const char* alg, int ncore)
+{
+    normalize_bg(b->work, b->nang, b->ns, b->n, 1, 0, ncore, 0);
+}
+
+static void
+run_downsample(bench_data* b, const char* alg, int ncore)
+{
+    int factor[3] = { 1, 1, 2 };
+    sample(0, b->prj, b->nang, b->ns, b->n, factor, 0, ncore, b->out);
+}
+
+static void
+run_upsample(bench_data* b, const char* alg, int ncore)
+{
+    int factor[3] = { 1, 1, 2 };
+    sample(1, b->prj, b->nang, b->ns, b->n, factor, 0, ncore, b->out);
+}
+
+//----------------------------------------------------------------------------//
+
+// Arrays read and written once per call, in bytes.
+static double
+bytes_sino_obj(const bench_data* b)
+{
+    return 4.0 * (b->nobj + b->nsino);
+}
+
+static double
+bytes_project2(const bench_data* b)
+{
+    return 4.0 * (2 * b->nobj + b->nsino);
+}
+
+static double
+bytes_project3(const bench_data* b)
+{
+    return 4.0 * (3 * b->nobj + b->nsino);
+}
+
+static double
+bytes_prj(const bench_data* b)
+{
+    return 4.0 * 2 * b->nsino;
+}
+
+static double
+bytes_rec(const bench_data* b)
+{
+    return 4.0 * 2 * b->nobj;
+}
+
+static double
+bytes_downsample(const bench_data* b)
+{
+    return 4.0 * (b->nsino + b->nsino / 2);
+}
+
+static double
+bytes_upsample(const bench_data* b)
+{
+    return 4.0 * 3 * b->nsino;
+}
+
+static const float*
+result_out_sino(const bench_data* b, size_t* n)
+{
+    *n = b->nsino;
+    return b->out;
+}
+
+static const float*
+result_out_rec(const bench_data* b, size_t* n)
+{
+    *n = b->nobj;
+    return b->out;
+}
+
+static const float*
+result_work_sino(const bench_data* b, size_t* n)
+{
+    *n = b->nsino;
+    return b->work;
+}
+
+static const float*
+result_work_rec(const bench_data* b, size_t* n)
+{
+    *n = b->nobj;
+    return b->work;
+}
+
+static const float*
+result_downsample(const bench_data* b, size_t* n)
+{
+    *n = b->nsino / 2;
+    return b->out;
+}
+
+static const float*
+result_upsample(const bench_data* b, size_t* n)
+{
+    *n = 2 * b->nsino;
+    return b->out;
+}
+
+#define RECON_KERNEL(name)                                                     \
+    {                                                                          \
+        name, name, NULL, run_recon, bytes_sino_obj, result_out_rec            \
+    }
+
+static const bench_kernel kernels[] = {
+    { "project", NULL, reset_out, run_project, bytes_sino_obj,
+      result_out_sino },
+    { "project2", NULL, reset_out, run_project2, bytes_project2,
+      result_out_sino },
+    { "project3", NULL, reset_out, run_project3, bytes_project3,
+      result_out_sino },
+    RECON_KERNEL("gridrec"),
+    RECON_KERNEL("fbp"),
+    RECON_KERNEL("art"),
+    RECON_KERNEL("bart"),
+    RECON_KERNEL("mlem"),
+    RECON_KERNEL("osem"),
+    RECON_KERNEL("ospml_hybrid"),
+    RECON_KERNEL("ospml_quad"),
+    RECON_KERNEL("pml_hybrid"),
+    RECON_KERNEL("pml_hybrid3d"),
+    RECON_KERNEL("pml_quad"),
+    RECON_KERNEL("sirt"),
+    RECON_KERNEL("tv"),
+    RECON_KERNEL("tv3d"),
+    RECON_KERNEL("grad"),
+    { "remove_ring", NULL, reset_rec, run_remove_ring, bytes_rec,
+      result_work_rec },
+    { "remove_stripe_sf", NULL, reset_prj, run_remove_stripe_sf, bytes_prj,
+      result_work_sino },
+    { "normalize_bg", NULL, reset_prj, run_normalize_bg, bytes_prj,
+      result_work_sino },
+    { "downsample", NULL, NULL, run_downsample, bytes_downsample,
+      result_downsample },
+    { "upsample", NULL, NULL, run_upsample, bytes_upsample, result_upsample }
+};
+
+#define NKERNEL ((int) (sizeof(kernels) / sizeof(kernels[0])))
+
+//============================================================================//
+
+static void
+bench_init(bench_data* b, int n, int ns, int nang, int niter)
+{
+    size_t nbig;
+    int    i;
+
+    b->n     = n;
+    b->ns    = ns;
+    b->nang  = nang;
+    b->niter = niter;
+    b->nobj  = (size_t) ns * n * n;
+    b->nsino = (size_t) ns * nang * n;
+    nbig     = (2 * b->nsino > b->nobj) ? 2 * b->nsino : b->nobj;
+
+    b->obj       = (float*) malloc(b->nobj * sizeof(float));
+    b->rec       = (float*) malloc(b->nobj * sizeof(float));
+    b->sino      = (float*) calloc(b->nsino, sizeof(float));
+    b->prj       = (float*) malloc(b->nsino * sizeof(float));
+    b->work      = (float*) malloc(nbig * sizeof(float));
+    b->out       = (float*) malloc(nbig * sizeof(float));
+    b->theta     = (float*) malloc(nang * sizeof(float));
+    b->center    = (float*) malloc(ns * sizeof(float));
+    b->ind_block = (float*) malloc(nang * sizeof(float));
+    assert(b->obj != NULL && b->rec != NULL && b->sino != NULL &&
+           b->prj != NULL && b->work != NULL && b->out != NULL &&
+           b->theta != NULL && b->center != NULL && b->ind_block != NULL);
+
+    for(i = 0; i < nang; i++)
+    {
+        b->theta[i]     = (float) (M_PI * i / nang);
+        b->ind_block[i] = (float) i;
+    }
+    for(i = 0; i < ns; i++)
+        b->center[i] = n * 0.5f;
+    for(i = 0; i < 10; i++)
+        b->reg_pars[i] = 1.0f;
+    b->filter_par[0] = 0.5f;
+    b->filter_par[1] = 8.0f;
+
+    make_phantom(b->obj, ns, n);
+    project(b->obj, ns, n, n, b->sino, ns, nang, n, b->center, b->theta, 0,
+            0);
+    swap_stack(b->sino, b->prj, ns, nang, n, sizeof(float), 0);
+    run_recon(b, "gridrec", 0);
+    memcpy(b->rec, b->out, b->nobj * sizeof(float));
+}
+
+static void
+bench_free(bench_data* b)
+{
+    free(b->obj);
+    free(b->rec);
+    free(b->sino);
+    free(b->prj);
+    free(b->work);
+    free(b->out);
+    free(b->theta);
+    free(b->center);
+    free(b->ind_block);
+}
+
+//============================================================================//
+
+static int
+selected(const char* list, const char* name)
+{
+    size_t      len = strlen(name);
+    const char* p   = list;
+
+    if(list == NULL)
+        return 1;
+    while((p = strstr(p, name)) != NULL)
+    {
+        if((p == list || p[-1] == ',') && (p[len] == ',' || p[len] == '\0'))
+            return 1;
+        p += len;
+    }
+    return 0;
+}
+
+static void
+usage(const char* prog)
+{
+    int k;
+
+    fprintf(stderr,
+            "usage: %s [-n width] [-s slices] [-a angles] [-i iterations]\n"
+            "          [-r repeats] [-t threads,...] [-k kernel,...]"
+            " [-o file.json]\n\n"
+            "defaults: -n 128 -s 16 -a 128 -i 2 -r 3, threads 1, 2, 4, ..."
+            " up to the\nlibrary default, all kernels:\n",
+            prog);
+    for(k = 0; k < NKERNEL; k++)
+        fprintf(stderr, "%s%s", (k % 6) ? ", " : "\n    ", kernels[k].name);
+    fprintf(stderr, "\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    int         n = 128, ns = 16, nang = 128, niter = 2, repeat = 3;
+    int         threads[BENCH_MAX_THREADS], nthreads = 0;
+    const char* klist = NULL;
+    const char* fname = NULL;
+    FILE*       json  = stdout;
+    bench_data  b;
+    int         i, k, t, r, first = 1;
+
+    for(i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if(arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || val == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        switch(arg[1])
+        {
+            case 'n': n = atoi(val); break;
+            case 's': ns = atoi(val); break;
+            case 'a': nang = atoi(val); break;
+            case 'i': niter = atoi(val); break;
+            case 'r': repeat = atoi(val); break;
+            case 'k': klist = val; break;
+            case 'o': fname = val; break;
+            case 't':
+                for(nthreads = 0; *val && nthreads < BENCH_MAX_THREADS;)
+                {
+                    threads[nthreads++] = atoi(val);
+                    val += strcspn(val, ",");
+                    val += (*val == ',');
+                }
+                break;
+            default: usage(argv[0]); return 1;
+        }
+        i++;
+    }
+    if(nthreads == 0)
+    {
+        int max = get_nthreads(0);
+        for(t = 1; t < max && nthreads < BENCH_MAX_THREADS - 1; t *= 2)
+            threads[nthreads++] = t;
+        threads[nthreads++] = max;
+    }
+    if(n < 2 || ns < 1 || nang < 1 || repeat < 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if(fname && (json = fopen(fname, "w")) == NULL)
+    {
+        perror(fname);
+        return 1;
+    }
+
+    bench_init(&b, n, ns, nang, niter);
+
+    fprintf(json,
+            "{\n  \"config\": {\"width\": %d, \"slices\": %d, \"angles\": %d,"
+            " \"iterations\": %d, \"repeats\": %d},\n  \"results\": [",
+            n, ns, nang, niter, repeat);
+    fprintf(stderr, "%-18s %7s %11s %11s %10s %9s %8s\n", "kernel", "threads",
+            "best [s]", "mean [s]", "slices/s", "GB/s", "speedup");
+
+    for(k = 0; k < NKERNEL; k++)
+    {
+        const bench_kernel* kn = kernels + k;
+        double              base = 0.0;
+
+        if(!selected(klist, kn->name))
+            continue;
+        for(t = 0; t < nthreads; t++)
+        {
+            double       best = 0.0, sum = 0.0, check = 0.0;
+            const float* res;
+            size_t       nres, j;
+
+            for(r = 0; r < repeat; r++)
+            {
+                double t0;
+                if(kn->reset)
+                    kn->reset(&b);
+                t0 = profile_clock();
+                kn->run(&b, kn->algorithm, threads[t]);
+                t0 = profile_clock() - t0;
+                sum += t0;
+                if(r == 0 || t0 < best)
+                    best = t0;
+            }
+            res = kn->result(&b, &nres);
+            for(j = 0; j < nres; j++)
+                check += res[j];
+            if(t == 0)
+                base = best;
+
+            fprintf(stderr, "%-18s %7d %11.4e %11.4e %10.2f %9.3f %8.2f\n",
+                    kn->name, threads[t], best, sum / repeat, ns / best,
+                    kn->nbytes(&b) / best * 1e-9, base / best);
+            fprintf(json,
+                    "%s\n    {\"kernel\": \"%s\", \"threads\": %d,"
+                    " \"best_s\": %.6e, \"mean_s\": %.6e,"
+                    " \"slices_per_s\": %.6e, \"gb_per_s\": %.6e,"
+                    " \"speedup\": %.4f, \"checksum\": %.9e}",
+                    first ? "" : ",", kn->name, threads[t], best,
+                    sum / repeat, ns / best, kn->nbytes(&b) / best * 1e-9,
+                    base / best, check);
+            first = 0;
+        }
+    }
+    fprintf(json, "\n  ]\n}\n");
+
+    if(fname)
+        fclose(json);
+    bench_free(&b);
+    return 0;
+}
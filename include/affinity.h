@@ -0,0 +1,100 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Module for NUMA placement of the library threads.
+
+#ifndef _affinity_h
+#define _affinity_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#    define DLL __declspec(dllexport)
+#else
+#    define DLL
+#endif
+
+// NUMA mode, off by default or as set by the TOMOPY_NUMA environment
+// variable. When on, whole-volume kernels pin their threads node by node and
+// give each thread one contiguous block of slices, which the thread first
+// touches and then works on, so every socket reads local memory.
+DLL void
+set_numa_mode(int mode);
+DLL int
+get_numa_mode(void);
+
+// Slices per chunk when ``dy`` slices are split over ``nthreads`` threads.
+// ``nchunk`` <= 0 gives one chunk per thread; ``pair`` rounds that up to an
+// even count for kernels that work on pairs of slices. NUMA mode always uses
+// one chunk per thread and ignores ``nchunk``, since first-touch placement
+// needs the blocks of touch_volume; the Python layer warns about it.
+int
+volume_chunk(int dy, int nthreads, int nchunk, int pair);
+
+// Pin the calling thread, number ``thread`` of ``nthreads``, to its CPU in
+// node-major order, and restore its previous affinity. Both are no-ops
+// outside NUMA mode, for CPUs that sysfs lists on no node, or where pinning
+// is not supported.
+void
+numa_pin(int thread, int nthreads);
+void
+numa_unpin(void);
+
+// NUMA node that thread ``thread`` of ``nthreads`` is pinned to, or -1.
+int
+numa_thread_node(int thread, int nthreads);
+
+// Fill ``dy`` slices of ``size`` floats with ``val``, each block of slices
+// from the thread that whole-volume kernels give it to.
+DLL void
+touch_volume(float* data, int dy, int size, float val, int ncore);
+
+// Read each thread's block of slices ``nrep`` times. ``seconds`` and
+// ``node`` receive, per thread, the time taken and its NUMA node; they must
+// hold get_nthreads(ncore) entries.
+DLL void
+volume_bandwidth(const float* data, int dy, int size, int nrep, int ncore,
+                 double* seconds, int* node);
+
+#endif
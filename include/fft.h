@@ -0,0 +1,102 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Module for batched FFTs shared by the native kernels.
+
+#ifndef _fft_h
+#define _fft_h
+
+#include <complex.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#    define DLL __declspec(dllexport)
+#else
+#    define DLL
+#endif
+
+// Sign of the exponent, same convention as FFTW. Transforms are
+// unnormalized in both directions.
+#define FFT_FORWARD (-1)
+#define FFT_BACKWARD (+1)
+
+typedef struct fft_plan_s fft_plan;
+
+// Plan ``howmany`` in-place complex transforms of length ``n`` stored
+// back-to-back (distance ``n``).
+fft_plan*
+fft_plan_1d(int n, int howmany, int sign);
+
+// Plan an in-place complex 2D transform of a row-major n0 x n1 array.
+fft_plan*
+fft_plan_2d(int n0, int n1, int sign);
+
+// Plan an in-place real 2D transform of a row-major n0 x n1 array. With
+// FFT_FORWARD the real input becomes its n0 x (n1 / 2 + 1) half spectrum,
+// FFT_BACKWARD is the inverse. The real array shares the buffer, with rows
+// padded to 2 * (n1 / 2 + 1) floats.
+fft_plan*
+fft_plan_2d_real(int n0, int n1, int sign);
+
+// Execute a plan on a buffer allocated with fft_malloc_c.
+void
+fft_execute(const fft_plan* plan, float _Complex* data);
+
+void
+fft_destroy(fft_plan* plan);
+
+float _Complex*
+fft_malloc_c(size_t n);
+
+void
+fft_free(void* v);
+
+// The FFTW planner is not thread-safe; anything that creates or destroys
+// FFTW plans must hold this lock.
+void
+fft_planner_lock(void);
+
+void
+fft_planner_unlock(void);
+
+#endif
@@ -45,6 +45,7 @@
 #define _gridrec_h
 
 #include <complex.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #ifdef WIN32
@@ -54,10 +55,30 @@
 #endif
 #define ANSI
 
+// Sinogram rows are extended by ``npad`` samples on each side with a PAD_*
+// ``pad_mode`` of utils.h as they are loaded into the zero-padded transform
+// buffer; PAD_CONSTANT pads with zeros.
 void DLL
      gridrec(const float* data, int dy, int dt, int dx, const float* center,
              const float* theta, float* recon, int ngridx, int ngridy,
-             const char fname[16], const float* filter_par);
+             const char fname[16], const float* filter_par, int npad,
+             int pad_mode);
+
+// gridrec of raw uint16 sinograms (dy, dt, dx), normalized with (dy, dx)
+// flat and dark tables and minus-logged slice by slice.
+void DLL
+     gridrec_uint16(const uint16_t* data, const float* flat, const float* dark,
+                    int dy, int dt, int dx, const float* center,
+                    const float* theta, float* recon, int ngridx, int ngridy,
+                    const char* fname, const float* filter_par, int npad,
+                    int pad_mode);
+
+// Reconstruct one (dt, dx) sinogram at ``ncen`` rotation centers into
+// ``ncen`` slices. The projections are transformed only once.
+void DLL
+     gridrec_sweep(const float* data, int dt, int dx, const float* center,
+                   int ncen, const float* theta, float* recon, int ngridx,
+                   int ngridy, const char* fname, const float* filter_par);
 
 float*
 malloc_vector_f(size_t n);
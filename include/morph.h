@@ -55,9 +55,27 @@
 #    define DLL
 #endif
 
+// Downsample (mode 0) or upsample (mode 1) by an integer factor along each
+// of the three axes. Downsampling takes the mean, or the median if
+// ``median`` is non-zero, of each block.
 DLL void
-sample(int mode, const float* data, int dx, int dy, int dz, int axis, int npad,
-       float* out);
+sample(int mode, const float* data, int dx, int dy, int dz,
+       const int* factor, int median, int ncore, float* out);
+
+// Swap the first two axes of a (n0, n1, n2) stack of ``elsize``-byte
+// elements, e.g. projections into sinograms. Rows of n2 elements are moved
+// in tiles that stay in cache on both sides; threads split the output along
+// its first axis, pinned as whole-volume kernels are in NUMA mode.
+DLL void
+swap_stack(const void* src, void* dst, int n0, int n1, int n2, int elsize,
+           int ncore);
+
+// In-place version of swap_stack, following the cycles of the row
+// permutation. Extra memory is one bit per row plus a fixed batch of cycle
+// leaders and one row per thread.
+DLL void
+swap_stack_inplace(void* data, int n0, int n1, int n2, int elsize,
+                   int ncore);
 
 DLL void
 downsample(const float* data, int dx, int dy, int dz, int level, int axis,
@@ -67,4 +85,19 @@ DLL void
 upsample(const float* data, int dx, int dy, int dz, int level, int axis,
          float* out);
 
+// Stitch a 360-degree scan, whose second half of ``dx`` projections mirrors
+// the first, into a 180-degree one of width 2 * dz - overlap. ``left``
+// selects the side of the rotation axis; the ``overlap`` columns are blended
+// linearly. ``out`` is (dx / 2, dy, 2 * dz - overlap).
+DLL void
+sino_360_to_180(const float* data, int dx, int dy, int dz, int overlap,
+                int left, int ncore, float* out);
+
+// Pad a (dx, dy, dz) volume by ``npad`` on both sides of ``axis`` into
+// ``out``, with np.pad's 'constant' (``cval``), 'edge' or 'reflect' mode as
+// PAD_CONSTANT, PAD_EDGE or PAD_REFLECT from utils.h.
+DLL void
+pad_volume(const float* data, int dx, int dy, int dz, int axis, int npad,
+           int mode, float cval, int ncore, float* out);
+
 #endif
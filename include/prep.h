@@ -46,6 +46,7 @@
 #ifndef _corr_h
 #define _corr_h
 
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef WIN32
@@ -55,6 +56,29 @@
 #endif
 
 DLL void
-normalize_bg(float* data, int dx, int dy, int dz, int nair);
+normalize_bg(float* data, int dx, int dy, int dz, int nair, int median,
+             int ncore, int nchunk);
+
+DLL void
+normalize_fused_uint16(const uint16_t* data, const float* flat,
+                       const float* dark, float* out, int dx, int dy, int dz,
+                       float cutoff, float dif, int size, int nair,
+                       int air_median, int minus_log, int ncore);
+
+DLL void
+normalize_fused_float32(const float* data, const float* flat,
+                        const float* dark, float* out, int dx, int dy, int dz,
+                        float cutoff, float dif, int size, int nair,
+                        int air_median, int minus_log, int ncore);
+
+// Paganin phase retrieval of ``dx`` projections of dy x dz pixels, in
+// place. Each projection is padded by ``py`` rows and ``pz`` columns on
+// both sides with a PAD_* ``mode`` of utils.h (``cval`` for PAD_CONSTANT)
+// as it is loaded, multiplied in Fourier space by ``filter``, the
+// (dy + 2 py) x ((dz + 2 pz) / 2 + 1) half spectrum of the filter with
+// the 1 / (ny * nz) scaling of the inverse folded in, and cropped back.
+DLL void
+retrieve_phase(float* data, int dx, int dy, int dz, const float* filter,
+               int py, int pz, int mode, float cval, int ncore, int nchunk);
 
 #endif
@@ -0,0 +1,122 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Module for timing the phases of the C kernels.
+
+#ifndef _profile_h
+#define _profile_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#    define DLL __declspec(dllexport)
+#else
+#    define DLL
+#endif
+
+// Phases are timed only when the library is built with -DTOMOPY_PROFILE;
+// otherwise the macros below expand to nothing. A phase is timed with
+//
+//     PROFILE_START(t);
+//     ...
+//     PROFILE_STOP(t, "gridrec.fft2d", nbytes);
+//
+// which adds one call, its wall time and ``nbytes`` bytes touched to the
+// totals of the named phase, and logs an event with the calling thread for
+// trace output. PROFILE_RESTART(t) reuses ``t`` for the next phase. The
+// phase is looked up on first use; profile_phase() registers it under a lock
+// and the cached index is read and written atomically, so concurrent threads
+// agree on it.
+#ifdef TOMOPY_PROFILE
+#    define PROFILE_START(var) double var = profile_clock()
+#    define PROFILE_RESTART(var) var = profile_clock()
+#    define PROFILE_STOP(var, name, nbytes)                                    \
+        do                                                                     \
+        {                                                                      \
+            static int profile_slot_ = -1;                                     \
+            int        profile_s_;                                             \
+            _Pragma("omp atomic read") profile_s_ = profile_slot_;             \
+            if(profile_s_ < 0)                                                 \
+            {                                                                  \
+                profile_s_ = profile_phase(name);                              \
+                _Pragma("omp atomic write") profile_slot_ = profile_s_;        \
+            }                                                                  \
+            profile_record(profile_s_, var, (double) (nbytes));                \
+        } while(0)
+#else
+#    define PROFILE_START(var)
+#    define PROFILE_RESTART(var)
+#    define PROFILE_STOP(var, name, nbytes)
+#endif
+
+double
+profile_clock(void);
+int
+profile_phase(const char* name);
+void
+profile_record(int phase, double start, double nbytes);
+
+// Non-zero when phases are timed in this build.
+DLL int
+profile_enabled(void);
+
+// Clear all totals and events.
+DLL void
+profile_reset(void);
+
+// Copy up to ``max`` phases: names into ``names`` as PROFILE_NAME_LEN-byte
+// strings, and their call counts, seconds and bytes. Returns the number of
+// phases recorded.
+#define PROFILE_NAME_LEN 32
+DLL int
+profile_phases(int max, char* names, long long* counts, double* seconds,
+               double* bytes);
+
+// Copy up to ``max`` logged events: phase index, thread number, and start
+// and duration in seconds since the first event. Returns the number logged.
+DLL int
+profile_events(int max, int* phase, int* thread, double* start,
+               double* duration);
+
+#endif
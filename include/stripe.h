@@ -56,7 +56,31 @@
 #endif
 
 DLL void
-remove_stripe_sf(float* data, int dx, int dy, int dz, int size, int istart,
-                 int iend);
+remove_stripe_sf(float* data, int dx, int dy, int dz, int size, int ncore,
+                 int nchunk);
+
+DLL void
+remove_stripe_based_sorting(float* data, int dx, int dy, int dz, int size,
+                            int ncore, int nchunk);
+
+DLL void
+remove_stripe_based_filtering(float* data, int dx, int dy, int dz,
+                              float sigma, int size, int ncore, int nchunk);
+
+DLL void
+remove_stripe_based_fitting(float* data, int dx, int dy, int dz, int order,
+                            float sigmax, float sigmay, int ncore, int nchunk);
+
+DLL void
+remove_large_stripe(float* data, int dx, int dy, int dz, float snr, int size,
+                    int ncore, int nchunk);
+
+DLL void
+remove_dead_stripe(float* data, int dx, int dy, int dz, float snr, int size,
+                   int ncore, int nchunk);
+
+DLL void
+remove_all_stripe(float* data, int dx, int dy, int dz, float snr, int la_size,
+                  int sm_size, int ncore, int nchunk);
 
 #endif
\ No newline at end of file
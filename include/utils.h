@@ -48,8 +48,12 @@
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
 
 #define _USE_MATH_DEFINES
 #ifndef M_PI
@@ -62,21 +66,75 @@
 #    define DLL
 #endif
 
+// Library-wide number of threads, used by kernels called with ncore <= 0.
+// It defaults to the TOMOPY_NUM_THREADS environment variable, or to the
+// OpenMP default when that is unset.
+void DLL
+     set_num_threads(int nthreads);
+
+int DLL
+    get_num_threads(void);
+
+// Non-zero when the library was built with OpenMP. Without it every kernel
+// runs on the calling thread and callers have to split the work themselves.
+int DLL
+    has_openmp(void);
+
+// Number of threads used by the OpenMP-parallel kernels: ``ncore`` when
+// positive, otherwise the library default.
+static inline int
+get_nthreads(int ncore)
+{
+#ifdef _OPENMP
+    return (ncore > 0) ? ncore : get_num_threads();
+#else
+    return 1;
+#endif
+}
+
 // Data simulation
 
 void DLL
      project(const float* obj, int oy, int ox, int oz, float* data, int dy, int dt,
-             int dx, const float* center, const float* theta);
+             int dx, const float* center, const float* theta, int ncore,
+             int nchunk);
 
 void DLL
      project2(const float* objx, const float* objy, int oy, int ox, int oz,
               float* data, int dy, int dt, int dx, const float* center,
-              const float* theta);
+              const float* theta, int ncore, int nchunk);
 
 void DLL
      project3(const float* objx, const float* objy, const float* objz, int oy,
               int ox, int oz, float* data, int dy, int dt, int dx,
-              const float* center, const float* theta, int axis);
+              const float* center, const float* theta, int axis, int ncore,
+              int nchunk);
+
+// Cone-beam projection of an (oy, ox, oz) object into sinogram-ordered
+// (dy, dt, dx) data; see project.c for the geometry.
+void DLL
+     project_cone(const float* obj, int oy, int ox, int oz, float* data, int dy,
+                  int dt, int dx, float center, float vcenter,
+                  const float* theta, float dist, int ncore, int nchunk);
+
+// Near-field propagation of ``dx`` projections of projected attenuation
+// ``mu`` and refractive index decrement ``delta`` (dy x dz pixels) to
+// intensity ``out``; see propagate.c.
+void DLL
+     propagate_tie(const float* mu, const float* delta, float* out, int dx, int dy,
+                   int dz, float pixel_size, float dist, int ncore);
+
+void DLL
+     propagate_fresnel(const float* mu, const float* delta, float* out, int dx,
+                       int dy, int dz, float pixel_size, float dist,
+                       float wavelength, int ncore);
+
+// Raster scan of a sx x sy probe over ``nproj`` px x py projections. With
+// ``cplx`` set, probe and proj hold interleaved complex64 values.
+void DLL
+     calc_intensity(const float* probe, int sx, int sy, const float* proj,
+                    int nproj, int px, int py, const int* x, int nx, const int* y,
+                    int ny, int cplx, int far, float* out, int ncore);
 
 // Reconstruction algorithms
 
@@ -95,6 +153,23 @@ void DLL
          const float* theta, float* recon, int ngridx, int ngridy,
          const char name[16], const float* filter_par);
 
+// fbp of raw uint16 sinograms (dy, dt, dx), normalized with (dy, dx) flat
+// and dark tables and minus-logged slice by slice.
+void DLL
+     fbp_uint16(const uint16_t* data, const float* flat, const float* dark,
+                int dy, int dt, int dx, const float* center, const float* theta,
+                float* recon, int ngridx, int ngridy, const char* fname,
+                const float* filter_par);
+
+// FDK reconstruction of cone-beam data with the geometry of project_cone,
+// for a full 360 degree orbit. ``dist`` must exceed the half diagonal of the
+// grid; this is checked by the Python wrapper, not here.
+void DLL
+     fdk(const float* data, int dy, int dt, int dx, float center, float vcenter,
+         const float* theta, float dist, float* recon, int nz, int ngridx,
+         int ngridy, const char* fname, const float* filter_par, int ncore,
+         int nchunk);
+
 void DLL
      grad(const float* data, int dy, int dt, int dx, const float* center,
           const float* theta, float* recon, int ngridx, int ngridy, int num_iter,
@@ -126,6 +201,13 @@ void DLL
                 const float* theta, float* recon, int ngridx, int ngridy,
                 int num_iter, const float* reg_pars);
 
+// pml_hybrid with the penalty also coupling neighbouring slices; slices
+// are split over ``ncore`` threads in blocks of ``nchunk``.
+void DLL
+     pml_hybrid3d(const float* data, int dy, int dt, int dx, const float* center,
+                  const float* theta, float* recon, int ngridx, int ngridy,
+                  int num_iter, const float* reg_pars, int ncore, int nchunk);
+
 void DLL
      pml_quad(const float* data, int dy, int dt, int dx, const float* center,
               const float* theta, float* recon, int ngridx, int ngridy, int num_iter,
@@ -140,23 +222,52 @@ void DLL
         const float* theta, float* recon, int ngridx, int ngridy, int num_iter,
         const float* reg_pars);
 
+// tv with the total variation also taken across slices; slices are split
+// over ``ncore`` threads in blocks of ``nchunk``.
+void DLL
+     tv3d(const float* data, int dy, int dt, int dx, const float* center,
+          const float* theta, float* recon, int ngridx, int ngridy, int num_iter,
+          const float* reg_pars, int ncore, int nchunk);
+
+// Reconstruct a whole (dy, dt, dx) volume with one of the slice-wise
+// algorithms above, named as in tomopy.recon. Chunks of ``nchunk`` slices
+// (an even share per thread when not positive) are spread over ``ncore``
+// threads. Arguments an algorithm does not take are ignored; ``raw`` with
+// its flat and dark tables replaces ``data`` for gridrec and fbp, and
+// gridrec pads its sinogram rows by ``npad`` in ``pad_mode``. When
+// ``init`` is given, each thread fills its chunk of ``recon`` with it first,
+// which places those pages on the thread's NUMA node.
+void DLL
+     recon_volume(const char* algorithm, const float* data, const uint16_t* raw,
+                  const float* flat, const float* dark, int dy, int dt, int dx,
+                  const float* center, const float* theta, float* recon,
+                  int ngridx, int ngridy, int num_iter, const float* reg_pars,
+                  int num_block, const float* ind_block, const char* fname,
+                  const float* filter_par, int npad, int pad_mode,
+                  const float* init, int ncore, int nchunk);
+
+// Vector tomography: SIRT updates of pairs of vector components, one pass
+// per dataset, with slices updated in parallel over ``ncore`` threads in
+// slabs of at most ``nchunk`` slices.
 void DLL
      vector(const float* data, int dy, int dt, int dx, const float* center,
             const float* theta, float* recon1, float* recon2, int ngridx, int ngridy,
-            int num_iter);
+            int num_iter, int ncore, int nchunk);
 
 void DLL
      vector2(const float* data1, const float* data2, int dy, int dt, int dx,
              const float* center1, const float* center2, const float* theta1,
              const float* theta2, float* recon1, float* recon2, float* recon3,
-             int ngridx, int ngridy, int num_iter, int axis1, int axis2);
+             int ngridx, int ngridy, int num_iter, int axis1, int axis2,
+             int ncore, int nchunk);
 
 void DLL
      vector3(const float* data1, const float* data2, const float* data3, int dy,
              int dt, int dx, const float* center1, const float* center2,
              const float* center3, const float* theta1, const float* theta2,
              const float* theta3, float* recon1, float* recon2, float* recon3,
-             int ngridx, int ngridy, int num_iter, int axis1, int axis2, int axis3);
+             int ngridx, int ngridy, int num_iter, int axis1, int axis2, int axis3,
+             int ncore, int nchunk);
 
 // Utility functions for data simultation
 
@@ -207,4 +318,105 @@ void DLL
                    float vx, float vy, const float* modelx, const float* modely,
                    const float* modelz, int axis, float* simdata);
 
+// Scratch space for tracing one ray through the (ox, oz) object grid.
+typedef struct
+{
+    float *coordx, *coordy, *ax, *ay, *bx, *by, *coorx, *coory, *dist;
+    int*   indi;
+} ray_buffers;
+
+void DLL
+     ray_alloc(ray_buffers* b, int ox, int oz);
+
+void DLL
+     ray_free(ray_buffers* b);
+
+// Trace the ray at offset yi from the origin, at the angle given by
+// quadrant, sin_p and cos_p. Returns the number of intersection points;
+// the pixel indices and lengths of the csize - 1 segments are left in
+// b->indi and b->dist.
+int DLL
+    trace_ray(int ox, int oz, float yi, int quadrant, float sin_p, float cos_p,
+              const float* gridx, const float* gridy, ray_buffers* b);
+
+// Convert slice s of raw uint16 sinograms (dy, dt, dx) to float line
+// integrals -log((data - dark) / (flat - dark)) in ``out`` (dt, dx), with
+// (dy, dx) flat and dark tables.
+void DLL
+     convert_raw_sinogram(const uint16_t* data, const float* flat,
+                          const float* dark, int s, int dt, int dx, float* out);
+
+// Filtering helpers shared by the preprocessing kernels
+
+// Boundary index as scipy.ndimage 'reflect' (edge sample repeated).
+static inline int
+reflect_index(int i, int n)
+{
+    int period = 2 * n;
+    i %= period;
+    if(i < 0)
+        i += period;
+    return (i < n) ? i : period - 1 - i;
+}
+
+// Boundary index as numpy 'reflect' / scipy.ndimage 'mirror' (edge sample
+// not repeated).
+static inline int
+mirror_index(int i, int n)
+{
+    int period = 2 * (n - 1);
+    if(period == 0)
+        return 0;
+    i %= period;
+    if(i < 0)
+        i += period;
+    return (i < n) ? i : period - i;
+}
+
+// Padding of the pad-aware kernels, which synthesize the samples around a
+// row as they load it instead of reading a padded copy. Modes follow np.pad.
+enum
+{
+    PAD_CONSTANT = 0,
+    PAD_EDGE     = 1,
+    PAD_REFLECT  = 2
+};
+
+// Index into a row of n samples of the padded sample i (negative on the
+// left), or -1 where ``mode`` is PAD_CONSTANT.
+static inline int
+pad_index(int i, int n, int mode)
+{
+    if(i >= 0 && i < n)
+        return i;
+    switch(mode)
+    {
+        case PAD_EDGE: return (i < 0) ? 0 : n - 1;
+        case PAD_REFLECT: return mirror_index(i, n);
+        default: return -1;
+    }
+}
+
+// Copy the n samples of ``src`` into ``dst`` after ``left`` padded samples
+// and before ``right`` more; ``cval`` fills them in PAD_CONSTANT mode.
+void DLL
+     pad_row(const float* src, int n, int left, int right, int mode, float cval,
+             float* dst);
+
+// k-th smallest element of a, partially reorders a.
+float DLL
+      select_kth(float* a, int n, int k);
+
+// Median of a as np.median (mean of the two middle values for even n),
+// partially reorders a.
+float DLL
+      select_median(float* a, int n);
+
+// Median filter of a row-major (ny, nx) image with a (sy, sx) window and
+// 'reflect' boundaries, as scipy.ndimage.median_filter. ``window`` holds at
+// least sy * sx floats.
+void DLL
+     median_filter_2d(const float* in, float* out, int ny, int nx, int sy, int sx,
+                      float* window);
+
 #endif
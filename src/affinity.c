@@ -0,0 +1,292 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#if defined(__linux__)
+#    define _GNU_SOURCE
+#    include <sched.h>
+#endif
+
+#include "affinity.h"
+#include "utils.h"
+#include <time.h>
+
+static int numa_mode = -1;
+
+#if defined(__linux__)
+// Allowed CPUs ordered node by node, and the node of each.
+static int  ncpu      = 0;
+static int* cpu_order = NULL;
+static int* cpu_node  = NULL;
+
+static __thread cpu_set_t saved_mask;
+static __thread int       pinned = 0;
+#endif
+
+//============================================================================//
+
+static double
+wall_time(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+//============================================================================//
+
+void
+set_numa_mode(int mode)
+{
+    numa_mode = mode;
+}
+
+//============================================================================//
+
+#if defined(__linux__)
+static void
+add_cpu(int cpu, int node, const cpu_set_t* allowed, cpu_set_t* seen)
+{
+    if(cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, allowed) ||
+       CPU_ISSET(cpu, seen))
+        return;
+    CPU_SET(cpu, seen);
+    cpu_order[ncpu] = cpu;
+    cpu_node[ncpu]  = node;
+    ncpu++;
+}
+
+// Read the node layout from sysfs once. CPUs that no node lists, e.g. when
+// sysfs is not mounted, are put last with node -1; their threads are not
+// pinned, since nothing is known about where their memory lives.
+static void
+numa_topology(void)
+{
+    cpu_set_t allowed, seen;
+    char      path[64];
+    int       node, lo, hi, c, n;
+    FILE*     f;
+
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+    n         = CPU_COUNT(&allowed);
+    cpu_order = (int*) malloc(n * sizeof(int));
+    cpu_node  = (int*) malloc(n * sizeof(int));
+    CPU_ZERO(&seen);
+
+    for(node = 0; node < 256 && ncpu < n; node++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+                 node);
+        f = fopen(path, "r");
+        if(!f)
+            continue;
+        // cpulist reads like "0-15,32-47"
+        while(fscanf(f, "%d", &lo) == 1)
+        {
+            hi = lo;
+            c  = fgetc(f);
+            if(c == '-' && fscanf(f, "%d", &hi) == 1)
+                c = fgetc(f);
+            for(; lo <= hi; lo++)
+                add_cpu(lo, node, &allowed, &seen);
+            if(c != ',')
+                break;
+        }
+        fclose(f);
+    }
+    for(lo = 0; lo < CPU_SETSIZE && ncpu < n; lo++)
+        add_cpu(lo, -1, &allowed, &seen);
+}
+#endif
+
+//============================================================================//
+
+int
+get_numa_mode(void)
+{
+    if(numa_mode < 0)
+    {
+        const char* env = getenv("TOMOPY_NUMA");
+        numa_mode       = (env) ? atoi(env) : 0;
+    }
+#if defined(__linux__)
+    if(numa_mode > 0 && cpu_order == NULL)
+    {
+#    pragma omp critical(numa_topology)
+        if(cpu_order == NULL)
+            numa_topology();
+    }
+#endif
+    return numa_mode > 0;
+}
+
+//============================================================================//
+
+int
+volume_chunk(int dy, int nthreads, int nchunk, int pair)
+{
+    if(nchunk <= 0 || get_numa_mode())
+    {
+        nchunk = (dy + nthreads - 1) / nthreads;
+        if(pair && nchunk % 2 && nchunk < dy)
+            nchunk++;
+    }
+    return (nchunk > 0) ? nchunk : 1;
+}
+
+//============================================================================//
+
+void
+numa_pin(int thread, int nthreads)
+{
+#if defined(__linux__)
+    cpu_set_t mask;
+    int       i;
+    if(!get_numa_mode() || ncpu == 0)
+        return;
+    i = (int) ((long long) thread * ncpu / nthreads);
+    if(cpu_node[i] < 0 ||
+       sched_getaffinity(0, sizeof(saved_mask), &saved_mask) != 0)
+        return;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu_order[i], &mask);
+    pinned = (sched_setaffinity(0, sizeof(mask), &mask) == 0);
+#else
+    (void) thread;
+    (void) nthreads;
+#endif
+}
+
+//============================================================================//
+
+void
+numa_unpin(void)
+{
+#if defined(__linux__)
+    if(pinned)
+        sched_setaffinity(0, sizeof(saved_mask), &saved_mask);
+    pinned = 0;
+#endif
+}
+
+//============================================================================//
+
+int
+numa_thread_node(int thread, int nthreads)
+{
+#if defined(__linux__)
+    if(get_numa_mode() && ncpu > 0)
+        return cpu_node[(int) ((long long) thread * ncpu / nthreads)];
+#else
+    (void) thread;
+    (void) nthreads;
+#endif
+    return -1;
+}
+
+//============================================================================//
+
+// Slices [s0, s1) of the calling thread in the one-block-per-thread split.
+static void
+thread_block(int dy, int* t, int* nt, size_t* s0, size_t* s1)
+{
+    int nchunk;
+#ifdef _OPENMP
+    *t  = omp_get_thread_num();
+    *nt = omp_get_num_threads();
+#endif
+    nchunk = volume_chunk(dy, *nt, 0, 0);
+    *s0    = (size_t) *t * nchunk;
+    *s1    = *s0 + nchunk;
+    if(*s0 > (size_t) dy)
+        *s0 = dy;
+    if(*s1 > (size_t) dy)
+        *s1 = dy;
+}
+
+//============================================================================//
+
+void
+touch_volume(float* data, int dy, int size, float val, int ncore)
+{
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        int    t = 0, nt = 1;
+        size_t i, s0, s1;
+        thread_block(dy, &t, &nt, &s0, &s1);
+        numa_pin(t, nt);
+        for(i = s0 * size; i < s1 * size; i++)
+            data[i] = val;
+        numa_unpin();
+    }
+}
+
+//============================================================================//
+
+void
+volume_bandwidth(const float* data, int dy, int size, int nrep, int ncore,
+                 double* seconds, int* node)
+{
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        int            t = 0, nt = 1, r;
+        size_t         i, s0, s1;
+        double         t0;
+        float          sum = 0.0f;
+        volatile float sink;
+        thread_block(dy, &t, &nt, &s0, &s1);
+        numa_pin(t, nt);
+#pragma omp barrier
+        t0 = wall_time();
+        for(r = 0; r < nrep; r++)
+            for(i = s0 * size; i < s1 * size; i++)
+                sum += data[i];
+        sink       = sum;
+        seconds[t] = wall_time() - t0;
+        node[t]    = numa_thread_node(t, nt);
+        (void) sink;
+        numa_unpin();
+    }
+}
@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -84,6 +85,7 @@ art(const float* data, int dy, int dt, int dx, const float* center,
         // For each projection angle
         for(p = 0; p < dt; p++)
         {
+            PROFILE_START(t_angle);
             // Calculate the sin and cos values
             // of the projection angle and find
             // at which quadrant on the cartesian grid.
@@ -145,6 +147,8 @@ art(const float* data, int dy, int dt, int dx, const float* center,
                     }
                 }
             }
+            PROFILE_STOP(t_angle, "art.project",
+                         sizeof(float) * (size_t) dy * dx * 2);
         }
     }
     free(gridx);
@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -106,6 +107,7 @@ bart(const float* data, int dy, int dt, int dx, const float* center,
                 memset(sum_dist, 0, (ngridx * ngridy) * sizeof(float));
                 memset(update, 0, (ngridx * ngridy) * sizeof(float));
 
+                PROFILE_START(t_subset);
                 // For each projection angle
                 for(q = 0; q < subset_ind2; q++)
                 {
@@ -171,6 +173,9 @@ bart(const float* data, int dy, int dt, int dx, const float* center,
                         }
                     }
                 }
+                PROFILE_STOP(t_subset, "bart.project",
+                             sizeof(float) * (size_t) subset_ind2 * dx * 2);
+                PROFILE_RESTART(t_subset);
 
                 for(n = 0; n < ngridx * ngridy; n++)
                 {
@@ -180,6 +185,8 @@ bart(const float* data, int dy, int dt, int dx, const float* center,
                         recon[n + ind_recon] += update[n] / sum_dist[n];
                     }
                 }
+                PROFILE_STOP(t_subset, "bart.update",
+                             sizeof(float) * (size_t) ngridx * ngridy * 3);
             }
         }
     }
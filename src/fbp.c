@@ -43,10 +43,12 @@
 
 #include "utils.h"
 
-void
-fbp(const float* data, int dy, int dt, int dx, const float* center,
-    const float* theta, float* recon, int ngridx, int ngridy, const char* fname,
-    const float* filter_par)
+// Raw uint16 sinograms are converted one slice at a time into ``slab`` by
+// convert_raw_sinogram, float sinograms are read in place.
+static void
+fbp_impl(const float* data, const uint16_t* raw, const float* flat,
+         const float* dark, int dy, int dt, int dx, const float* center,
+         const float* theta, float* recon, int ngridx, int ngridy)
 {
     float* gridx  = (float*) malloc((ngridx + 1) * sizeof(float));
     float* gridy  = (float*) malloc((ngridy + 1) * sizeof(float));
@@ -60,6 +62,7 @@ fbp(const float* data, int dy, int dt, int dx, const float* center,
     float* coory  = (float*) malloc((ngridx + ngridy) * sizeof(float));
     float* dist   = (float*) malloc((ngridx + ngridy) * sizeof(float));
     int*   indi   = (int*) malloc((ngridx + ngridy) * sizeof(int));
+    float* slab   = raw ? (float*) malloc((size_t) dt * dx * sizeof(float)) : NULL;
 
     assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
            by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
@@ -75,6 +78,17 @@ fbp(const float* data, int dy, int dt, int dx, const float* center,
     // For each slice
     for(s = 0; s < dy; s++)
     {
+        const float* sdata;
+        if(raw)
+        {
+            convert_raw_sinogram(raw, flat, dark, s, dt, dx, slab);
+            sdata = slab;
+        }
+        else
+        {
+            sdata = data + (size_t) s * dt * dx;
+        }
+
         preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
                       gridy);  // Outputs: mov, gridx, gridy
 
@@ -116,10 +130,10 @@ fbp(const float* data, int dy, int dt, int dx, const float* center,
 
                 // Update
                 ind_recon = s * ngridx * ngridy;
-                ind_data  = d + p * dx + s * dt * dx;
+                ind_data  = d + p * dx;
                 for(n = 0; n < csize - 1; n++)
                 {
-                    recon[indi[n] + ind_recon] += data[ind_data] * dist[n];
+                    recon[indi[n] + ind_recon] += sdata[ind_data] * dist[n];
                 }
             }
         }
@@ -137,4 +151,28 @@ fbp(const float* data, int dy, int dt, int dx, const float* center,
     free(coory);
     free(dist);
     free(indi);
+    free(slab);
+}
+
+//============================================================================//
+
+void
+fbp(const float* data, int dy, int dt, int dx, const float* center,
+    const float* theta, float* recon, int ngridx, int ngridy, const char* fname,
+    const float* filter_par)
+{
+    fbp_impl(data, NULL, NULL, NULL, dy, dt, dx, center, theta, recon, ngridx,
+             ngridy);
+}
+
+//============================================================================//
+
+void
+fbp_uint16(const uint16_t* data, const float* flat, const float* dark, int dy,
+           int dt, int dx, const float* center, const float* theta,
+           float* recon, int ngridx, int ngridy, const char* fname,
+           const float* filter_par)
+{
+    fbp_impl(NULL, data, flat, dark, dy, dt, dx, center, theta, recon, ngridx,
+             ngridy);
 }
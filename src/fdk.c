@@ -0,0 +1,356 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Module for FDK cone-beam reconstruction.
+
+#include "fft.h"
+#include "gridrec.h"
+#include "profile.h"
+#include "utils.h"
+
+// Complex transforms per FFT batch; each one filters two real rows.
+#define FDK_BATCH 8
+
+// Geometry follows project_cone: lengths are in voxels, the detector is
+// taken at the rotation axis and ``dist`` is the source-to-axis distance.
+// Detector column d and row r sit at u = d + 0.5 - center and
+// v = r + 0.5 - vcenter, voxel (k, i, j) at
+// (x, y, z) = (i + 0.5 - ngridx / 2, j + 0.5 - ngridy / 2, k + 0.5 - nz / 2).
+//
+// Filtered rows are kept as [projection][row][column] for the window of
+// detector rows [f0, f0 + nbuf) that the current slab of slices reads.
+
+//============================================================================//
+
+// Detector rows [r0, r1) that slices [k0, k1) read, when v = z * m with the
+// magnification m in [lo, hi].
+static void
+fdk_rows(int k0, int k1, int nz, float vcenter, float lo, float hi, int dy,
+         int* r0, int* r1)
+{
+    float z0   = k0 + 0.5f - 0.5f * nz;
+    float z1   = k1 - 0.5f - 0.5f * nz;
+    float vmin = fminf(fminf(z0 * lo, z0 * hi), fminf(z1 * lo, z1 * hi));
+    float vmax = fmaxf(fmaxf(z0 * lo, z0 * hi), fmaxf(z1 * lo, z1 * hi));
+    int   a    = (int) floorf(vmin + vcenter - 0.5f);
+    int   b    = (int) floorf(vmax + vcenter - 0.5f) + 2;
+
+    *r0 = (a < 0) ? 0 : (a > dy) ? dy : a;
+    *r1 = (b < *r0) ? *r0 : (b > dy) ? dy : b;
+}
+
+//============================================================================//
+
+// Cosine-weight and ramp-filter detector rows [r0, r1) of every projection
+// into ``buf``. Two rows share one complex transform, as the real and
+// imaginary parts, since the filter response ``resp`` is real and even.
+static void
+fdk_filter(const float* data, int dt, int dx, float center, float vcenter,
+           float dist, const float* resp, int pd, int r0, int r1,
+           float* buf, int f0, int nbuf, int ncore)
+{
+    int       nrow   = r1 - r0;
+    long long nline  = (long long) dt * nrow;
+    long long nbatch = (nline + 2 * FDK_BATCH - 1) / (2 * FDK_BATCH);
+
+    if(nrow <= 0)
+        return;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float _Complex* cbuf = fft_malloc_c((size_t) pd * FDK_BATCH);
+        fft_plan*       fwd  = fft_plan_1d(pd, FDK_BATCH, FFT_FORWARD);
+        fft_plan*       bwd  = fft_plan_1d(pd, FDK_BATCH, FFT_BACKWARD);
+        long long       b, l;
+        int             j, h, m, d, p, r;
+
+#pragma omp for schedule(dynamic)
+        for(b = 0; b < nbatch; b++)
+        {
+            for(j = 0; j < FDK_BATCH; j++)
+            {
+                float* line = (float*) (cbuf + (size_t) j * pd);
+                for(m = 0; m < 2 * pd; m++)
+                    line[m] = 0.0f;
+                for(h = 0; h < 2; h++)
+                {
+                    l = 2 * (b * FDK_BATCH + j) + h;
+                    if(l >= nline)
+                        break;
+                    p = l / nrow;
+                    r = r0 + l % nrow;
+                    {
+                        const float* src = data + ((size_t) r * dt + p) * dx;
+                        float        v   = r + 0.5f - vcenter;
+                        for(d = 0; d < dx; d++)
+                        {
+                            float u = d + 0.5f - center;
+                            line[2 * d + h] =
+                                src[d] * dist /
+                                sqrtf(dist * dist + u * u + v * v);
+                        }
+                    }
+                }
+            }
+
+            fft_execute(fwd, cbuf);
+            for(j = 0; j < FDK_BATCH; j++)
+            {
+                float _Complex* line = cbuf + (size_t) j * pd;
+                for(m = 0; m < pd; m++)
+                    line[m] *= resp[m];
+            }
+            fft_execute(bwd, cbuf);
+
+            for(j = 0; j < FDK_BATCH; j++)
+            {
+                const float* line = (const float*) (cbuf + (size_t) j * pd);
+                for(h = 0; h < 2; h++)
+                {
+                    l = 2 * (b * FDK_BATCH + j) + h;
+                    if(l >= nline)
+                        break;
+                    p = l / nrow;
+                    r = r0 + l % nrow;
+                    {
+                        float* dst =
+                            buf + ((size_t) p * nbuf + (r - f0)) * dx;
+                        for(d = 0; d < dx; d++)
+                            dst[d] = line[2 * d + h];
+                    }
+                }
+            }
+        }
+
+        fft_destroy(fwd);
+        fft_destroy(bwd);
+        fft_free(cbuf);
+    }
+}
+
+//============================================================================//
+
+// Voxel-driven backprojection of slices [k0, k1) from the nrow filtered
+// rows starting at detector row f0. Each thread owns whole x-rows of the
+// slab; the detector coordinates of a row of voxels are set up once per
+// projection and reused by every slice.
+static void
+fdk_backproject(const float* buf, int f0, int nrow, int nbuf, int dt, int dx,
+                float center, float vcenter, const float* sine,
+                const float* cose, float dist, float* recon, int k0, int k1,
+                int nz, int ngridx, int ngridy, int ncore)
+{
+    const float scale = M_PI / dt;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float* col = (float*) malloc(ngridy * sizeof(float));
+        float* mag = (float*) malloc(ngridy * sizeof(float));
+        float* wgt = (float*) malloc(ngridy * sizeof(float));
+        int    i, j, k, p;
+
+        assert(col != NULL && mag != NULL && wgt != NULL);
+
+#pragma omp for schedule(dynamic)
+        for(i = 0; i < ngridx; i++)
+        {
+            float x = i + 0.5f - 0.5f * ngridx;
+
+            for(p = 0; p < dt; p++)
+            {
+                const float* proj = buf + (size_t) p * nbuf * dx;
+
+#pragma omp simd
+                for(j = 0; j < ngridy; j++)
+                {
+                    float y = j + 0.5f - 0.5f * ngridy;
+                    float t = x * cose[p] + y * sine[p];
+                    float m = dist / (dist + t);
+                    mag[j]  = m;
+                    col[j]  = (y * cose[p] - x * sine[p]) * m + center - 0.5f;
+                    wgt[j]  = m * m * scale;
+                }
+
+                for(k = k0; k < k1; k++)
+                {
+                    float  z   = k + 0.5f - 0.5f * nz;
+                    float* out = recon + ((size_t) k * ngridx + i) * ngridy;
+
+                    for(j = 0; j < ngridy; j++)
+                    {
+                        float fr = z * mag[j] + vcenter - 0.5f - f0;
+                        int   r  = (int) floorf(fr);
+                        int   d  = (int) floorf(col[j]);
+                        float wr = fr - r;
+                        float wd = col[j] - d;
+                        float val = 0.0f;
+
+                        if(d < -1 || d >= dx || r < -1 || r >= nrow)
+                            continue;
+                        if(r >= 0)
+                        {
+                            const float* row = proj + (size_t) r * dx;
+                            if(d >= 0)
+                                val += (1.0f - wr) * (1.0f - wd) * row[d];
+                            if(d + 1 < dx)
+                                val += (1.0f - wr) * wd * row[d + 1];
+                        }
+                        if(r + 1 < nrow)
+                        {
+                            const float* row = proj + (size_t)(r + 1) * dx;
+                            if(d >= 0)
+                                val += wr * (1.0f - wd) * row[d];
+                            if(d + 1 < dx)
+                                val += wr * wd * row[d + 1];
+                        }
+                        out[j] += wgt[j] * val;
+                    }
+                }
+            }
+        }
+
+        free(col);
+        free(mag);
+        free(wgt);
+    }
+}
+
+//============================================================================//
+
+// FDK reconstruction of sinogram-ordered (dy, dt, dx) cone-beam data into
+// an (nz, ngridx, ngridy) volume. Slices are reconstructed in slabs of
+// ``nchunk`` (bounded by memory when <= 0); each slab filters only the
+// detector rows it reads beyond those already filtered for the previous
+// one. The ramp filter is windowed by the gridrec filter ``fname``.
+void
+fdk(const float* data, int dy, int dt, int dx, float center, float vcenter,
+    const float* theta, float dist, float* recon, int nz, int ngridx,
+    int ngridy, const char* fname, const float* filter_par, int ncore,
+    int nchunk)
+{
+    float (*const filter)(float, int, int, int, const float*) =
+        get_filter(fname);
+    float rad = 0.5f * sqrtf((float) ngridx * ngridx + (float) ngridy * ngridy);
+    float lo  = dist / (dist + rad);
+    float hi  = (dist > rad) ? dist / (dist - rad) : (float) (dy + nz);
+    int   nslab, nbuf, pd, k0, k1, r0, r1, f0, f1, m;
+    float *resp, *buf, *sine, *cose;
+
+    // Zero-pad rows to twice their length to avoid wrap-around
+    for(pd = 16; pd < 2 * dx; pd *= 2)
+        ;
+
+    if(nchunk > 0)
+    {
+        nslab = (nchunk < nz) ? nchunk : nz;
+    }
+    else
+    {
+        // Bound the filtered rows by 256 MB
+        size_t rows = ((size_t) 256 << 20) / ((size_t) dt * dx * sizeof(float));
+        nslab       = (rows > 2) ? (int) ((rows - 2) / hi) : 1;
+        nslab       = (nslab < 1) ? 1 : (nslab > nz) ? nz : nslab;
+    }
+    for(k0 = 0, nbuf = 1; k0 < nz; k0 += nslab)
+    {
+        k1 = (k0 + nslab < nz) ? k0 + nslab : nz;
+        fdk_rows(k0, k1, nz, vcenter, lo, hi, dy, &r0, &r1);
+        nbuf = (r1 - r0 > nbuf) ? r1 - r0 : nbuf;
+    }
+
+    resp = (float*) malloc(pd * sizeof(float));
+    buf  = (float*) malloc((size_t) dt * nbuf * dx * sizeof(float));
+    sine = (float*) malloc(dt * sizeof(float));
+    cose = (float*) malloc(dt * sizeof(float));
+    assert(resp != NULL && buf != NULL && sine != NULL && cose != NULL);
+
+    // Windowed ramp |f| in cycles per pixel; gridrec filters are |2x|
+    // windows. The inverse transform normalization is folded in.
+    for(m = 0; m < pd; m++)
+    {
+        int k   = (m <= pd / 2) ? m : pd - m;
+        resp[m] = 0.5f * filter((float) k / pd, k, 0, pd / 2, filter_par) / pd;
+    }
+    for(m = 0; m < dt; m++)
+    {
+        sine[m] = sinf(theta[m]);
+        cose[m] = cosf(theta[m]);
+    }
+
+    for(k0 = 0, f0 = f1 = 0; k0 < nz; k0 = k1)
+    {
+        PROFILE_START(t_slab);
+        k1 = (k0 + nslab < nz) ? k0 + nslab : nz;
+        fdk_rows(k0, k1, nz, vcenter, lo, hi, dy, &r0, &r1);
+
+        // Keep the filtered rows shared with the previous slab
+        if(r0 < f1 && r0 > f0)
+        {
+            for(m = 0; m < dt; m++)
+                memmove(buf + (size_t) m * nbuf * dx,
+                        buf + ((size_t) m * nbuf + (r0 - f0)) * dx,
+                        (size_t)(f1 - r0) * dx * sizeof(float));
+        }
+        else if(r0 >= f1)
+        {
+            f1 = r0;
+        }
+        f0 = r0;
+        fdk_filter(data, dt, dx, center, vcenter, dist, resp, pd, f1, r1, buf,
+                   f0, nbuf, ncore);
+        PROFILE_STOP(t_slab, "fdk.filter",
+                     (size_t) dt * (r1 - f1) * dx * sizeof(float));
+        f1 = r1;
+
+        PROFILE_RESTART(t_slab);
+        fdk_backproject(buf, f0, r1 - f0, nbuf, dt, dx, center, vcenter, sine,
+                        cose, dist, recon, k0, k1, nz, ngridx, ngridy, ncore);
+        PROFILE_STOP(t_slab, "fdk.backproject",
+                     (size_t)(k1 - k0) * ngridx * ngridy * sizeof(float));
+    }
+
+    free(resp);
+    free(buf);
+    free(sine);
+    free(cose);
+}
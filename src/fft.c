@@ -0,0 +1,233 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fft.h"
+#ifdef USE_MKL
+#    include "mkl.h"
+#else
+#    include <fftw3.h>
+#    include <pthread.h>
+static pthread_mutex_t planner_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+struct fft_plan_s
+{
+    int sign;
+    int real;
+#ifdef USE_MKL
+    DFTI_DESCRIPTOR_HANDLE handle;
+#else
+    fftwf_plan handle;
+#endif
+};
+
+//============================================================================//
+
+void
+fft_planner_lock(void)
+{
+#ifndef USE_MKL
+    pthread_mutex_lock(&planner_lock);
+#endif
+}
+
+//============================================================================//
+
+void
+fft_planner_unlock(void)
+{
+#ifndef USE_MKL
+    pthread_mutex_unlock(&planner_lock);
+#endif
+}
+
+//============================================================================//
+
+fft_plan*
+fft_plan_1d(int n, int howmany, int sign)
+{
+    fft_plan* plan = (fft_plan*) malloc(sizeof(fft_plan));
+    plan->sign     = sign;
+    plan->real     = 0;
+#ifdef USE_MKL
+    DftiCreateDescriptor(&plan->handle, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                         (MKL_LONG) n);
+    DftiSetValue(plan->handle, DFTI_NUMBER_OF_TRANSFORMS, (MKL_LONG) howmany);
+    DftiSetValue(plan->handle, DFTI_INPUT_DISTANCE, (MKL_LONG) n);
+    DftiSetValue(plan->handle, DFTI_OUTPUT_DISTANCE, (MKL_LONG) n);
+    // Callers parallelize over slices, so each transform runs sequentially
+    DftiSetValue(plan->handle, DFTI_THREAD_LIMIT, 1);
+    DftiCommitDescriptor(plan->handle);
+#else
+    // Plan on scratch memory so that planning never touches caller data
+    float _Complex* scratch = fft_malloc_c((size_t) n * howmany);
+    fft_planner_lock();
+    plan->handle = fftwf_plan_many_dft(1, &n, howmany, scratch, NULL, 1, n,
+                                       scratch, NULL, 1, n, sign,
+                                       FFTW_ESTIMATE);
+    fft_planner_unlock();
+    fft_free(scratch);
+#endif
+    return plan;
+}
+
+//============================================================================//
+
+fft_plan*
+fft_plan_2d(int n0, int n1, int sign)
+{
+    fft_plan* plan = (fft_plan*) malloc(sizeof(fft_plan));
+    plan->sign     = sign;
+    plan->real     = 0;
+#ifdef USE_MKL
+    MKL_LONG length[2] = { (MKL_LONG) n0, (MKL_LONG) n1 };
+    DftiCreateDescriptor(&plan->handle, DFTI_SINGLE, DFTI_COMPLEX, 2, length);
+    DftiSetValue(plan->handle, DFTI_THREAD_LIMIT, 1);
+    DftiCommitDescriptor(plan->handle);
+#else
+    float _Complex* scratch = fft_malloc_c((size_t) n0 * n1);
+    fft_planner_lock();
+    plan->handle =
+        fftwf_plan_dft_2d(n0, n1, scratch, scratch, sign, FFTW_ESTIMATE);
+    fft_planner_unlock();
+    fft_free(scratch);
+#endif
+    return plan;
+}
+
+//============================================================================//
+
+fft_plan*
+fft_plan_2d_real(int n0, int n1, int sign)
+{
+    fft_plan* plan = (fft_plan*) malloc(sizeof(fft_plan));
+    plan->sign     = sign;
+    plan->real     = 1;
+#ifdef USE_MKL
+    MKL_LONG length[2]  = { (MKL_LONG) n0, (MKL_LONG) n1 };
+    MKL_LONG rstride[3] = { 0, 2 * (n1 / 2 + 1), 1 };
+    MKL_LONG cstride[3] = { 0, n1 / 2 + 1, 1 };
+    DftiCreateDescriptor(&plan->handle, DFTI_SINGLE, DFTI_REAL, 2, length);
+    DftiSetValue(plan->handle, DFTI_CONJUGATE_EVEN_STORAGE,
+                 DFTI_COMPLEX_COMPLEX);
+    DftiSetValue(plan->handle, DFTI_INPUT_STRIDES,
+                 (sign == FFT_FORWARD) ? rstride : cstride);
+    DftiSetValue(plan->handle, DFTI_OUTPUT_STRIDES,
+                 (sign == FFT_FORWARD) ? cstride : rstride);
+    DftiSetValue(plan->handle, DFTI_THREAD_LIMIT, 1);
+    DftiCommitDescriptor(plan->handle);
+#else
+    float _Complex* scratch = fft_malloc_c((size_t) n0 * (n1 / 2 + 1));
+    fft_planner_lock();
+    if(sign == FFT_FORWARD)
+        plan->handle = fftwf_plan_dft_r2c_2d(n0, n1, (float*) scratch,
+                                             scratch, FFTW_ESTIMATE);
+    else
+        plan->handle = fftwf_plan_dft_c2r_2d(n0, n1, scratch,
+                                             (float*) scratch, FFTW_ESTIMATE);
+    fft_planner_unlock();
+    fft_free(scratch);
+#endif
+    return plan;
+}
+
+//============================================================================//
+
+void
+fft_execute(const fft_plan* plan, float _Complex* data)
+{
+#ifdef USE_MKL
+    if(plan->sign == FFT_FORWARD)
+        DftiComputeForward(plan->handle, data);
+    else
+        DftiComputeBackward(plan->handle, data);
+#else
+    if(!plan->real)
+        fftwf_execute_dft(plan->handle, data, data);
+    else if(plan->sign == FFT_FORWARD)
+        fftwf_execute_dft_r2c(plan->handle, (float*) data, data);
+    else
+        fftwf_execute_dft_c2r(plan->handle, data, (float*) data);
+#endif
+}
+
+//============================================================================//
+
+void
+fft_destroy(fft_plan* plan)
+{
+    if(plan == NULL)
+        return;
+#ifdef USE_MKL
+    DftiFreeDescriptor(&plan->handle);
+#else
+    fft_planner_lock();
+    fftwf_destroy_plan(plan->handle);
+    fft_planner_unlock();
+#endif
+    free(plan);
+}
+
+//============================================================================//
+
+float _Complex*
+fft_malloc_c(size_t n)
+{
+#ifdef USE_MKL
+    return (float _Complex*) mkl_malloc(n * sizeof(float _Complex), 64);
+#else
+    return fftwf_alloc_complex(n);
+#endif
+}
+
+//============================================================================//
+
+void
+fft_free(void* v)
+{
+#ifdef USE_MKL
+    mkl_free(v);
+#else
+    fftwf_free(v);
+#endif
+}
@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -122,6 +123,7 @@ grad(const float* data, int dy, int dt, int dx, const float* center,
             // initialize sum_dist and update to zero
             memset(sum_dist, 0, (ngridx * ngridy) * sizeof(float));
 
+            PROFILE_START(t_slice);
             // For each projection angle
             for(p = 0; p < dt; p++)
             {
@@ -180,9 +182,12 @@ grad(const float* data, int dy, int dt, int dx, const float* center,
                                 2 * r * prox1[ind_data] * dist[n];
                 }
             }
+            PROFILE_STOP(t_slice, "grad.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
         }
 
         // compute the gradient step
+        PROFILE_START(t_step);
         for(s = 0; s < dy; s++)
         {
             if(reg_pars[0] < 0)
@@ -226,6 +231,8 @@ grad(const float* data, int dy, int dt, int dx, const float* center,
                     recon[ind_recon + iy * ngridx + ix] -=
                         lambda[s] * grad[ind_recon + iy * ngridx + ix];
         }
+        PROFILE_STOP(t_step, "grad.update",
+                     sizeof(float) * (size_t) dy * ngridx * ngridy * 6);
     }
 
     // scale result
@@ -52,7 +52,10 @@
 // Use X/Open-7, where posix_memalign is introduced
 #define _XOPEN_SOURCE 700
 
+#include "fft.h"
 #include "gridrec.h"
+#include "profile.h"
+#include "utils.h"
 #ifdef USE_MKL
 #    include "mkl.h"
 #else
@@ -61,10 +64,6 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
-#ifndef USE_MKL
-#    include <pthread.h>
-pthread_mutex_t lock;
-#endif
 
 #ifndef M_PI
 #    define M_PI 3.14159265359
@@ -88,10 +87,42 @@ pthread_mutex_t lock;
 #    define __ASSSUME_64BYTES_ALIGNED(x)
 #endif
 
-void
-gridrec(const float* data, int dy, int dt, int dx, const float* center,
-        const float* theta, float* recon, int ngridx, int ngridy,
-        const char* fname, const float* filter_par)
+// Fill sino[dx, pdim) after a row loaded from ``a`` (real part) and ``b``
+// (imaginary part, or NULL): ``npad`` samples past each edge of the row are
+// synthesized with a PAD_* ``mode`` of utils.h, zeros fill the rest. The
+// FFT is circular, so the left padding goes at the end of the row.
+static inline void
+pad_sino_row(float _Complex* sino, const float* a, const float* b, int dx,
+             int pdim, int npad, int mode)
+{
+    int j;
+
+    memset(sino + dx, 0, (pdim - dx) * sizeof(float _Complex));
+    if(mode == PAD_CONSTANT)
+        return;
+    for(j = 0; j < npad; j++)
+    {
+        int r = pad_index(dx + j, dx, mode);
+        int l = pad_index(-1 - j, dx, mode);
+        sino[dx + j]       = a[r] + I * ((b) ? b[r] : 0.0f);
+        sino[pdim - 1 - j] = a[l] + I * ((b) ? b[l] : 0.0f);
+    }
+}
+
+// Raw uint16 sinograms are converted one slice pair at a time into
+// ``slab`` by convert_raw_sinogram, float sinograms are read in place.
+//
+// With ``sweep`` set, ``data`` holds a single (dt, dx) sinogram that is
+// reconstructed once per center, so ``dy`` is the number of centers. The
+// projections are transformed once and each pair of centers shares a
+// gridding pass: their filter-phase tables go into the real and imaginary
+// parts of the combined tables.
+static void
+gridrec_impl(const float* data, const uint16_t* raw, const float* flat,
+             const float* dark, int dy, int dt, int dx, const float* center,
+             const float* theta, float* recon, int ngridx, int ngridy,
+             const char* fname, const float* filter_par, int npad,
+             int pad_mode, int sweep)
 {
     int    s, p, iu, iv;
     int    j;
@@ -112,10 +143,16 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
     const int          ltbl   = 512;
     int                pdim;
     float _Complex *   sino, *filphase, *filphase_iter, **H;
+    float _Complex *   filphase2, *filphase2_iter;
+    int                nphase;
     float _Complex **  U_d, **V_d;
     float *            J_z, *P_z;
+    float*             slab = NULL;
+    PROFILE_START(t_setup);
 #ifndef USE_MKL
-    pthread_mutex_lock(&lock);  // acquire global lock for set-up
+    fft_planner_lock();  // acquire global lock for set-up
+    PROFILE_STOP(t_setup, "gridrec.lock", 0);
+    PROFILE_RESTART(t_setup);
 #endif
 
     const float coefs[11] = { 0.5767616E+02,  -0.8931343E+02, 0.4167596E+02,
@@ -123,8 +160,8 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
                               0.1372983E-01,  -0.7963169E-03, 0.3593372E-04,
                               -0.1295941E-05, 0.3817796E-07 };
 
-    // Compute pdim = next power of 2 >= dx
-    for(pdim = 16; pdim < dx; pdim *= 2)
+    // Compute pdim = next power of 2 >= dx + 2 * npad
+    for(pdim = 16; pdim < dx + 2 * npad; pdim *= 2)
         ;
 
     const int pdim2 = pdim >> 1;
@@ -135,20 +172,17 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
 
     // Allocate storage for various arrays.
 #ifdef USE_MKL
-    sino = malloc_vector_c(pdim);
+    sino = malloc_vector_c(sweep ? pdim * dt : pdim);
 #else
     sino = malloc_vector_c(pdim * dt);
 #endif
-    if(!filter2d)
-    {
-        filphase      = malloc_vector_c(pdim2);
-        filphase_iter = filphase;
-    }
-    else
-    {
-        filphase = malloc_vector_c(dt * (pdim2));
-    }
+    nphase         = filter2d ? dt * pdim2 : pdim2;
+    filphase       = malloc_vector_c(nphase);
+    filphase2      = malloc_vector_c(nphase);
+    filphase_iter  = filphase;
+    filphase2_iter = filphase2;
     __ASSSUME_64BYTES_ALIGNED(filphase);
+    __ASSSUME_64BYTES_ALIGNED(filphase2);
     H = malloc_matrix_c(pdim, pdim);
     __ASSSUME_64BYTES_ALIGNED(H);
     wtbl = malloc_vector_f(ltbl + 1);
@@ -182,6 +216,8 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
 
     // Set up PSWF lookup tables.
     set_pswf_tables(C, nt, lambda, coefs, ltbl, M02, wtbl, winv);
+    PROFILE_STOP(t_setup, "gridrec.setup", sizeof(float) * (ltbl + pdim));
+    PROFILE_RESTART(t_setup);
 
 #ifdef USE_MKL
     DFTI_DESCRIPTOR_HANDLE reverse_1d;
@@ -208,8 +244,10 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
                                           1, pdim, FFTW_BACKWARD, FFTW_MEASURE);
     forward_2d =
         fftwf_plan_dft_2d(pdim, pdim, H[0], H[0], FFTW_FORWARD, FFTW_MEASURE);
-    pthread_mutex_unlock(&lock);  // release global lock
+    fft_planner_unlock();  // release global lock
 #endif
+    PROFILE_STOP(t_setup, "gridrec.plan", 0);
+    PROFILE_RESTART(t_setup);
 
     for(p = 0; p < dt; p++)
     {
@@ -304,12 +342,79 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
         }
     }
 #endif
+    // In sweep mode the single sinogram is transformed up front, with a zero
+    // imaginary part, and shared by every slice pair below.
+    if(sweep)
+    {
+        for(p = 0; p < dt; p++)
+        {
+            float _Complex* sino_p = sino + (size_t) p * pdim;
+
+            for(j = 0; j < dx; j++)
+                sino_p[j] = data[j + (size_t) p * dx];
+            pad_sino_row(sino_p, data + (size_t) p * dx, NULL, dx, pdim, npad,
+                         pad_mode);
+#ifdef USE_MKL
+            DftiComputeBackward(reverse_1d, sino_p);
+#endif
+        }
+#ifndef USE_MKL
+        fftwf_execute(reverse_1d_many);
+#endif
+    }
+
     // For each slice.
+    if(raw)
+        slab = malloc_vector_f(2 * (size_t) dt * dx);
+    PROFILE_STOP(t_setup, "gridrec.tables",
+                 2 * sizeof(float _Complex) * (size_t) dt * pdim);
+
     for(s = 0; s < dy; s += 2)
     {
-        // Set up table of combined filter-phase factors.
+        PROFILE_START(t_slice);
+        // Sinograms of this slice pair, converted from raw data if needed
+        const float* sdata;
+        if(sweep)
+        {
+            sdata = NULL;
+        }
+        else if(raw)
+        {
+            convert_raw_sinogram(raw, flat, dark, s, dt, dx, slab);
+            if((s + 1) < dy)
+                convert_raw_sinogram(raw, flat, dark, s + 1, dt, dx,
+                                     slab + (size_t) dt * dx);
+            sdata = slab;
+        }
+        else
+        {
+            sdata = data + (size_t) s * dt * dx;
+        }
+
+        // Set up table of combined filter-phase factors. filphase2 is
+        // applied to the negative frequencies.
         set_filter_tables(dt, pdim, center[s], filter, filter_par, filphase,
                           filter2d);
+        if(sweep)
+        {
+            set_filter_tables(dt, pdim, center[((s + 1) < dy) ? s + 1 : s],
+                              filter, filter_par, filphase2, filter2d);
+            for(j = 0; j < nphase; j++)
+            {
+                const float _Complex a = filphase[j], b = filphase2[j];
+                filphase[j]            = a + I * b;
+                filphase2[j]           = conjf(a) + I * conjf(b);
+            }
+        }
+        else
+        {
+            for(j = 0; j < nphase; j++)
+                filphase2[j] = conjf(filphase[j]);
+        }
+
+        PROFILE_STOP(t_slice, "gridrec.filter",
+                     2 * sizeof(float) * (size_t) dt * dx);
+        PROFILE_RESTART(t_slice);
 
         // First clear the array H
         memset(H[0], 0, pdim * pdim * sizeof(H[0][0]));
@@ -319,7 +424,8 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
         //     1. Copy the real projection data from the two slices into the
         //      real and imaginary parts of the first dx elements of the
         //      complex array, sino[].  Set the remaining pdim-dx elements
-        //      to zero (zero-padding).
+        //      to zero (zero-padding), after the npad samples synthesized
+        //      past each edge in edge or reflect mode.
 
         //     2. Carry out a (1D) Fourier transform on the complex data.
         //      This results in transform data that is arranged in
@@ -364,38 +470,47 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
         for(p = 0; p < dt; p++)
         {
             float              sine_p = sine[p], cose_p = cose[p];
-            const unsigned int j0 = dx * (p + s * dt), delta_index = dx * dt;
+            const unsigned int j0 = dx * p, delta_index = dx * dt;
+            float _Complex*    sino_p = sino;
 
-            __PRAGMA_SIMD_VECREMAINDER
-            for(j = 0; j < dx; j++)
+            if(sweep)
             {
-                // Add data from both slices
-                float              second_sino = 0.0;
-                const unsigned int index       = j + j0;
-                if(__LIKELY((s + 1) < dy))
+                sino_p = sino + (size_t) p * pdim;
+            }
+            else
+            {
+                __PRAGMA_SIMD_VECREMAINDER
+                for(j = 0; j < dx; j++)
                 {
-                    second_sino = data[index + delta_index];
+                    // Add data from both slices
+                    float              second_sino = 0.0;
+                    const unsigned int index       = j + j0;
+                    if(__LIKELY((s + 1) < dy))
+                    {
+                        second_sino = sdata[index + delta_index];
+                    }
+                    sino[j] = sdata[index] + I * second_sino;
                 }
-                sino[j] = data[index] + I * second_sino;
-            }
 
-            __PRAGMA_SIMD_VECREMAINDER
-            for(j = dx; j < pdim; j++)
-            {
-                // Zero fill the rest of the array
-                sino[j] = 0.0;
-            }
+                // Pad the rest of the array
+                pad_sino_row(sino, sdata + j0,
+                             ((s + 1) < dy) ? sdata + j0 + delta_index : NULL,
+                             dx, pdim, npad, pad_mode);
 
-            DftiComputeBackward(reverse_1d, sino);
+                DftiComputeBackward(reverse_1d, sino);
+            }
 
             if(filter2d)
-                filphase_iter = filphase + pdim2 * p;
+            {
+                filphase_iter  = filphase + pdim2 * p;
+                filphase2_iter = filphase2 + pdim2 * p;
+            }
 
             // For each FFT(projection)
             for(j = 1; j < pdim2; j++)
             {
-                Cdata1 = filphase_iter[j] * sino[j];
-                Cdata2 = conjf(filphase_iter[j]) * sino[pdim - j];
+                Cdata1 = filphase_iter[j] * sino_p[j];
+                Cdata2 = filphase2_iter[j] * sino_p[pdim - j];
 
                 U = j * cose_p + M2;
                 V = j * sine_p + M2;
@@ -444,36 +559,40 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
 
 #else
         int zlimit = z;
-        // For each projection
-        for(p = 0; p < dt; p++)
+        // Projections are transformed up front in sweep mode.
+        if(!sweep)
         {
-            const unsigned int j0 = dx * (p + s * dt), delta_index = dx * dt;
-
-            __PRAGMA_SIMD_VECREMAINDER
-            for(j = 0; j < dx; j++)
+            // For each projection
+            for(p = 0; p < dt; p++)
             {
-                // Add data from both slices
-                float              second_sino = 0.0;
-                const unsigned int index       = j + j0;
-                if(__LIKELY((s + 1) < dy))
+                const unsigned int j0 = dx * p, delta_index = dx * dt;
+
+                __PRAGMA_SIMD_VECREMAINDER
+                for(j = 0; j < dx; j++)
                 {
-                    second_sino = data[index + delta_index];
+                    // Add data from both slices
+                    float              second_sino = 0.0;
+                    const unsigned int index       = j + j0;
+                    if(__LIKELY((s + 1) < dy))
+                    {
+                        second_sino = sdata[index + delta_index];
+                    }
+                    // sino[j] = data[index] + I*second_sino;
+                    sino[j + (p * pdim)] = sdata[index] + I * second_sino;
                 }
-                // sino[j] = data[index] + I*second_sino;
-                sino[j + (p * pdim)] = data[index] + I * second_sino;
-            }
 
-            __PRAGMA_SIMD_VECREMAINDER
-            for(j = dx; j < pdim; j++)
-            {
-                // Zero fill the rest of the array
-                // sino[j] = 0.0;
-                sino[j + (p * pdim)] = 0.0;
+                // Pad the rest of the array
+                pad_sino_row(sino + (size_t) p * pdim, sdata + j0,
+                             ((s + 1) < dy) ? sdata + j0 + delta_index : NULL,
+                             dx, pdim, npad, pad_mode);
             }
+            // Take FFT of the projection array
+            // fftwf_execute(reverse_1d);
+            fftwf_execute(reverse_1d_many);
         }
-        // Take FFT of the projection array
-        // fftwf_execute(reverse_1d);
-        fftwf_execute(reverse_1d_many);
+        PROFILE_STOP(t_slice, "gridrec.fft1d",
+                     sizeof(float _Complex) * (size_t) dt * pdim);
+        PROFILE_RESTART(t_slice);
 
         // Use re-ordered p,j,U,V from cache-blocking calculations
         // For each FFT(projection)
@@ -485,10 +604,13 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
             V = V_d[p][j];
 
             if(filter2d)
-                filphase_iter = filphase + pdim2 * p;
+            {
+                filphase_iter  = filphase + pdim2 * p;
+                filphase2_iter = filphase2 + pdim2 * p;
+            }
 
             Cdata1 = filphase_iter[j] * sino[j + (p * pdim)];
-            Cdata2 = conjf(filphase_iter[j]) * sino[pdim - j + (p * pdim)];
+            Cdata2 = filphase2_iter[j] * sino[pdim - j + (p * pdim)];
 
             // Note freq space origin is at (M2,M2), but we
             // offset the indices U, V, etc. to range from 0 to M-1.
@@ -517,6 +639,12 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
             }
         }
 #endif
+        // With MKL, gridrec.grid includes the 1D FFT of each projection.
+        PROFILE_STOP(t_slice, "gridrec.grid",
+                     sizeof(float _Complex) * (size_t) dt * pdim2 * (L + 1) *
+                         (L + 1));
+        PROFILE_RESTART(t_slice);
+
         // Carry out a 2D inverse FFT on the array H.
 
         // At the conclusion of this phase, the configuration
@@ -532,6 +660,9 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
 #else
         fftwf_execute(forward_2d);
 #endif
+        PROFILE_STOP(t_slice, "gridrec.fft2d",
+                     sizeof(float _Complex) * (size_t) pdim * pdim);
+        PROFILE_RESTART(t_slice);
 
         // Copy the real and imaginary parts of the complex data from H[][],
         // into the output buffers for the two reconstructed real images,
@@ -614,13 +745,18 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
                 ufin   = ngridy - offsety;
             }
         }
+        PROFILE_STOP(t_slice, "gridrec.pswf",
+                     2 * sizeof(float) * (size_t) ngridx * ngridy);
     }
 
+    if(slab)
+        free_vector_f(slab);
     free_vector_f(sine);
     free_vector_f(cose);
     free_vector_c(sino);
     free_vector_f(wtbl);
     free_vector_c(filphase);
+    free_vector_c(filphase2);
     free_vector_f(winv);
 #ifdef USE_MKL
     free_vector_f(work);
@@ -644,6 +780,34 @@ gridrec(const float* data, int dy, int dt, int dx, const float* center,
     return;
 }
 
+void
+gridrec(const float* data, int dy, int dt, int dx, const float* center,
+        const float* theta, float* recon, int ngridx, int ngridy,
+        const char* fname, const float* filter_par, int npad, int pad_mode)
+{
+    gridrec_impl(data, NULL, NULL, NULL, dy, dt, dx, center, theta, recon,
+                 ngridx, ngridy, fname, filter_par, npad, pad_mode, 0);
+}
+
+void
+gridrec_uint16(const uint16_t* data, const float* flat, const float* dark,
+               int dy, int dt, int dx, const float* center, const float* theta,
+               float* recon, int ngridx, int ngridy, const char* fname,
+               const float* filter_par, int npad, int pad_mode)
+{
+    gridrec_impl(NULL, data, flat, dark, dy, dt, dx, center, theta, recon,
+                 ngridx, ngridy, fname, filter_par, npad, pad_mode, 0);
+}
+
+void
+gridrec_sweep(const float* data, int dt, int dx, const float* center,
+              int ncen, const float* theta, float* recon, int ngridx,
+              int ngridy, const char* fname, const float* filter_par)
+{
+    gridrec_impl(data, NULL, NULL, NULL, ncen, dt, dx, center, theta, recon,
+                 ngridx, ngridy, fname, filter_par, 0, PAD_CONSTANT, 1);
+}
+
 void
 set_filter_tables(int dt, int pd, float center,
                   float (*const pf)(float, int, int, int, const float*),
@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -85,6 +86,7 @@ mlem(const float* data, int dy, int dt, int dx, const float* center,
         // For each slice
         for(s = 0; s < dy; s++)
         {
+            PROFILE_START(t_slice);
             preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
                           gridy);  // Outputs: mov, gridx, gridy
 
@@ -154,6 +156,10 @@ mlem(const float* data, int dy, int dt, int dx, const float* center,
                 }
             }
 
+            PROFILE_STOP(t_slice, "mlem.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
+            PROFILE_RESTART(t_slice);
+
             m = 0;
             for(n = 0; n < ngridx * ngridy; n++)
             {
@@ -164,6 +170,8 @@ mlem(const float* data, int dy, int dt, int dx, const float* center,
                 }
                 m++;
             }
+            PROFILE_STOP(t_slice, "mlem.update",
+                         sizeof(float) * (size_t) ngridx * ngridy * 3);
         }
     }
 
@@ -42,167 +42,379 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "morph.h"
-#include "assert.h"
-#include <limits.h>
+#include "affinity.h"
+#include "utils.h"
+#include <string.h>
+
+// Mean or median of each bx * by * bz block of the (dx, dy, dz) input into
+// the (dx / bx, dy / by, dz / bz) output. Trailing input samples that do not
+// fill a whole block are dropped.
+static void
+bin3d(const float* data, int dx, int dy, int dz, int bx, int by, int bz,
+      int median, int ncore, float* out)
+{
+    const int    ox = dx / bx, oy = dy / by, oz = dz / bz;
+    const int    nbin  = bx * by * bz;
+    const float  scale = 1.0f / nbin;
+    const size_t plane = (size_t) dy * dz;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float* window = median ? (float*) malloc(nbin * sizeof(float)) : NULL;
+        int    m, n, k, p, q, r;
+
+#pragma omp for schedule(static)
+        for(m = 0; m < ox; m++)
+        {
+            for(n = 0; n < oy; n++)
+            {
+                float* row = out + ((size_t) m * oy + n) * oz;
+
+                if(median)
+                {
+                    for(k = 0; k < oz; k++)
+                    {
+                        int c = 0;
+                        for(p = 0; p < bx; p++)
+                            for(q = 0; q < by; q++)
+                            {
+                                const float* src =
+                                    data + (size_t)(m * bx + p) * plane +
+                                    (size_t)(n * by + q) * dz + k * bz;
+                                for(r = 0; r < bz; r++)
+                                    window[c++] = src[r];
+                            }
+                        row[k] = select_median(window, nbin);
+                    }
+                    continue;
+                }
+
+                for(k = 0; k < oz; k++)
+                    row[k] = 0.0f;
+                for(p = 0; p < bx; p++)
+                {
+                    for(q = 0; q < by; q++)
+                    {
+                        const float* src = data +
+                                           (size_t)(m * bx + p) * plane +
+                                           (size_t)(n * by + q) * dz;
+                        if(bz == 1)
+                        {
+#pragma omp simd
+                            for(k = 0; k < oz; k++)
+                                row[k] += src[k];
+                        }
+                        else
+                        {
+#pragma omp simd
+                            for(k = 0; k < oz; k++)
+                            {
+                                float sum = 0.0f;
+                                for(r = 0; r < bz; r++)
+                                    sum += src[k * bz + r];
+                                row[k] += sum;
+                            }
+                        }
+                    }
+                }
+#pragma omp simd
+                for(k = 0; k < oz; k++)
+                    row[k] *= scale;
+            }
+        }
+
+        free(window);
+    }
+}
+
+// Replicate every sample of the (dx, dy, dz) input into a bx * by * bz block
+// of the (dx * bx, dy * by, dz * bz) output.
+static void
+unbin3d(const float* data, int dx, int dy, int dz, int bx, int by, int bz,
+        int ncore, float* out)
+{
+    const int    oy = dy * by, oz = dz * bz;
+    const size_t oplane = (size_t) oy * oz;
+    int          m;
+
+#pragma omp parallel for num_threads(get_nthreads(ncore)) schedule(static)
+    for(m = 0; m < dx; m++)
+    {
+        float* first = out + (size_t) m * bx * oplane;
+        int    n, q, k, r, p;
+
+        for(n = 0; n < dy; n++)
+        {
+            const float* src = data + ((size_t) m * dy + n) * dz;
+            float*       row = first + (size_t) n * by * oz;
+
+            for(k = 0; k < dz; k++)
+                for(r = 0; r < bz; r++)
+                    row[k * bz + r] = src[k];
+            for(q = 1; q < by; q++)
+                memcpy(row + (size_t) q * oz, row, oz * sizeof(float));
+        }
+        for(p = 1; p < bx; p++)
+            memcpy(first + p * oplane, first, oplane * sizeof(float));
+    }
+}
+
+//============================================================================//
 
 DLL void
-sample(int mode, const float* data, int dx, int dy, int dz, int level, int axis,
-       float* out)
+sample(int mode, const float* data, int dx, int dy, int dz,
+       const int* factor, int median, int ncore, float* out)
 {
     if(mode == 0)
     {
-        downsample(data, dx, dy, dz, level, axis, out);
+        bin3d(data, dx, dy, dz, factor[0], factor[1], factor[2], median,
+              ncore, out);
     }
 
     else if(mode == 1)
     {
-        upsample(data, dx, dy, dz, level, axis, out);
+        unbin3d(data, dx, dy, dz, factor[0], factor[1], factor[2], ncore,
+                out);
     }
 }
 
-DLL void
-downsample(const float* data, int dx, int dy, int dz, int level, int axis,
-           float* out)
+//============================================================================//
+
+// Rows per tile side: a tile of rows is read and written while it is still
+// in a 256 kB cache.
+static int
+swap_tile(size_t row)
 {
-    unsigned           m, n, p, binsize;
-    unsigned long long i, j, k, ind;
+    int tile = (int) sqrt(262144.0 / (double) row);
+    return (tile < 1) ? 1 : (tile > 64) ? 64 : tile;
+}
 
-    binsize = pow(2, level);
-    // Ensure that largest array is small enough to be indexable
-    assert(ULLONG_MAX / dx / dy / dz > 0);
-    // Ensure safe comparison between unsigned (ijk) and signed (xyz)
-    assert(dx >= 0 && dy >= 0 && dz >= 0);
+//============================================================================//
 
-    if(axis == 0)
+DLL void
+swap_stack(const void* src, void* dst, int n0, int n1, int n2, int elsize,
+           int ncore)
+{
+    size_t row   = (size_t) n2 * elsize;
+    int    tile  = swap_tile(row);
+    int    ntile = (n1 + tile - 1) / tile;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
     {
-        dx /= binsize;
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
+        int t = 0, nt = 1, b, i0, i1, j0, j1;
+#ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+#endif
+        numa_pin(t, nt);
+#pragma omp for schedule(static)
+        for(b = 0; b < ntile; b++)
         {
-            i = m * (dy * dz);
-            for(p = 0; p < binsize; p++)
-            {
-                for(n = 0; n < (unsigned) dy; n++)
-                {
-                    j = n * dz;
-                    for(k = 0; k < (unsigned) dz; k++)
-                    {
-                        out[i + j + k] += data[ind] / binsize;
-                        ind++;
-                    }
-                }
-            }
+            j1 = (b * tile + tile < n1) ? b * tile + tile : n1;
+            for(j0 = 0; j0 < n0; j0 += tile)
+                for(i1 = b * tile; i1 < j1; i1++)
+                    for(i0 = j0; i0 < j0 + tile && i0 < n0; i0++)
+                        memcpy((char*) dst + ((size_t) i1 * n0 + i0) * row,
+                               (const char*) src +
+                                   ((size_t) i0 * n1 + i1) * row,
+                               row);
         }
+        numa_unpin();
     }
-    else if(axis == 1)
+}
+
+//============================================================================//
+
+#define SWAP_BATCH 4096
+
+// Row q of the swapped stack is row (q * n1) mod (n - 1) of the original,
+// for all but the first and last of the n rows, which stay in place.
+static void
+swap_cycle(char* data, size_t leader, size_t n1, size_t n, size_t row,
+           char* buf)
+{
+    size_t q = leader, p;
+    memcpy(buf, data + leader * row, row);
+    for(;;)
     {
-        dy /= binsize;
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
-        {
-            i = m * (dy * dz);
-            for(n = 0; n < (unsigned) dy; n++)
-            {
-                j = n * dz;
-                for(p = 0; p < binsize; p++)
-                {
-                    for(k = 0; k < (unsigned) dz; k++)
-                    {
-                        out[i + j + k] += data[ind] / binsize;
-                        ind++;
-                    }
-                }
-            }
-        }
+        p = (q * n1) % (n - 1);
+        if(p == leader)
+            break;
+        memcpy(data + q * row, data + p * row, row);
+        q = p;
     }
-    else if(axis == 2)
+    memcpy(data + q * row, buf, row);
+}
+
+//============================================================================//
+
+DLL void
+swap_stack_inplace(void* data, int n0, int n1, int n2, int elsize, int ncore)
+{
+    size_t         n   = (size_t) n0 * n1;
+    size_t         row = (size_t) n2 * elsize;
+    size_t         k, q, len;
+    size_t*        lead;
+    unsigned char* seen;
+    int            nlead;
+
+    if(n0 <= 1 || n1 <= 1)
+        return;
+
+    seen = (unsigned char*) calloc((n + 7) / 8, 1);
+    lead = (size_t*) malloc(SWAP_BATCH * sizeof(size_t));
+
+    // Find a batch of cycles serially, then move their rows in parallel.
+    for(k = 1; k < n - 1;)
     {
-        dz /= binsize;
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
+        for(nlead = 0; k < n - 1 && nlead < SWAP_BATCH; k++)
         {
-            i = m * (dy * dz);
-            for(n = 0; n < (unsigned) dy; n++)
+            if(seen[k / 8] & (1 << (k % 8)))
+                continue;
+            len = 0;
+            q   = k;
+            do
             {
-                j = n * dz;
-                for(k = 0; k < (unsigned) dz; k++)
-                {
-                    for(p = 0; p < binsize; p++)
-                    {
-                        out[i + j + k] += data[ind] / binsize;
-                        ind++;
-                    }
-                }
-            }
+                seen[q / 8] |= (unsigned char) (1 << (q % 8));
+                q = (q * n1) % (n - 1);
+                len++;
+            } while(q != k);
+            if(len > 1)
+                lead[nlead++] = k;
+        }
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+        {
+            char* buf = (char*) malloc(row);
+            int   i;
+#pragma omp for schedule(dynamic, 16)
+            for(i = 0; i < nlead; i++)
+                swap_cycle((char*) data, lead[i], n1, n, row, buf);
+            free(buf);
         }
     }
+
+    free(seen);
+    free(lead);
 }
 
+//============================================================================//
+
+DLL void
+downsample(const float* data, int dx, int dy, int dz, int level, int axis,
+           float* out)
+{
+    int factor[3] = { 1, 1, 1 };
+    factor[axis]  = 1 << level;
+    sample(0, data, dx, dy, dz, factor, 0, 0, out);
+}
+
+//============================================================================//
+
 DLL void
 upsample(const float* data, int dx, int dy, int dz, int level, int axis,
          float* out)
 {
-    unsigned           m, n, p, binsize;
-    unsigned long long k, i, j, ind;
+    int factor[3] = { 1, 1, 1 };
+    factor[axis]  = 1 << level;
+    sample(1, data, dx, dy, dz, factor, 0, 0, out);
+}
+
+//============================================================================//
 
-    binsize = pow(2, level);
-    // Ensure that largest array is small enough to be indexable
-    assert(ULLONG_MAX / binsize / dy / dz / dx > 0);
-    // Ensure safe comparison between unsigned (ijk) and signed (xyz)
-    assert(dx >= 0 && dy >= 0 && dz >= 0);
+// Each output row takes row (m, s) and the mirrored row (m + dx / 2, s).
+// The blend weights are computed in double, as np.linspace, and so is the
+// blended sum.
+DLL void
+sino_360_to_180(const float* data, int dx, int dy, int dz, int overlap,
+                int left, int ncore, float* out)
+{
+    int       n    = dx / 2;
+    int       nw   = 2 * dz - overlap;
+    int       keep = dz - overlap;
+    long long nrow = (long long) n * dy;
+    double    step = (overlap > 1) ? 1.0 / (overlap - 1) : 0.0;
+    double*   w    = (double*) malloc((overlap + 1) * sizeof(double));
+    long long r;
+    int       t;
 
-    if(axis == 0)
+    assert(w != NULL);
+
+    // np.linspace(0, 1, overlap) on the left, (1, 0) on the right
+    for(t = 0; t < overlap; t++)
+        w[t] = (left) ? t * step : 1.0 - t * step;
+    if(overlap > 1)
+        w[overlap - 1] = (left) ? 1.0 : 0.0;
+
+#pragma omp parallel for num_threads(get_nthreads(ncore)) schedule(static)
+    for(r = 0; r < nrow; r++)
     {
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
+        const float* a = data + (size_t) r * dz;
+        const float* b = data + ((size_t) n * dy + r) * dz;
+        float*       o = out + (size_t) r * nw;
+        int          j;
+
+        if(left)
         {
-            i = m * (dy * dz);
-            for(p = 0; p < binsize; p++)
-            {
-                for(n = 0; n < (unsigned) dy; n++)
-                {
-                    j = n * dz;
-                    for(k = 0; k < (unsigned) dz; k++)
-                    {
-                        out[ind] = data[i + j + k];
-                        ind++;
-                    }
-                }
-            }
+            for(j = 0; j < keep; j++)
+                o[j] = b[dz - 1 - j];
+            for(j = 0; j < overlap; j++)
+                o[keep + j] = (float) (w[j] * a[j] +
+                                       w[overlap - 1 - j] * b[overlap - 1 - j]);
+            memcpy(o + dz, a + overlap, keep * sizeof(float));
         }
-    }
-    else if(axis == 1)
-    {
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
+        else
         {
-            i = m * (dy * dz);
-            for(n = 0; n < (unsigned) dy; n++)
-            {
-                j = n * dz;
-                for(p = 0; p < binsize; p++)
-                {
-                    for(k = 0; k < (unsigned) dz; k++)
-                    {
-                        out[ind] = data[i + j + k];
-                        ind++;
-                    }
-                }
-            }
+            memcpy(o, a, keep * sizeof(float));
+            for(j = 0; j < overlap; j++)
+                o[keep + j] = (float) (w[j] * a[keep + j] +
+                                       w[overlap - 1 - j] * b[dz - 1 - j]);
+            for(j = 0; j < keep; j++)
+                o[dz + j] = b[keep - 1 - j];
         }
     }
-    else if(axis == 2)
+
+    free(w);
+}
+
+//============================================================================//
+
+// Output rows are independent: along the last axis each is a padded source
+// row, along the others a source row or the constant.
+DLL void
+pad_volume(const float* data, int dx, int dy, int dz, int axis, int npad,
+           int mode, float cval, int ncore, float* out)
+{
+    int       ox   = dx + ((axis == 0) ? 2 * npad : 0);
+    int       oy   = dy + ((axis == 1) ? 2 * npad : 0);
+    int       oz   = dz + ((axis == 2) ? 2 * npad : 0);
+    long long nrow = (long long) ox * oy;
+    long long r;
+
+#pragma omp parallel for num_threads(get_nthreads(ncore)) schedule(static)
+    for(r = 0; r < nrow; r++)
     {
-        for(m = 0, ind = 0; m < (unsigned) dx; m++)
+        int    i   = (int) (r / oy);
+        int    j   = (int) (r % oy);
+        float* dst = out + (size_t) r * oz;
+        int    k;
+
+        if(axis == 0)
+            i = pad_index(i - npad, dx, mode);
+        else if(axis == 1)
+            j = pad_index(j - npad, dy, mode);
+
+        if(i < 0 || j < 0)
         {
-            i = m * (dy * dz);
-            for(n = 0; n < (unsigned) dy; n++)
-            {
-                j = n * dz;
-                for(k = 0; k < (unsigned) dz; k++)
-                {
-                    for(p = 0; p < binsize; p++)
-                    {
-                        out[ind] = data[i + j + k];
-                        ind++;
-                    }
-                }
-            }
+            for(k = 0; k < oz; k++)
+                dst[k] = cval;
+            continue;
         }
+
+        const float* src = data + ((size_t) i * dy + j) * dz;
+        if(axis == 2)
+            pad_row(src, dz, npad, npad, mode, cval, dst);
+        else
+            memcpy(dst, src, dz * sizeof(float));
     }
 }
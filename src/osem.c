@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -105,6 +106,7 @@ osem(const float* data, int dy, int dt, int dx, const float* center,
                 memset(sum_dist, 0, (ngridx * ngridy) * sizeof(float));
                 memset(update, 0, (ngridx * ngridy) * sizeof(float));
 
+                PROFILE_START(t_subset);
                 // For each projection angle
                 for(q = 0; q < subset_ind2; q++)
                 {
@@ -169,6 +171,9 @@ osem(const float* data, int dy, int dt, int dx, const float* center,
                         }
                     }
                 }
+                PROFILE_STOP(t_subset, "osem.project",
+                             sizeof(float) * (size_t) subset_ind2 * dx * 2);
+                PROFILE_RESTART(t_subset);
 
                 m = 0;
                 for(n = 0; n < ngridx * ngridy; n++)
@@ -180,6 +185,8 @@ osem(const float* data, int dy, int dt, int dx, const float* center,
                     }
                     m++;
                 }
+                PROFILE_STOP(t_subset, "osem.update",
+                             sizeof(float) * (size_t) ngridx * ngridy * 3);
             }
         }
     }
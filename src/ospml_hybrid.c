@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -107,6 +108,7 @@ ospml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
                 F        = (float*) calloc((ngridx * ngridy), sizeof(float));
                 G        = (float*) calloc((ngridx * ngridy), sizeof(float));
 
+                PROFILE_START(t_subset);
                 // For each projection angle
                 for(q = 0; q < subset_ind2; q++)
                 {
@@ -173,6 +175,9 @@ ospml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
                         }
                     }
                 }
+                PROFILE_STOP(t_subset, "ospml_hybrid.project",
+                             sizeof(float) * (size_t) subset_ind2 * dx * 2);
+                PROFILE_RESTART(t_subset);
 
                 // Weights for inner neighborhoods.
                 totalwg = 4 + 4 / sqrt(2);
@@ -410,6 +415,8 @@ ospml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
                 free(E);
                 free(F);
                 free(G);
+                PROFILE_STOP(t_subset, "ospml_hybrid.update",
+                             sizeof(float) * (size_t) ngridx * ngridy * 3);
             }
         }
 
@@ -0,0 +1,110 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fft.h"
+#include "prep.h"
+#include "utils.h"
+#include <string.h>
+
+// Projections are independent and spread over ``ncore`` threads in chunks
+// of ``nchunk`` projections. Both FFT plans are made once and shared; each
+// thread filters its projections in one padded half-spectrum buffer.
+void
+retrieve_phase(float* data, int dx, int dy, int dz, const float* filter,
+               int py, int pz, int mode, float cval, int ncore, int nchunk)
+{
+    int       ny    = dy + 2 * py;
+    int       nz    = dz + 2 * pz;
+    int       nh    = nz / 2 + 1;
+    size_t    nspec = (size_t) ny * nh;
+    fft_plan* fwd   = fft_plan_2d_real(ny, nz, FFT_FORWARD);
+    fft_plan* bwd   = fft_plan_2d_real(ny, nz, FFT_BACKWARD);
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float _Complex* spec = fft_malloc_c(nspec);
+        float*          buf  = (float*) spec;
+        int             m, i, j;
+        size_t          k;
+
+        assert(spec != NULL);
+
+        // For each projection.
+#pragma omp for schedule(dynamic, (nchunk > 0) ? nchunk : 1)
+        for(m = 0; m < dx; m++)
+        {
+            float* prj = data + (size_t) m * dy * dz;
+
+            // Pad the rows and columns as they are loaded. Real rows are
+            // 2 * nh floats apart in the transform buffer.
+            for(i = 0; i < ny; i++)
+            {
+                int    r   = pad_index(i - py, dy, mode);
+                float* row = buf + (size_t) i * 2 * nh;
+                if(r < 0)
+                    for(j = 0; j < nz; j++)
+                        row[j] = cval;
+                else
+                    pad_row(prj + (size_t) r * dz, dz, pz, pz, mode, cval,
+                            row);
+            }
+
+            fft_execute(fwd, spec);
+#pragma omp simd
+            for(k = 0; k < nspec; k++)
+                spec[k] *= filter[k];
+            fft_execute(bwd, spec);
+
+            // Crop back to the projection.
+            for(i = 0; i < dy; i++)
+                memcpy(prj + (size_t) i * dz,
+                       buf + (size_t)(i + py) * 2 * nh + pz,
+                       dz * sizeof(float));
+        }
+
+        fft_free(spec);
+    }
+
+    fft_destroy(fwd);
+    fft_destroy(bwd);
+}
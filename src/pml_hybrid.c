@@ -41,6 +41,8 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "affinity.h"
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -94,6 +96,7 @@ pml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
             F        = (float*) calloc((ngridx * ngridy), sizeof(float));
             G        = (float*) calloc((ngridx * ngridy), sizeof(float));
 
+            PROFILE_START(t_slice);
             // For each projection angle
             for(p = 0; p < dt; p++)
             {
@@ -157,6 +160,9 @@ pml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
                     }
                 }
             }
+            PROFILE_STOP(t_slice, "pml_hybrid.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
+            PROFILE_RESTART(t_slice);
 
             // Weights for inner neighborhoods.
             totalwg = 4 + 4 / sqrt(2);
@@ -393,6 +399,8 @@ pml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
             free(E);
             free(F);
             free(G);
+            PROFILE_STOP(t_slice, "pml_hybrid.update",
+                         sizeof(float) * (size_t) ngridx * ngridy * 3);
         }
 
         free(simdata);
@@ -411,3 +419,229 @@ pml_hybrid(const float* data, int dy, int dt, int dx, const float* center,
     free(dist);
     free(indi);
 }
+
+//============================================================================//
+
+// 3D pml_hybrid: the hybrid penalty of pml_hybrid() over the 26 neighbours
+// of a voxel, weighted by inverse distance and normalized over the
+// neighbours inside the volume. In a single slice this is the 8-neighbour
+// penalty of pml_hybrid().
+//
+// Each thread owns contiguous blocks of ``nchunk`` slices (one block per
+// thread by default). An iteration first computes every new slice into
+// ``next``, reading the edge slices of the neighbouring blocks (the halo),
+// and only after a barrier copies ``next`` back into ``recon``.
+void
+pml_hybrid3d(const float* data, int dy, int dt, int dx, const float* center,
+             const float* theta, float* recon, int ngridx, int ngridy,
+             int num_iter, const float* reg_pars, int ncore, int nchunk)
+{
+    size_t npix     = (size_t) ngridx * ngridy;
+    int    nthreads = get_nthreads(ncore);
+    int    nblock   = volume_chunk(dy, nthreads, nchunk, 0);
+    int    nblocks  = (dy + nblock - 1) / nblock;
+    float* next     = (float*) malloc(dy * npix * sizeof(float));
+    float  wtab[4];
+
+    assert(next != NULL);
+
+    // Neighbour weights by the number of axes the offset spans
+    wtab[0] = 0;
+    wtab[1] = 1;
+    wtab[2] = 1 / sqrt(2);
+    wtab[3] = 1 / sqrt(3);
+
+    if(nthreads > nblocks)
+        nthreads = nblocks;
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        float* gridx    = (float*) malloc((ngridx + 1) * sizeof(float));
+        float* gridy    = (float*) malloc((ngridy + 1) * sizeof(float));
+        float* coordx   = (float*) malloc((ngridy + 1) * sizeof(float));
+        float* coordy   = (float*) malloc((ngridx + 1) * sizeof(float));
+        float* ax       = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* ay       = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* bx       = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* by       = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* coorx    = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* coory    = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* dist     = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        int*   indi     = (int*) malloc((ngridx + ngridy) * sizeof(int));
+        float* simdata  = (float*) malloc((size_t) dt * dx * sizeof(float));
+        float* sum_dist = (float*) malloc(npix * sizeof(float));
+        float* E        = (float*) malloc(npix * sizeof(float));
+
+        assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
+               by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
+               dist != NULL && indi != NULL && simdata != NULL &&
+               sum_dist != NULL && E != NULL);
+
+        int    b, s, s1, p, d, i, m, n, q, ds, dn, dm;
+        int    quadrant;
+        float  theta_p, sin_p, cos_p;
+        float  mov, xi, yi;
+        int    asize, bsize, csize;
+        float  upd, sum_dist2;
+        size_t ind_data;
+        size_t k;
+        int    t = 0, nt = 1;
+#ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+#endif
+        numa_pin(t, nt);
+
+        for(i = 0; i < num_iter; i++)
+        {
+#pragma omp for schedule(static, 1)
+            for(b = 0; b < nblocks; b++)
+            {
+                s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+                for(s = b * nblock; s < s1; s++)
+                {
+                    const float* rs = recon + s * npix;
+
+                    preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
+                                  gridy);  // Outputs: mov, gridx, gridy
+
+                    memset(simdata, 0, (size_t) dt * dx * sizeof(float));
+                    memset(sum_dist, 0, npix * sizeof(float));
+                    memset(E, 0, npix * sizeof(float));
+
+                    PROFILE_START(t_slice);
+                    // For each projection angle
+                    for(p = 0; p < dt; p++)
+                    {
+                        theta_p  = fmodf(theta[p], 2.0f * (float) M_PI);
+                        quadrant = calc_quadrant(theta_p);
+                        sin_p    = sinf(theta_p);
+                        cos_p    = cosf(theta_p);
+
+                        // For each detector pixel
+                        for(d = 0; d < dx; d++)
+                        {
+                            xi = -ngridx - ngridy;
+                            yi = 0.5f * (1 - dx) + d + mov;
+                            calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p,
+                                        gridx, gridy, coordx, coordy);
+                            trim_coords(ngridx, ngridy, coordx, coordy, gridx,
+                                        gridy, &asize, ax, ay, &bsize, bx, by);
+                            sort_intersections(quadrant, asize, ax, ay, bsize,
+                                               bx, by, &csize, coorx, coory);
+                            calc_dist(ngridx, ngridy, csize, coorx, coory,
+                                      indi, dist);
+
+                            // Calculate simdata
+                            calc_simdata(0, p, d, ngridx, ngridy, dt, dx,
+                                         csize, indi, dist, rs, simdata);
+
+                            // Calculate dist*dist
+                            sum_dist2 = 0.0f;
+                            for(n = 0; n < csize - 1; n++)
+                            {
+                                sum_dist2 += dist[n] * dist[n];
+                                sum_dist[indi[n]] += dist[n];
+                            }
+
+                            // Update
+                            if(sum_dist2 != 0.0f)
+                            {
+                                ind_data = (size_t) s * dt * dx +
+                                           (size_t) p * dx + d;
+                                upd = data[ind_data] / simdata[d + p * dx];
+                                for(n = 0; n < csize - 1; n++)
+                                    E[indi[n]] -=
+                                        rs[indi[n]] * upd * dist[n];
+                            }
+                        }
+                    }
+                    PROFILE_STOP(t_slice, "pml_hybrid3d.project",
+                                 sizeof(float) * (size_t) dt * dx * 2);
+                    PROFILE_RESTART(t_slice);
+
+                    // Penalty over the neighbours in and across slices
+                    for(n = 0; n < ngridx; n++)
+                    {
+                        for(m = 0; m < ngridy; m++)
+                        {
+                            float F = 0, G = 0, totalwg = 0;
+                            float r0;
+
+                            q  = m + n * ngridy;
+                            k  = s * npix + q;
+                            r0 = recon[k];
+
+                            for(ds = -1; ds <= 1; ds++)
+                                for(dn = -1; dn <= 1; dn++)
+                                    for(dm = -1; dm <= 1; dm++)
+                                        if(s + ds >= 0 && s + ds < dy &&
+                                           n + dn >= 0 && n + dn < ngridx &&
+                                           m + dm >= 0 && m + dm < ngridy)
+                                            totalwg += wtab[abs(ds) + abs(dn) +
+                                                            abs(dm)];
+
+                            for(ds = -1; ds <= 1; ds++)
+                                for(dn = -1; dn <= 1; dn++)
+                                    for(dm = -1; dm <= 1; dm++)
+                                    {
+                                        float wg, mg, rg, gammag;
+                                        int   nb = abs(ds) + abs(dn) + abs(dm);
+                                        if(nb == 0 || s + ds < 0 ||
+                                           s + ds >= dy || n + dn < 0 ||
+                                           n + dn >= ngridx || m + dm < 0 ||
+                                           m + dm >= ngridy)
+                                            continue;
+                                        wg = wtab[nb] / totalwg;
+                                        mg = r0 + recon[k + ds * npix +
+                                                        dn * ngridy + dm];
+                                        rg = r0 - recon[k + ds * npix +
+                                                        dn * ngridy + dm];
+                                        gammag =
+                                            1 / (1 + fabs(rg / reg_pars[1]));
+                                        F += 2 * reg_pars[0] * wg * gammag;
+                                        G -= 2 * reg_pars[0] * wg * gammag * mg;
+                                    }
+
+                            G += sum_dist[q];
+                            if(F != 0.0)
+                                next[k] =
+                                    (-G + sqrt(G * G - 8 * E[q] * F)) / (4 * F);
+                            else
+                                next[k] = r0;
+                        }
+                    }
+                    PROFILE_STOP(t_slice, "pml_hybrid3d.update",
+                                 sizeof(float) * (size_t) ngridx * ngridy * 3);
+                }
+            }
+
+#pragma omp for schedule(static, 1)
+            for(b = 0; b < nblocks; b++)
+            {
+                s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+                for(k = (size_t) b * nblock * npix; k < s1 * npix; k++)
+                    recon[k] = next[k];
+            }
+        }
+
+        numa_unpin();
+        free(gridx);
+        free(gridy);
+        free(coordx);
+        free(coordy);
+        free(ax);
+        free(ay);
+        free(bx);
+        free(by);
+        free(coorx);
+        free(coory);
+        free(dist);
+        free(indi);
+        free(simdata);
+        free(sum_dist);
+        free(E);
+    }
+
+    free(next);
+}
@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -94,6 +95,7 @@ pml_quad(const float* data, int dy, int dt, int dx, const float* center,
             F        = (float*) calloc((ngridx * ngridy), sizeof(float));
             G        = (float*) calloc((ngridx * ngridy), sizeof(float));
 
+            PROFILE_START(t_slice);
             // For each projection angle
             for(p = 0; p < dt; p++)
             {
@@ -157,6 +159,9 @@ pml_quad(const float* data, int dy, int dt, int dx, const float* center,
                     }
                 }
             }
+            PROFILE_STOP(t_slice, "pml_quad.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
+            PROFILE_RESTART(t_slice);
 
             // Weights for inner neighborhoods.
             totalwg = 4 + 4 / sqrt(2);
@@ -375,6 +380,8 @@ pml_quad(const float* data, int dy, int dt, int dx, const float* center,
             free(E);
             free(F);
             free(G);
+            PROFILE_STOP(t_slice, "pml_quad.update",
+                         sizeof(float) * (size_t) ngridx * ngridy * 3);
         }
 
         free(simdata);
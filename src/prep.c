@@ -42,46 +42,220 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "prep.h"
+#include "utils.h"
+#include <string.h>
+
+// Air level at one edge of a row: mean of the ``nair`` edge pixels, or
+// their median if ``window`` is given (nair floats of scratch).
+static inline float
+air_level(const float* edge, int nair, float* window)
+{
+    int   j;
+    float air = 0.0f;
+
+    if(window)
+    {
+        memcpy(window, edge, nair * sizeof(float));
+        return select_median(window, nair);
+    }
+    for(j = 0; j < nair; j++)
+        air += edge[j];
+    return air / (float) nair;
+}
+
+// Scale one row so that its left and right air regions are set to one.
+static void
+normalize_bg_row(float* row, int dz, int nair, float* window)
+{
+    int   j;
+    float air_left, air_right, air_slope;
+
+    air_left  = air_level(row, nair, window);
+    air_right = air_level(row + dz - nair, nair, window);
+
+    if(air_left <= 0.)
+    {
+        air_left = 1.;
+    }
+    if(air_right <= 0.)
+    {
+        air_right = 1.;
+    }
+
+    air_slope = (air_right - air_left) / (dz - 1);
+
+    // Vectorized; a true division keeps results identical to the serial
+    // version, which a reciprocal multiply would not.
+#pragma omp simd
+    for(j = 0; j < dz; j++)
+    {
+        row[j] /= air_left + air_slope * j;
+    }
+}
+
+//============================================================================//
 
 DLL void
-normalize_bg(float* data, int dx, int dy, int dz, int nair)
+normalize_bg(float* data, int dx, int dy, int dz, int nair, int median,
+             int ncore, int nchunk)
 {
-    int   n, m, i, j, iproj;
-    float air_left, air_right, air_slope, air;
+    const int nrow = dx * dy;
 
-    for(m = 0; m < dx; m++)
+#pragma omp parallel num_threads(get_nthreads(ncore))
     {
-        iproj = m * (dz * dy);
+        float* window = median ? (float*) malloc(nair * sizeof(float)) : NULL;
+        int    i;
 
-        for(n = 0; n < dy; n++)
+        // Rows of all projections are independent
+#pragma omp for schedule(static, (nchunk > 0) ? nchunk * dy : dy)
+        for(i = 0; i < nrow; i++)
         {
-            i = iproj + n * dz;
+            normalize_bg_row(data + (size_t) i * dz, dz, nair, window);
+        }
 
-            for(j = 0, air_left = 0, air_right = 0; j < nair; j++)
-            {
-                air_left += data[i + j];
-                air_right += data[i + dz - 1 - j];
-            }
+        free(window);
+    }
+}
 
-            air_left /= (float) nair;
-            air_right /= (float) nair;
+//============================================================================//
+//
+//  Fused preprocessing: flat/dark normalization, cutoff, outlier removal,
+//  background normalization and minus log in a single pass over the raw
+//  projections. Each projection is handled by one thread; the optional
+//  outlier step works on a per-thread copy of the normalized projection,
+//  everything else is done row by row while the row is in cache.
+//
+//============================================================================//
 
-            if(air_left <= 0.)
-            {
-                air_left = 1.;
-            }
-            if(air_right <= 0.)
+// Background normalization and minus log of one normalized row.
+static inline void
+finish_row(float* row, int dz, int nair, float* window, int minus_log)
+{
+    int j;
+    if(nair > 0)
+        normalize_bg_row(row, dz, nair, window);
+    if(minus_log)
+    {
+        for(j = 0; j < dz; j++)
+            row[j] = -logf(row[j]);
+    }
+}
+
+static void
+normalize_fused(const uint16_t* data16, const float* data32, const float* flat,
+                const float* dark, float* out, int dx, int dy, int dz,
+                float cutoff, float dif, int size, int nair, int air_median,
+                int minus_log, int ncore)
+{
+    size_t npix    = (size_t) dy * dz;
+    int    outlier = (size > 1);
+    float* denom   = (float*) malloc(npix * sizeof(float));
+    size_t i;
+
+    for(i = 0; i < npix; i++)
+    {
+        denom[i] = flat[i] - dark[i];
+        if(denom[i] < 1e-6f)
+            denom[i] = 1e-6f;
+    }
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float* norm   = NULL;
+        float* med    = NULL;
+        float* window = NULL;
+        float* airwin = NULL;
+        int    p, n, j;
+
+        if(nair > 0 && air_median)
+            airwin = (float*) malloc(nair * sizeof(float));
+
+        if(outlier)
+        {
+            norm   = (float*) malloc(npix * sizeof(float));
+            med    = (float*) malloc(npix * sizeof(float));
+            window = (float*) malloc(size * size * sizeof(float));
+        }
+
+#pragma omp for schedule(static)
+        for(p = 0; p < dx; p++)
+        {
+            float* proj = out + p * npix;
+            float* dst  = outlier ? norm : proj;
+
+            for(n = 0; n < dy; n++)
             {
-                air_right = 1.;
-            }
+                size_t       k    = (size_t) n * dz;
+                float*       row  = dst + k;
+                const float* drow = dark + k;
+                const float* frow = denom + k;
+
+                // Flat and dark field correction with cutoff
+                if(data16)
+                {
+                    const uint16_t* src = data16 + p * npix + k;
+#pragma omp simd
+                    for(j = 0; j < dz; j++)
+                    {
+                        float v = ((float) src[j] - drow[j]) / frow[j];
+                        row[j]  = (v > cutoff) ? cutoff : v;
+                    }
+                }
+                else
+                {
+                    const float* src = data32 + p * npix + k;
+#pragma omp simd
+                    for(j = 0; j < dz; j++)
+                    {
+                        float v = (src[j] - drow[j]) / frow[j];
+                        row[j]  = (v > cutoff) ? cutoff : v;
+                    }
+                }
 
-            air_slope = (air_right - air_left) / (dz - 1);
+                if(!outlier)
+                    finish_row(row, dz, nair, airwin, minus_log);
+            }
 
-            for(j = 0; j < dz; j++)
+            if(outlier)
             {
-                air         = air_left + air_slope * j;
-                data[i + j] = data[i + j] / air;
+                // Replace values exceeding the local median by ``dif``
+                median_filter_2d(norm, med, dy, dz, size, size, window);
+                for(i = 0; i < npix; i++)
+                    proj[i] = (norm[i] - med[i] >= dif) ? med[i] : norm[i];
+                for(n = 0; n < dy; n++)
+                    finish_row(proj + n * dz, dz, nair, airwin, minus_log);
             }
         }
+
+        free(norm);
+        free(med);
+        free(window);
+        free(airwin);
     }
+
+    free(denom);
+}
+
+//============================================================================//
+
+DLL void
+normalize_fused_uint16(const uint16_t* data, const float* flat,
+                       const float* dark, float* out, int dx, int dy, int dz,
+                       float cutoff, float dif, int size, int nair,
+                       int air_median, int minus_log, int ncore)
+{
+    normalize_fused(data, NULL, flat, dark, out, dx, dy, dz, cutoff, dif, size,
+                    nair, air_median, minus_log, ncore);
+}
+
+//============================================================================//
+
+DLL void
+normalize_fused_float32(const float* data, const float* flat,
+                        const float* dark, float* out, int dx, int dy, int dz,
+                        float cutoff, float dif, int size, int nair,
+                        int air_median, int minus_log, int ncore)
+{
+    normalize_fused(NULL, data, flat, dark, out, dx, dy, dz, cutoff, dif, size,
+                    nair, air_median, minus_log, ncore);
 }
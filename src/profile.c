@@ -0,0 +1,209 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "profile.h"
+#include "utils.h"
+#include <time.h>
+
+#define PROFILE_MAX_PHASES 64
+#define PROFILE_MAX_EVENTS 65536
+
+typedef struct
+{
+    char      name[PROFILE_NAME_LEN];
+    long long count;
+    double    seconds;
+    double    bytes;
+} profile_total;
+
+typedef struct
+{
+    int    phase;
+    int    thread;
+    double start;
+    double duration;
+} profile_event;
+
+static profile_total phases[PROFILE_MAX_PHASES];
+static int           nphase = 0;
+static profile_event events[PROFILE_MAX_EVENTS];
+static int           nevent  = 0;
+static int           nthread = 0;
+
+// Threads are numbered in the order they first record an event.
+static __thread int thread_id = -1;
+
+//============================================================================//
+
+double
+profile_clock(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+//============================================================================//
+
+int
+profile_phase(const char* name)
+{
+    int i;
+#pragma omp critical(profile)
+    {
+        for(i = 0; i < nphase; i++)
+            if(strncmp(phases[i].name, name, PROFILE_NAME_LEN - 1) == 0)
+                break;
+        if(i == nphase && nphase < PROFILE_MAX_PHASES)
+        {
+            strncpy(phases[i].name, name, PROFILE_NAME_LEN - 1);
+            nphase++;
+        }
+    }
+    return (i < PROFILE_MAX_PHASES) ? i : -1;
+}
+
+//============================================================================//
+
+void
+profile_record(int phase, double start, double nbytes)
+{
+    double now = profile_clock();
+    int    e;
+
+    if(phase < 0)
+        return;
+#pragma omp atomic
+    phases[phase].count++;
+#pragma omp atomic
+    phases[phase].seconds += now - start;
+#pragma omp atomic
+    phases[phase].bytes += nbytes;
+
+    if(thread_id < 0)
+    {
+#pragma omp atomic capture
+        thread_id = nthread++;
+    }
+#pragma omp atomic capture
+    e = nevent++;
+    if(e < PROFILE_MAX_EVENTS)
+    {
+        events[e].phase    = phase;
+        events[e].thread   = thread_id;
+        events[e].start    = start;
+        events[e].duration = now - start;
+    }
+}
+
+//============================================================================//
+
+int
+profile_enabled(void)
+{
+#ifdef TOMOPY_PROFILE
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+//============================================================================//
+
+void
+profile_reset(void)
+{
+    int i;
+#pragma omp critical(profile)
+    {
+        for(i = 0; i < nphase; i++)
+        {
+            phases[i].count   = 0;
+            phases[i].seconds = 0.0;
+            phases[i].bytes   = 0.0;
+        }
+        nevent = 0;
+    }
+}
+
+//============================================================================//
+
+int
+profile_phases(int max, char* names, long long* counts, double* seconds,
+               double* bytes)
+{
+    int i;
+    for(i = 0; i < nphase && i < max; i++)
+    {
+        memcpy(names + i * PROFILE_NAME_LEN, phases[i].name, PROFILE_NAME_LEN);
+        counts[i]  = phases[i].count;
+        seconds[i] = phases[i].seconds;
+        bytes[i]   = phases[i].bytes;
+    }
+    return nphase;
+}
+
+//============================================================================//
+
+int
+profile_events(int max, int* phase, int* thread, double* start,
+               double* duration)
+{
+    int    n = (nevent < PROFILE_MAX_EVENTS) ? nevent : PROFILE_MAX_EVENTS;
+    double t0;
+    int    i;
+
+    for(i = 0, t0 = (n > 0) ? events[0].start : 0.0; i < n; i++)
+        if(events[i].start < t0)
+            t0 = events[i].start;
+    for(i = 0; i < n && i < max; i++)
+    {
+        phase[i]    = events[i].phase;
+        thread[i]   = events[i].thread;
+        start[i]    = events[i].start - t0;
+        duration[i] = events[i].duration;
+    }
+    return n;
+}
@@ -43,299 +43,427 @@
 
 #include "utils.h"
 
+// Number of slices projected together: the transposed slab takes at most
+// 256 MB.
+static int
+slab_size(size_t npix, int oy)
+{
+    size_t n = ((size_t) 256 << 20) / (npix * sizeof(float));
+    return (n < 1) ? 1 : (n > (size_t) oy) ? oy : (int) n;
+}
+
+//============================================================================//
+
+// Slices are projected in slabs of consecutive slices that share a rotation
+// center. Each slab is transposed to [pixel][slice], so a ray, traced once
+// per slab, gathers all of its slices in one contiguous sweep per pixel.
+// Angles are spread over ``ncore`` threads; ``nchunk`` caps the slab size.
 void
 project(const float* obj, int oy, int ox, int oz, float* data, int dy, int dt,
-        int dx, const float* center, const float* theta)
+        int dx, const float* center, const float* theta, int ncore,
+        int nchunk)
 {
-    float* gridx  = (float*) malloc((ox + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordx = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ox + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* ay     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* bx     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* by     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coorx  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coory  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* dist   = (float*) malloc((ox + oz + 1) * sizeof(float));
-    int*   indi   = (int*) malloc((ox + oz + 1) * sizeof(int));
-
-    assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
-           by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
-           dist != NULL && indi != NULL);
-
-    int   s, p, d;
-    int   quadrant;
-    float theta_p, sin_p, cos_p;
-    float mov, xi, yi;
-    int   asize, bsize, csize;
-
-    preprocessing(ox, oz, dx, center[0], &mov, gridx,
-                  gridy);  // Outputs: mov, gridx, gridy
-
-    // For each projection angle
-    for(p = 0; p < dt; p++)
+    size_t npix  = (size_t) ox * oz;
+    int    nslab = (nchunk > 0 && nchunk < oy) ? nchunk : slab_size(npix, oy);
+    float* gridx = (float*) malloc((ox + 1) * sizeof(float));
+    float* gridy = (float*) malloc((oz + 1) * sizeof(float));
+    float* slab  = (float*) malloc(npix * nslab * sizeof(float));
+    int    s0, s1, ns;
+    float  mov;
+
+    assert(gridx != NULL && gridy != NULL && slab != NULL);
+    (void) dy;
+
+    for(s0 = 0; s0 < oy; s0 = s1)
     {
-        // Calculate the sin and cos values
-        // of the projection angle and find
-        // at which quadrant on the cartesian grid.
-        theta_p  = fmod(theta[p], 2 * M_PI);
-        quadrant = calc_quadrant(theta_p);
-        sin_p    = sinf(theta_p);
-        cos_p    = cosf(theta_p);
-
-        for(d = 0; d < dx; d++)
+        for(s1 = s0 + 1;
+            s1 < oy && s1 - s0 < nslab && center[s1] == center[s0]; s1++)
+            ;
+        ns = s1 - s0;
+
+        preprocessing(ox, oz, dx, center[s0], &mov, gridx,
+                      gridy);  // Outputs: mov, gridx, gridy
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
         {
-            // Calculate coordinates
-            xi = -ox - oz;
-            yi = (1 - dx) / 2.0 + d + mov;
-            calc_coords(ox, oz, xi, yi, sin_p, cos_p, gridx, gridy, coordx,
-                        coordy);
-
-            // Merge the (coordx, gridy) and (gridx, coordy)
-            trim_coords(ox, oz, coordx, coordy, gridx, gridy, &asize, ax, ay,
-                        &bsize, bx, by);
-
-            // Sort the array of intersection points (ax, ay) and
-            // (bx, by). The new sorted intersection points are
-            // stored in (coorx, coory). Total number of points
-            // are csize.
-            sort_intersections(quadrant, asize, ax, ay, bsize, bx, by, &csize,
-                               coorx, coory);
-
-            // Calculate the distances (dist) between the
-            // intersection points (coorx, coory). Find the
-            // indices of the pixels on the object grid.
-            calc_dist(ox, oz, csize, coorx, coory, indi, dist);
-
-            // For each slice
-            for(s = 0; s < dy; s++)
+            ray_buffers b;
+            float*      tile =
+                (float*) malloc((size_t) dx * ns * sizeof(float));
+            int         p, d, n, s, csize, quadrant;
+            long long   i;
+            float       theta_p, sin_p, cos_p;
+
+            ray_alloc(&b, ox, oz);
+
+#pragma omp for schedule(static)
+            for(i = 0; i < (long long) npix; i++)
+                for(s = 0; s < ns; s++)
+                    slab[i * ns + s] = obj[(size_t)(s0 + s) * npix + i];
+
+            // For each projection angle
+#pragma omp for schedule(dynamic, 1)
+            for(p = 0; p < dt; p++)
             {
-                // Calculate simdata
-                calc_simdata(s, p, d, ox, oz, dt, dx, csize, indi, dist, obj,
-                             data);  // Output: simulated data
+                // Calculate the sin and cos values
+                // of the projection angle and find
+                // at which quadrant on the cartesian grid.
+                theta_p  = fmod(theta[p], 2 * M_PI);
+                quadrant = calc_quadrant(theta_p);
+                sin_p    = sinf(theta_p);
+                cos_p    = cosf(theta_p);
+
+                for(d = 0; d < dx; d++)
+                {
+                    float* acc = tile + (size_t) d * ns;
+                    csize = trace_ray(ox, oz, (1 - dx) / 2.0 + d + mov,
+                                      quadrant, sin_p, cos_p, gridx, gridy,
+                                      &b);
+                    for(s = 0; s < ns; s++)
+                        acc[s] = 0.0f;
+                    for(n = 0; n < csize - 1; n++)
+                    {
+                        const float* col = slab + (size_t) b.indi[n] * ns;
+                        const float  len = b.dist[n];
+#pragma omp simd
+                        for(s = 0; s < ns; s++)
+                            acc[s] += col[s] * len;
+                    }
+                }
+
+                // Simulated data, one detector row per slice
+                for(s = 0; s < ns; s++)
+                {
+                    float* row = data + (size_t)(s0 + s) * dt * dx +
+                                 (size_t) p * dx;
+                    for(d = 0; d < dx; d++)
+                        row[d] += tile[(size_t) d * ns + s];
+                }
             }
+
+            ray_free(&b);
+            free(tile);
         }
     }
 
     free(gridx);
     free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indi);
+    free(slab);
 }
 
-void
-project2(const float* objx, const float* objy, int oy, int ox, int oz,
-         float* data, int dy, int dt, int dx, const float* center,
-         const float* theta)
+// Project the pair of vector components (c0, c1) weighted by the ray
+// direction. ``axis`` selects which object axis is treated as the slice
+// axis, matching calc_simdata3. Both components are transposed into one
+// [pixel][component][slice] slab, so a ray reads each voxel once.
+static void
+project_vector(const float* c0, const float* c1, int axis, int ox, int oz,
+               float* data, int dy, int dt, int dx, const float* center,
+               const float* theta, int ncore, int nchunk)
 {
-    float* gridx  = (float*) malloc((ox + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordx = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ox + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* ay     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* bx     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* by     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coorx  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coory  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* dist   = (float*) malloc((ox + oz + 1) * sizeof(float));
-    int*   indx   = (int*) malloc((ox + oz + 1) * sizeof(int));
-    int*   indy   = (int*) malloc((ox + oz + 1) * sizeof(int));
-    int*   indi   = (int*) malloc((ox + oz + 1) * sizeof(int));
-
-    assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
-           by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
-           dist != NULL && indi != NULL);
-
-    int   s, p, d;
-    int   quadrant;
-    float theta_p, sin_p, cos_p;
-    float srcx, srcy, detx, dety, dv, vx, vy;
-    float mov, xi, yi;
-    int   asize, bsize, csize;
-
-    preprocessing(ox, oz, dx, center[0], &mov, gridx,
-                  gridy);  // Outputs: mov, gridx, gridy
-
-    // For each projection angle
-    for(p = 0; p < dt; p++)
+    size_t npix  = (size_t) ox * oz;
+    int    nslab = (nchunk > 0 && nchunk < dy) ? nchunk
+                                               : slab_size(2 * npix, dy);
+    float* gridx = (float*) malloc((ox + 1) * sizeof(float));
+    float* gridy = (float*) malloc((oz + 1) * sizeof(float));
+    float* slab  = (float*) malloc(2 * npix * nslab * sizeof(float));
+    size_t sstride;
+    int    s0, s1, ns;
+    float  mov;
+
+    assert(gridx != NULL && gridy != NULL && slab != NULL);
+
+    // Offset between consecutive slices of one component
+    sstride = (axis == 1) ? 1 : (axis == 2) ? (size_t) oz : npix;
+
+    for(s0 = 0; s0 < dy; s0 = s1)
     {
-        // Calculate the sin and cos values
-        // of the projection angle and find
-        // at which quadrant on the cartesian grid.
-        theta_p  = fmod(theta[p], 2 * M_PI);
-        quadrant = calc_quadrant(theta_p);
-        sin_p    = sinf(theta_p);
-        cos_p    = cosf(theta_p);
-
-        for(d = 0; d < dx; d++)
+        for(s1 = s0 + 1;
+            s1 < dy && s1 - s0 < nslab && center[s1] == center[s0]; s1++)
+            ;
+        ns = s1 - s0;
+
+        preprocessing(ox, oz, dx, center[s0], &mov, gridx,
+                      gridy);  // Outputs: mov, gridx, gridy
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
         {
-            // Calculate coordinates
-            xi = -ox - oz;
-            yi = (1 - dx) / 2.0 + d + mov;
-
-            srcx = xi * cos_p - yi * sin_p;
-            srcy = xi * sin_p + yi * cos_p;
-            detx = -xi * cos_p - yi * sin_p;
-            dety = -xi * sin_p + yi * cos_p;
-
-            dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-            vx = (srcx - detx) / dv;
-            vy = (srcy - dety) / dv;
-
-            calc_coords(ox, oz, xi, yi, sin_p, cos_p, gridx, gridy, coordx,
-                        coordy);
-
-            // Merge the (coordx, gridy) and (gridx, coordy)
-            trim_coords(ox, oz, coordx, coordy, gridx, gridy, &asize, ax, ay,
-                        &bsize, bx, by);
-
-            // Sort the array of intersection points (ax, ay) and
-            // (bx, by). The new sorted intersection points are
-            // stored in (coorx, coory). Total number of points
-            // are csize.
-            sort_intersections(quadrant, asize, ax, ay, bsize, bx, by, &csize,
-                               coorx, coory);
-
-            // Calculate the distances (dist) between the
-            // intersection points (coorx, coory). Find the
-            // indices of the pixels on the object grid.
-            calc_dist2(ox, oz, csize, coorx, coory, indx, indy, dist);
-
-            // For each slice
-            for(s = 0; s < dy; s++)
+            ray_buffers b;
+            float*      tile =
+                (float*) malloc((size_t) dx * ns * sizeof(float));
+            int         p, d, n, s, csize, quadrant;
+            long long   i;
+            float       theta_p, sin_p, cos_p, vx, vy;
+
+            ray_alloc(&b, ox, oz);
+
+#pragma omp for schedule(static)
+            for(i = 0; i < (long long) npix; i++)
+            {
+                // Grid pixel i = indx * oz + indy, see calc_dist
+                size_t indx = i / oz;
+                size_t indy = i % oz;
+                size_t off  = (axis == 1)   ? indx * oz + indy * npix
+                              : (axis == 2) ? indx + indy * npix
+                                            : (size_t) i;
+                float* col  = slab + (size_t) i * 2 * ns;
+                for(s = 0; s < ns; s++)
+                {
+                    col[s]      = c0[off + (s0 + s) * sstride];
+                    col[ns + s] = c1[off + (s0 + s) * sstride];
+                }
+            }
+
+            // For each projection angle
+#pragma omp for schedule(dynamic, 1)
+            for(p = 0; p < dt; p++)
             {
-                // Calculate simdata
-                calc_simdata2(s, p, d, ox, oz, dt, dx, csize, indx, indy, dist,
-                              vx, vy, objx, objy,
-                              data);  // Output: simulated data
+                theta_p  = fmod(theta[p], 2 * M_PI);
+                quadrant = calc_quadrant(theta_p);
+                sin_p    = sinf(theta_p);
+                cos_p    = cosf(theta_p);
+
+                // Unit vector from detector to source; the source sits at
+                // xi = -ox - oz < 0 on the rotated axis.
+                vx = -cos_p;
+                vy = -sin_p;
+
+                for(d = 0; d < dx; d++)
+                {
+                    float* acc = tile + (size_t) d * ns;
+                    csize = trace_ray(ox, oz, (1 - dx) / 2.0 + d + mov,
+                                      quadrant, sin_p, cos_p, gridx, gridy,
+                                      &b);
+                    for(s = 0; s < ns; s++)
+                        acc[s] = 0.0f;
+                    for(n = 0; n < csize - 1; n++)
+                    {
+                        const float* col = slab + (size_t) b.indi[n] * 2 * ns;
+                        const float  len = b.dist[n];
+#pragma omp simd
+                        for(s = 0; s < ns; s++)
+                            acc[s] += (col[s] * vx + col[ns + s] * vy) * len;
+                    }
+                }
+
+                // Simulated data, one detector row per slice
+                for(s = 0; s < ns; s++)
+                {
+                    float* row = data + (size_t)(s0 + s) * dt * dx +
+                                 (size_t) p * dx;
+                    for(d = 0; d < dx; d++)
+                        row[d] += tile[(size_t) d * ns + s];
+                }
             }
+
+            ray_free(&b);
+            free(tile);
         }
     }
 
     free(gridx);
     free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indi);
+    free(slab);
 }
 
+//============================================================================//
+
+void
+project2(const float* objx, const float* objy, int oy, int ox, int oz,
+         float* data, int dy, int dt, int dx, const float* center,
+         const float* theta, int ncore, int nchunk)
+{
+    (void) oy;
+    project_vector(objx, objy, 0, ox, oz, data, dy, dt, dx, center, theta,
+                   ncore, nchunk);
+}
+
+//============================================================================//
+
 void
 project3(const float* objx, const float* objy, const float* objz, int oy,
          int ox, int oz, float* data, int dy, int dt, int dx,
-         const float* center, const float* theta, int axis)
+         const float* center, const float* theta, int axis, int ncore,
+         int nchunk)
+{
+    (void) oy;
+    if(axis == 0)
+        project_vector(objx, objy, 0, ox, oz, data, dy, dt, dx, center,
+                       theta, ncore, nchunk);
+    else if(axis == 1)
+        project_vector(objy, objz, 1, ox, oz, data, dy, dt, dx, center,
+                       theta, ncore, nchunk);
+    else if(axis == 2)
+        project_vector(objx, objz, 2, ox, oz, data, dy, dt, dx, center,
+                       theta, ncore, nchunk);
+}
+
+//============================================================================//
+
+// Slices [k0, k1) of an oy-slice object that detector rows [r0, r0 + nr)
+// can reach, when z = v * ratio with ratio in [lo, hi].
+static void
+cone_slices(int r0, int nr, float vcenter, float lo, float hi, int oy,
+            int* k0, int* k1)
+{
+    float v0   = r0 + 0.5f - vcenter;
+    float v1   = r0 + nr - 0.5f - vcenter;
+    float zmin = fminf(fminf(v0 * lo, v0 * hi), fminf(v1 * lo, v1 * hi));
+    float zmax = fmaxf(fmaxf(v0 * lo, v0 * hi), fmaxf(v1 * lo, v1 * hi));
+    int   a    = (int) floorf(zmin + 0.5f * oy - 0.5f);
+    int   b    = (int) floorf(zmax + 0.5f * oy - 0.5f) + 2;
+
+    *k0 = (a < 0) ? 0 : (a > oy) ? oy : a;
+    *k1 = (b < *k0) ? *k0 : (b > oy) ? oy : b;
+}
+
+//============================================================================//
+
+// Cone-beam projection on a flat detector. Lengths are in voxels and the
+// detector is taken at the rotation axis (the virtual detector), so a
+// circular orbit is described by ``dist`` alone: the source-to-axis distance,
+// which equals the source-to-detector distance in detector pixels. Detector
+// column d and row r sit at u = d + 0.5 - center and v = r + 0.5 - vcenter,
+// and slice k of the object at z = k + 0.5 - oy / 2.
+//
+// Each fan ray is traced once through the (ox, oz) grid, then every
+// detector row of the chunk samples the [pixel][slice] slab along it,
+// interpolating linearly in z.
+void
+project_cone(const float* obj, int oy, int ox, int oz, float* data, int dy,
+             int dt, int dx, float center, float vcenter, const float* theta,
+             float dist, int ncore, int nchunk)
 {
-    float* gridx  = (float*) malloc((ox + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordx = (float*) malloc((oz + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ox + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* ay     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* bx     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* by     = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coorx  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* coory  = (float*) malloc((ox + oz + 2) * sizeof(float));
-    float* dist   = (float*) malloc((ox + oz + 1) * sizeof(float));
-    int*   indx   = (int*) malloc((ox + oz + 1) * sizeof(int));
-    int*   indy   = (int*) malloc((ox + oz + 1) * sizeof(int));
-    int*   indi   = (int*) malloc((ox + oz + 1) * sizeof(int));
-
-    assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
-           by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
-           dist != NULL && indi != NULL);
-
-    int   s, p, d;
-    int   quadrant;
-    float theta_p, sin_p, cos_p;
-    float srcx, srcy, detx, dety, dv, vx, vy;
-    float mov, xi, yi;
-    int   asize, bsize, csize;
-
-    preprocessing(ox, oz, dx, center[0], &mov, gridx,
-                  gridy);  // Outputs: mov, gridx, gridy
-
-    // For each projection angle
-    for(p = 0; p < dt; p++)
+    size_t npix  = (size_t) ox * oz;
+    float  rad   = 0.5f * sqrtf((float) ox * ox + (float) oz * oz);
+    float  umax  = fmaxf(fabsf(0.5f - center), fabsf(dx - 0.5f - center));
+    float  cgam  = dist / sqrtf(dist * dist + umax * umax);
+    float  lo    = fmaxf(0.0f, (dist * cgam - rad) * cgam / dist);
+    float  hi    = (dist + rad) / dist;
+    int    nrow  = (nchunk > 0 && nchunk < dy) ? nchunk : dy;
+    float* gridx = (float*) malloc((ox + 1) * sizeof(float));
+    float* gridy = (float*) malloc((oz + 1) * sizeof(float));
+    float* slab;
+    int    r0, nr, k0, k1, nk;
+    float  mov;
+
+    assert(gridx != NULL && gridy != NULL);
+
+    // The ray offsets are taken as in project(), with center folded into
+    // the column offset ``mov``.
+    preprocessing(ox, oz, dx, center, &mov, gridx, gridy);
+
+    if(nchunk <= 0)
+    {
+        // Bound the slab of slices a chunk of rows reads by 256 MB
+        nrow = slab_size(npix, oy) * lo / hi;
+        nrow = (nrow < 1) ? 1 : (nrow > dy) ? dy : nrow;
+    }
+    for(r0 = 0, nk = 0; r0 < dy; r0 += nrow)
     {
-        // Calculate the sin and cos values
-        // of the projection angle and find
-        // at which quadrant on the cartesian grid.
-        theta_p  = fmod(theta[p], 2 * M_PI);
-        quadrant = calc_quadrant(theta_p);
-        sin_p    = sinf(theta_p);
-        cos_p    = cosf(theta_p);
-
-        for(d = 0; d < dx; d++)
+        nr = (dy - r0 < nrow) ? dy - r0 : nrow;
+        cone_slices(r0, nr, vcenter, lo, hi, oy, &k0, &k1);
+        nk = (k1 - k0 > nk) ? k1 - k0 : nk;
+    }
+    slab = (float*) malloc(npix * (nk > 0 ? nk : 1) * sizeof(float));
+    assert(slab != NULL);
+
+    for(r0 = 0; r0 < dy; r0 += nr)
+    {
+        nr = (dy - r0 < nrow) ? dy - r0 : nrow;
+        cone_slices(r0, nr, vcenter, lo, hi, oy, &k0, &k1);
+        nk = k1 - k0;
+        if(nk == 0)
+            continue;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
         {
-            // Calculate coordinates
-            xi = -ox - oz;
-            yi = (1 - dx) / 2.0 + d + mov;
-
-            srcx = xi * cos_p - yi * sin_p;
-            srcy = xi * sin_p + yi * cos_p;
-            detx = -xi * cos_p - yi * sin_p;
-            dety = -xi * sin_p + yi * cos_p;
-
-            dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-            vx = (srcx - detx) / dv;
-            vy = (srcy - dety) / dv;
-
-            calc_coords(ox, oz, xi, yi, sin_p, cos_p, gridx, gridy, coordx,
-                        coordy);
-
-            // Merge the (coordx, gridy) and (gridx, coordy)
-            trim_coords(ox, oz, coordx, coordy, gridx, gridy, &asize, ax, ay,
-                        &bsize, bx, by);
-
-            // Sort the array of intersection points (ax, ay) and
-            // (bx, by). The new sorted intersection points are
-            // stored in (coorx, coory). Total number of points
-            // are csize.
-            sort_intersections(quadrant, asize, ax, ay, bsize, bx, by, &csize,
-                               coorx, coory);
-
-            // Calculate the distances (dist) between the
-            // intersection points (coorx, coory). Find the
-            // indices of the pixels on the object grid.
-            calc_dist2(ox, oz, csize, coorx, coory, indx, indy, dist);
-
-            // For each slice
-            for(s = 0; s < dy; s++)
+            ray_buffers b;
+            float*      tile =
+                (float*) malloc((size_t) dx * nr * sizeof(float));
+            int         p, d, n, r, k, csize, quadrant;
+            long long   i;
+            float       theta_p, sin_p, cos_p, u, gam, len, cg;
+
+            ray_alloc(&b, ox, oz);
+
+#pragma omp for schedule(static)
+            for(i = 0; i < (long long) npix; i++)
+                for(k = 0; k < nk; k++)
+                    slab[i * nk + k] = obj[(size_t)(k0 + k) * npix + i];
+
+            // For each projection angle
+#pragma omp for schedule(dynamic, 1)
+            for(p = 0; p < dt; p++)
             {
-                // Calculate simdata
-                calc_simdata3(s, p, d, ox, oz, dt, dx, csize, indx, indy, dist,
-                              vx, vy, objx, objy, objz, axis,
-                              data);  // Output: simulated data
+                for(d = 0; d < dx; d++)
+                {
+                    float* acc = tile + (size_t) d * nr;
+
+                    // The fan ray through column d is the parallel ray at
+                    // angle theta + gam and offset dist * sin(gam).
+                    u       = (1 - dx) / 2.0 + d + mov;
+                    gam     = atan2f(u, dist);
+                    theta_p = fmod(theta[p] + gam, 2 * M_PI);
+                    if(theta_p < 0)
+                        theta_p += 2 * M_PI;
+                    quadrant = calc_quadrant(theta_p);
+                    sin_p    = sinf(theta_p);
+                    cos_p    = cosf(theta_p);
+                    cg       = cosf(gam);
+                    len      = sqrtf(dist * dist + u * u);
+
+                    csize = trace_ray(ox, oz, dist * sinf(gam), quadrant,
+                                      sin_p, cos_p, gridx, gridy, &b);
+                    for(r = 0; r < nr; r++)
+                        acc[r] = 0.0f;
+                    for(n = 0; n < csize - 1; n++)
+                    {
+                        const float* col = slab + (size_t) b.indi[n] * nk;
+                        // In-plane distance from the source to the segment
+                        float mx = 0.5f * (b.coorx[n] + b.coorx[n + 1]);
+                        float my = 0.5f * (b.coory[n] + b.coory[n + 1]);
+                        float ratio =
+                            (mx * cos_p + my * sin_p + dist * cg) / len;
+                        float seg   = b.dist[n];
+
+                        for(r = 0; r < nr; r++)
+                        {
+                            float fz = (r0 + r + 0.5f - vcenter) * ratio +
+                                       0.5f * oy - 0.5f - k0;
+                            int   kz = (int) floorf(fz);
+                            float w  = fz - kz;
+                            float val = 0.0f;
+                            if(kz >= 0 && kz < nk)
+                                val += (1.0f - w) * col[kz];
+                            if(kz + 1 >= 0 && kz + 1 < nk)
+                                val += w * col[kz + 1];
+                            acc[r] += val * seg;
+                        }
+                    }
+
+                    // Stretch the in-plane lengths along the tilted ray
+                    for(r = 0; r < nr; r++)
+                    {
+                        float v = r0 + r + 0.5f - vcenter;
+                        acc[r] *= sqrtf(len * len + v * v) / len;
+                    }
+                }
+
+                // Simulated data, one detector row at a time
+                for(r = 0; r < nr; r++)
+                {
+                    float* row = data + (size_t)(r0 + r) * dt * dx +
+                                 (size_t) p * dx;
+                    for(d = 0; d < dx; d++)
+                        row[d] += tile[(size_t) d * nr + r];
+                }
             }
+
+            ray_free(&b);
+            free(tile);
         }
     }
 
     free(gridx);
     free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indi);
+    free(slab);
 }
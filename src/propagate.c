@@ -0,0 +1,330 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fft.h"
+#include "utils.h"
+#include <string.h>
+
+// Derivative along the rows of the dy x dz image ``f`` at row i, as
+// np.gradient: central differences inside, one-sided ones at the edges.
+static void
+gradient_rows(const float* f, int i, int dy, int dz, float h, float* out)
+{
+    int          lo = (i > 0) ? i - 1 : i;
+    int          hi = (i < dy - 1) ? i + 1 : i;
+    const float* a  = f + (size_t) lo * dz;
+    const float* b  = f + (size_t) hi * dz;
+    float        s  = (hi > lo) ? 1.0f / (h * (hi - lo)) : 0.0f;
+    int          j;
+
+#pragma omp simd
+    for(j = 0; j < dz; j++)
+        out[j] = (b[j] - a[j]) * s;
+}
+
+//============================================================================//
+
+// Derivative along one row of dz samples, as np.gradient.
+static void
+gradient_cols(const float* row, int dz, float h, float* out)
+{
+    int j;
+
+    if(dz < 2)
+    {
+        out[0] = 0.0f;
+        return;
+    }
+    out[0]      = (row[1] - row[0]) / h;
+    out[dz - 1] = (row[dz - 1] - row[dz - 2]) / h;
+#pragma omp simd
+    for(j = 1; j < dz - 1; j++)
+        out[j] = (row[j + 1] - row[j - 1]) * (0.5f / h);
+}
+
+//============================================================================//
+
+// Frequency of FFT bin i of n samples spaced h apart, as np.fft.fftfreq.
+static double
+fft_freq(int i, int n, double h)
+{
+    return ((i < (n + 1) / 2) ? i : i - n) / (n * h);
+}
+
+//============================================================================//
+
+// Transport of intensity, I = exp(-mu) + dist * div(exp(-mu) grad(delta)),
+// for ``dx`` projections of dy x dz pixels. Projections are spread over
+// ``ncore`` threads.
+void
+propagate_tie(const float* mu, const float* delta, float* out, int dx, int dy,
+              int dz, float pixel_size, float dist, int ncore)
+{
+    size_t npix = (size_t) dy * dz;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float* i1   = (float*) malloc(npix * sizeof(float));
+        float* gx   = (float*) malloc(npix * sizeof(float));
+        float* gy   = (float*) malloc(npix * sizeof(float));
+        float* row  = (float*) malloc(dz * sizeof(float));
+        int    m, i, j;
+        size_t k;
+
+        assert(i1 != NULL && gx != NULL && gy != NULL && row != NULL);
+
+        // For each projection.
+#pragma omp for schedule(dynamic, 1)
+        for(m = 0; m < dx; m++)
+        {
+            const float* mu_m    = mu + (size_t) m * npix;
+            const float* delta_m = delta + (size_t) m * npix;
+            float*       out_m   = out + (size_t) m * npix;
+
+            for(k = 0; k < npix; k++)
+                i1[k] = expf(-mu_m[k]);
+
+            // Intensity-weighted phase gradient
+            for(i = 0; i < dy; i++)
+            {
+                float*       gx_i = gx + (size_t) i * dz;
+                float*       gy_i = gy + (size_t) i * dz;
+                const float* i1_i = i1 + (size_t) i * dz;
+
+                gradient_rows(delta_m, i, dy, dz, pixel_size, gx_i);
+                gradient_cols(delta_m + (size_t) i * dz, dz, pixel_size,
+                              gy_i);
+                for(j = 0; j < dz; j++)
+                {
+                    gx_i[j] *= i1_i[j];
+                    gy_i[j] *= i1_i[j];
+                }
+            }
+
+            // Its divergence
+            for(i = 0; i < dy; i++)
+            {
+                float*       out_i = out_m + (size_t) i * dz;
+                const float* i1_i  = i1 + (size_t) i * dz;
+
+                gradient_rows(gx, i, dy, dz, pixel_size, out_i);
+                gradient_cols(gy + (size_t) i * dz, dz, pixel_size, row);
+                for(j = 0; j < dz; j++)
+                    out_i[j] = i1_i[j] + dist * (out_i[j] + row[j]);
+            }
+        }
+
+        free(i1);
+        free(gx);
+        free(gy);
+        free(row);
+    }
+}
+
+//============================================================================//
+
+// Fresnel propagation of the exit wave exp(-mu / 2 - i k delta), with
+// k = 2 pi / wavelength, over ``dist``; ``out`` is its intensity. The
+// propagator is computed once and both FFT plans are shared by the
+// ``ncore`` threads that the projections are spread over.
+void
+propagate_fresnel(const float* mu, const float* delta, float* out, int dx,
+                  int dy, int dz, float pixel_size, float dist,
+                  float wavelength, int ncore)
+{
+    size_t          npix   = (size_t) dy * dz;
+    float _Complex* kernel = fft_malloc_c(npix);
+    fft_plan*       fwd    = fft_plan_2d(dy, dz, FFT_FORWARD);
+    fft_plan*       bwd    = fft_plan_2d(dy, dz, FFT_BACKWARD);
+    const float     k      = 2.0 * M_PI / wavelength;
+    int             i, j;
+
+    assert(kernel != NULL);
+
+    // exp(-i pi wavelength dist f^2), with the 1 / npix of the inverse
+    for(i = 0; i < dy; i++)
+    {
+        double fy = fft_freq(i, dy, pixel_size);
+        for(j = 0; j < dz; j++)
+        {
+            double fz    = fft_freq(j, dz, pixel_size);
+            double phase = -M_PI * wavelength * dist * (fy * fy + fz * fz);
+            kernel[(size_t) i * dz + j] =
+                (float) (cos(phase) / npix) + I * (float) (sin(phase) / npix);
+        }
+    }
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float _Complex* psi = fft_malloc_c(npix);
+        int             m;
+        size_t          p;
+
+        assert(psi != NULL);
+
+        // For each projection.
+#pragma omp for schedule(dynamic, 1)
+        for(m = 0; m < dx; m++)
+        {
+            const float* mu_m    = mu + (size_t) m * npix;
+            const float* delta_m = delta + (size_t) m * npix;
+            float*       out_m   = out + (size_t) m * npix;
+
+            for(p = 0; p < npix; p++)
+            {
+                float amp = expf(-0.5f * mu_m[p]);
+                float phi = -k * delta_m[p];
+                psi[p]    = amp * cosf(phi) + I * (amp * sinf(phi));
+            }
+
+            fft_execute(fwd, psi);
+            for(p = 0; p < npix; p++)
+                psi[p] *= kernel[p];
+            fft_execute(bwd, psi);
+
+            for(p = 0; p < npix; p++)
+                out_m[p] = crealf(psi[p]) * crealf(psi[p]) +
+                           cimagf(psi[p]) * cimagf(psi[p]);
+        }
+
+        fft_free(psi);
+    }
+
+    fft_destroy(fwd);
+    fft_destroy(bwd);
+    fft_free(kernel);
+}
+
+//============================================================================//
+
+// Intensity of a sx x sy probe raster-scanned over ``nproj`` projections of
+// px x py pixels, with upper-left scan corners x[a], y[b]. Image
+// (m, a * ny + b) of ``out`` is |probe * window|^2 in the near field, or the
+// squared modulus of its centered 2D FFT in the far field (``far`` set).
+// With ``cplx`` set, probe and proj are complex64 stored as (re, im) pairs.
+// All scan positions of all projections are spread over ``ncore`` threads.
+void
+calc_intensity(const float* probe, int sx, int sy, const float* proj,
+               int nproj, int px, int py, const int* x, int nx, const int* y,
+               int ny, int cplx, int far, float* out, int ncore)
+{
+    size_t    nimg = (size_t) sx * sy;
+    long long npos = (long long) nproj * nx * ny;
+    fft_plan* fwd  = (far) ? fft_plan_2d(sx, sy, FFT_FORWARD) : NULL;
+    const float _Complex* cprobe = (const float _Complex*) probe;
+    const float _Complex* cproj  = (const float _Complex*) proj;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float _Complex* buf = (far) ? fft_malloc_c(nimg) : NULL;
+        long long       n;
+        int             i, j;
+
+        assert(!far || buf != NULL);
+
+        // For each scan position.
+#pragma omp for schedule(dynamic, 16)
+        for(n = 0; n < npos; n++)
+        {
+            int    m   = (int) (n / ((long long) nx * ny));
+            int    a   = (int) ((n / ny) % nx);
+            int    b   = (int) (n % ny);
+            size_t w0  = (size_t) m * px * py + (size_t) x[a] * py + y[b];
+            float* img = out + (size_t) n * nimg;
+
+            if(!far)
+            {
+                for(i = 0; i < sx; i++)
+                    for(j = 0; j < sy; j++)
+                    {
+                        size_t w = w0 + (size_t) i * py + j;
+                        if(cplx)
+                        {
+                            float _Complex v = cprobe[i * sy + j] * cproj[w];
+                            img[i * sy + j] =
+                                crealf(v) * crealf(v) + cimagf(v) * cimagf(v);
+                        }
+                        else
+                        {
+                            float v = probe[i * sy + j] * proj[w];
+                            img[i * sy + j] = v * v;
+                        }
+                    }
+                continue;
+            }
+
+            if(cplx)
+            {
+                for(i = 0; i < sx; i++)
+                    for(j = 0; j < sy; j++)
+                        buf[i * sy + j] = cprobe[i * sy + j] *
+                                          cproj[w0 + (size_t) i * py + j];
+            }
+            else
+            {
+                for(i = 0; i < sx; i++)
+                    for(j = 0; j < sy; j++)
+                        buf[i * sy + j] =
+                            probe[i * sy + j] * proj[w0 + (size_t) i * py + j];
+            }
+
+            fft_execute(fwd, buf);
+
+            // Squared modulus, with the zero frequency moved to the center
+            for(i = 0; i < sx; i++)
+            {
+                float* dst = img + (size_t)((i + sx / 2) % sx) * sy;
+                for(j = 0; j < sy; j++)
+                {
+                    float _Complex f = buf[i * sy + j];
+                    dst[(j + sy / 2) % sy] =
+                        crealf(f) * crealf(f) + cimagf(f) * cimagf(f);
+                }
+            }
+        }
+
+        fft_free(buf);
+    }
+
+    fft_destroy(fwd);
+}
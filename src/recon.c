@@ -0,0 +1,257 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "affinity.h"
+#include "gridrec.h"
+#include "profile.h"
+#include "utils.h"
+#include <string.h>
+
+typedef enum
+{
+    RECON_ART,
+    RECON_BART,
+    RECON_FBP,
+    RECON_GRAD,
+    RECON_GRIDREC,
+    RECON_MLEM,
+    RECON_OSEM,
+    RECON_OSPML_HYBRID,
+    RECON_OSPML_QUAD,
+    RECON_PML_HYBRID,
+    RECON_PML_HYBRID3D,
+    RECON_PML_QUAD,
+    RECON_SIRT,
+    RECON_TV,
+    RECON_TV3D,
+    RECON_UNKNOWN
+} recon_method;
+
+static const char* recon_names[] = {
+    "art",          "bart",       "fbp",          "grad",
+    "gridrec",      "mlem",       "osem",         "ospml_hybrid",
+    "ospml_quad",   "pml_hybrid", "pml_hybrid3d", "pml_quad",
+    "sirt",         "tv",         "tv3d"
+};
+
+static recon_method
+recon_lookup(const char* name)
+{
+    int m;
+    for(m = 0; m < RECON_UNKNOWN; m++)
+        if(strcmp(name, recon_names[m]) == 0)
+            return (recon_method) m;
+    return RECON_UNKNOWN;
+}
+
+//============================================================================//
+
+// Reconstruct chunk ``c`` of ``nchunk`` slices of the volume, first filling
+// its part of ``recon`` with ``*init`` from the calling thread when given.
+static void
+recon_chunk(recon_method method, const float* data, const uint16_t* raw,
+            const float* flat, const float* dark, int c, int nchunk, int dy,
+            int dt, int dx, const float* center, const float* theta,
+            float* recon, int ngridx, int ngridy, int num_iter,
+            const float* reg_pars, int num_block, const float* ind_block,
+            const char* fname, const float* filter_par, int npad,
+            int pad_mode, const float* init)
+{
+    int          s0   = c * nchunk;
+    int          ny   = (dy - s0 < nchunk) ? dy - s0 : nchunk;
+    size_t       npix = (size_t) ngridx * ngridy;
+    const float* d    = (data) ? data + (size_t) s0 * dt * dx : NULL;
+    const float* cn   = center + s0;
+    float*       r    = recon + (size_t) s0 * npix;
+    size_t       i;
+
+    PROFILE_START(t_chunk);
+
+    if(init)
+        for(i = 0; i < ny * npix; i++)
+            r[i] = *init;
+
+    switch(method)
+    {
+        case RECON_ART:
+            art(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter);
+            break;
+        case RECON_BART:
+            bart(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter,
+                 num_block, ind_block);
+            break;
+        case RECON_FBP:
+            if(raw)
+                fbp_uint16(raw + (size_t) s0 * dt * dx, flat + s0 * dx,
+                           dark + s0 * dx, ny, dt, dx, cn, theta, r,
+                           ngridx, ngridy, fname, filter_par);
+            else
+                fbp(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, fname,
+                    filter_par);
+            break;
+        case RECON_GRAD:
+            grad(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter,
+                 reg_pars);
+            break;
+        case RECON_GRIDREC:
+            if(raw)
+                gridrec_uint16(raw + (size_t) s0 * dt * dx, flat + s0 * dx,
+                               dark + s0 * dx, ny, dt, dx, cn, theta, r,
+                               ngridx, ngridy, fname, filter_par, npad,
+                               pad_mode);
+            else
+                gridrec(d, ny, dt, dx, cn, theta, r, ngridx, ngridy,
+                        fname, filter_par, npad, pad_mode);
+            break;
+        case RECON_MLEM:
+            mlem(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter);
+            break;
+        case RECON_OSEM:
+            osem(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter,
+                 num_block, ind_block);
+            break;
+        case RECON_OSPML_HYBRID:
+            ospml_hybrid(d, ny, dt, dx, cn, theta, r, ngridx, ngridy,
+                         num_iter, reg_pars, num_block, ind_block);
+            break;
+        case RECON_OSPML_QUAD:
+            ospml_quad(d, ny, dt, dx, cn, theta, r, ngridx, ngridy,
+                       num_iter, reg_pars, num_block, ind_block);
+            break;
+        case RECON_PML_HYBRID:
+            pml_hybrid(d, ny, dt, dx, cn, theta, r, ngridx, ngridy,
+                       num_iter, reg_pars);
+            break;
+        case RECON_PML_QUAD:
+            pml_quad(d, ny, dt, dx, cn, theta, r, ngridx, ngridy,
+                     num_iter, reg_pars);
+            break;
+        case RECON_SIRT:
+            sirt(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter);
+            break;
+        case RECON_TV:
+            tv(d, ny, dt, dx, cn, theta, r, ngridx, ngridy, num_iter,
+               reg_pars);
+            break;
+        default: break;
+    }
+
+    PROFILE_STOP(t_chunk, "recon.chunk",
+                 sizeof(float) * ((size_t) ny * dt * dx + ny * npix));
+}
+
+//============================================================================//
+
+void
+recon_volume(const char* algorithm, const float* data, const uint16_t* raw,
+             const float* flat, const float* dark, int dy, int dt, int dx,
+             const float* center, const float* theta, float* recon, int ngridx,
+             int ngridy, int num_iter, const float* reg_pars, int num_block,
+             const float* ind_block, const char* fname,
+             const float* filter_par, int npad, int pad_mode,
+             const float* init, int ncore, int nchunk)
+{
+    recon_method method   = recon_lookup(algorithm);
+    int          nthreads = get_nthreads(ncore);
+    int          nchunks, c;
+
+    if(method == RECON_UNKNOWN || dy <= 0)
+        return;
+
+    if(method == RECON_TV3D || method == RECON_PML_HYBRID3D)
+    {
+        // Slices are coupled: the solver splits the volume over the threads
+        // itself, with halos between its blocks.
+        size_t npix = (size_t) ngridx * ngridy;
+        long long i;
+        if(init)
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+            for(i = 0; i < (long long) dy * npix; i++)
+                recon[i] = *init;
+        }
+        if(method == RECON_TV3D)
+            tv3d(data, dy, dt, dx, center, theta, recon, ngridx, ngridy,
+                 num_iter, reg_pars, ncore, nchunk);
+        else
+            pml_hybrid3d(data, dy, dt, dx, center, theta, recon, ngridx,
+                         ngridy, num_iter, reg_pars, ncore, nchunk);
+        return;
+    }
+
+    // gridrec reconstructs slices in pairs
+    nchunk  = volume_chunk(dy, nthreads, nchunk, method == RECON_GRIDREC);
+    nchunks = (dy + nchunk - 1) / nchunk;
+    if(nthreads > nchunks)
+        nthreads = nchunks;
+
+    if(get_numa_mode())
+    {
+        // one chunk per pinned thread, so recon and scratch are local
+#pragma omp parallel num_threads(nthreads)
+        {
+            int t = 0, nt = 1;
+#ifdef _OPENMP
+            t  = omp_get_thread_num();
+            nt = omp_get_num_threads();
+#endif
+            numa_pin(t, nt);
+#pragma omp for schedule(static, 1)
+            for(c = 0; c < nchunks; c++)
+                recon_chunk(method, data, raw, flat, dark, c, nchunk, dy, dt,
+                            dx, center, theta, recon, ngridx, ngridy, num_iter,
+                            reg_pars, num_block, ind_block, fname, filter_par,
+                            npad, pad_mode, init);
+            numa_unpin();
+        }
+    }
+    else
+    {
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+        for(c = 0; c < nchunks; c++)
+            recon_chunk(method, data, raw, flat, dark, c, nchunk, dy, dt, dx,
+                        center, theta, recon, ngridx, ngridy, num_iter,
+                        reg_pars, num_block, ind_block, fname, filter_par,
+                        npad, pad_mode, init);
+    }
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2015, UChicago Argonne, LLC. All rights reserved.
+
+// Copyright 2015. UChicago Argonne, LLC. This software was produced
+// under U.S. Government contract DE-AC02-06CH11357 for Argonne National
+// Laboratory (ANL), which is operated by UChicago Argonne, LLC for the
+// U.S. Department of Energy. The U.S. Government has rights to use,
+// reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR
+// UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR
+// ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is
+// modified to produce derivative works, such modified software should
+// be clearly marked, so as not to confuse it with the version available
+// from ANL.
+
+// Additionally, redistribution and use in source and binary forms, with
+// or without modification, are permitted provided that the following
+// conditions are met:
+
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in
+//       the documentation and/or other materials provided with the
+//       distribution.
+
+//     * Neither the name of UChicago Argonne, LLC, Argonne National
+//       Laboratory, ANL, the U.S. Government, nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago
+// Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "rotation.h"
+#include "fft.h"
+#include "utils.h"
+
+// Vo's metric is the masked mean of |fft2([sino; shift(fliplr(sino), s)])|.
+// Splitting the joined image into its two halves, the spectrum is
+// A + exp(-2 pi i k s / ncol) B, where A and B are the spectra of the
+// zero-padded halves, so both are computed once per sinogram and each
+// candidate shift only costs a phase ramp over the masked coefficients. The
+// shift is circular and accurate to sub-pixel level.
+void
+vo_center_metric(const float* sino, int nsino, int nrow, int ncol,
+                 const float* mask, const float* shift, int nshift, int ncore,
+                 float* metric)
+{
+    int             n0   = 2 * nrow;
+    size_t          npix = (size_t) n0 * ncol;
+    size_t          nm;
+    int             u, k;
+    size_t*         idx;
+    size_t*         cidx;
+    float*          w;
+    int*            freq;
+    float _Complex* z;
+    float _Complex* a;
+    float _Complex* b;
+    fft_plan*       plan;
+
+    // Coefficients selected by the mask, which is given in fftshifted
+    // order, with the index of their Hermitian counterpart. These only
+    // depend on the shape and are shared by all sinograms.
+    idx  = (size_t*) malloc(npix * sizeof(size_t));
+    cidx = (size_t*) malloc(npix * sizeof(size_t));
+    w    = (float*) malloc(npix * sizeof(float));
+    freq = (int*) malloc(npix * sizeof(int));
+    nm   = 0;
+    for(u = 0; u < n0; u++)
+    {
+        for(k = 0; k < ncol; k++)
+        {
+            float wk = mask[(size_t)((u + n0 / 2) % n0) * ncol +
+                            (k + ncol / 2) % ncol];
+            if(wk == 0.0f)
+                continue;
+            idx[nm]  = (size_t) u * ncol + k;
+            cidx[nm] = (size_t)((n0 - u) % n0) * ncol + (ncol - k) % ncol;
+            w[nm]    = wk;
+            freq[nm] = (k < (ncol + 1) / 2) ? k : k - ncol;
+            nm++;
+        }
+    }
+
+    z    = fft_malloc_c(npix);
+    a    = (float _Complex*) malloc(nm * sizeof(float _Complex));
+    b    = (float _Complex*) malloc(nm * sizeof(float _Complex));
+    plan = fft_plan_2d(n0, ncol, FFT_FORWARD);
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        float _Complex* ramp;
+        float _Complex* rc;
+        const float*    sn;
+        const float*    sh;
+        size_t          m;
+        int             t, i, f, r, c;
+
+        ramp = (float _Complex*) malloc(ncol * sizeof(float _Complex));
+        rc   = ramp + ncol / 2;  // indexed by signed frequency
+
+        for(t = 0; t < nsino; t++)
+        {
+            sn = sino + (size_t) t * nrow * ncol;
+            sh = shift + (size_t) t * nshift;
+
+            // One complex transform carries both halves: the top half of
+            // the joined image goes in the real part, the flipped sinogram
+            // in the bottom half goes in the imaginary part.
+#pragma omp for schedule(static)
+            for(r = 0; r < nrow; r++)
+            {
+                for(c = 0; c < ncol; c++)
+                {
+                    z[(size_t) r * ncol + c] = sn[(size_t) r * ncol + c];
+                    z[(size_t)(r + nrow) * ncol + c] =
+                        I * sn[(size_t) r * ncol + ncol - 1 - c];
+                }
+            }
+
+#pragma omp single
+            fft_execute(plan, z);
+
+            // Separate A and B by Hermitian symmetry.
+#pragma omp for schedule(static)
+            for(m = 0; m < nm; m++)
+            {
+                float _Complex zp = z[idx[m]];
+                float _Complex zm = conjf(z[cidx[m]]);
+                a[m]              = 0.5f * (zp + zm);
+                b[m]              = -0.5f * I * (zp - zm);
+            }
+
+#pragma omp for schedule(dynamic, 1)
+            for(i = 0; i < nshift; i++)
+            {
+                double sum = 0.0;
+
+                for(f = -ncol / 2; f < ncol - ncol / 2; f++)
+                {
+                    double phase = -2.0 * M_PI * f * sh[i] / ncol;
+                    rc[f] = (float) cos(phase) + I * (float) sin(phase);
+                }
+                for(m = 0; m < nm; m++)
+                    sum += w[m] * cabsf(a[m] + rc[freq[m]] * b[m]);
+                metric[(size_t) t * nshift + i] = (float) (sum / npix);
+            }
+        }
+
+        free(ramp);
+    }
+
+    fft_destroy(plan);
+    fft_free(z);
+    free(a);
+    free(b);
+    free(idx);
+    free(cidx);
+    free(w);
+    free(freq);
+}
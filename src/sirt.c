@@ -41,6 +41,7 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -83,6 +84,7 @@ sirt(const float* data, int dy, int dt, int dx, const float* center,
         // For each slice
         for(s = 0; s < dy; s++)
         {
+            PROFILE_START(t_slice);
             preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
                           gridy);  // Outputs: mov, gridx, gridy
 
@@ -151,6 +153,10 @@ sirt(const float* data, int dy, int dt, int dx, const float* center,
                 }
             }
 
+            PROFILE_STOP(t_slice, "sirt.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
+            PROFILE_RESTART(t_slice);
+
             for(n = 0; n < ngridx * ngridy; n++)
             {
                 if(sum_dist[n] != 0.0f)
@@ -159,6 +165,8 @@ sirt(const float* data, int dy, int dt, int dx, const float* center,
                     recon[n + ind_recon] += update[n] / sum_dist[n];
                 }
             }
+            PROFILE_STOP(t_slice, "sirt.update",
+                         sizeof(float) * (size_t) ngridx * ngridy * 3);
 
             free(sum_dist);
             free(update);
@@ -42,60 +42,795 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "stripe.h"
+#include "fft.h"
+#include "utils.h"
+#include <string.h>
 
+// Slices are independent and spread over ``ncore`` threads in chunks of
+// ``nchunk`` slices.
 void
-remove_stripe_sf(float* data, int dx, int dy, int dz, int size, int istart,
-                 int iend)
+remove_stripe_sf(float* data, int dx, int dy, int dz, int size, int ncore,
+                 int nchunk)
 {
-    int    i, j, k, p, s;
-    float* avrage_row;
-    float* smooth_row;
-
-    // For each slice.
-    for(s = istart; s < iend; s++)
+#pragma omp parallel num_threads(get_nthreads(ncore))
     {
-        avrage_row = (float*) calloc(dz, sizeof(float));
-        smooth_row = (float*) calloc(dz, sizeof(float));
+        int    i, j, k, p, s;
+        float* avrage_row = (float*) malloc(dz * sizeof(float));
+        float* smooth_row = (float*) malloc(dz * sizeof(float));
 
-        // For each pixel.
-        for(j = 0; j < dz; j++)
+        // For each slice.
+#pragma omp for schedule(dynamic, (nchunk > 0) ? nchunk : 1)
+        for(s = 0; s < dy; s++)
         {
+            // For each pixel.
+            for(j = 0; j < dz; j++)
+            {
+                avrage_row[j] = 0.0f;
+                // For each projection.
+                for(p = 0; p < dx; p++)
+                {
+                    avrage_row[j] += data[j + s * dz + p * dy * dz] / dx;
+                }
+            }
+
+            // We have now computed the average row of the sinogram.
+            // Smooth it
+            for(i = 0; i < dz; i++)
+            {
+                smooth_row[i] = 0;
+                for(j = 0; j < size; j++)
+                {
+                    k = i + j - size / 2;
+                    if(k < 0)
+                        k = 0;
+                    if(k > dz - 1)
+                        k = dz - 1;
+                    smooth_row[i] += avrage_row[k];
+                }
+                smooth_row[i] /= size;
+            }
+
             // For each projection.
             for(p = 0; p < dx; p++)
             {
-                avrage_row[j] += data[j + s * dz + p * dy * dz] / dx;
+                // Subtract this difference from each row in sinogram.
+                for(j = 0; j < dz; j++)
+                {
+                    data[j + s * dz + p * dy * dz] -=
+                        (avrage_row[j] - smooth_row[j]);
+                }
             }
         }
 
-        // We have now computed the average row of the sinogram.
-        // Smooth it
-        for(i = 0; i < dz; i++)
+        free(avrage_row);
+        free(smooth_row);
+    }
+}
+
+//============================================================================//
+//
+//  Nghia Vo's stripe removal methods :cite:`Vo:18`
+//
+//  Each sinogram is gathered into a contiguous (dx, dz) work array, so rows
+//  are projections and columns are detector pixels. Slices are distributed
+//  over OpenMP threads; every thread owns its work arrays and FFT plans.
+//
+//============================================================================//
+
+#define RS_FILTER_PAD 150
+#define RS_FIT_PAD 50
+#define RS_FFT_BATCH 64
+
+typedef enum
+{
+    RS_SORT,
+    RS_FILTER,
+    RS_FIT,
+    RS_LARGE,
+    RS_DEAD,
+    RS_ALL
+} rs_method;
+
+typedef struct
+{
+    rs_method method;
+    int       size;
+    int       sm_size;
+    int       order;
+    float     snr;
+    float     sigma;
+    float     sigmax;
+    float     sigmay;
+} rs_params;
+
+typedef struct
+{
+    float value;
+    int   index;
+} rs_pair;
+
+typedef struct
+{
+    int             nrow;
+    int             ncol;
+    float*          sino;    // nrow x ncol
+    float*          tmp;     // nrow x ncol
+    float*          tmp2;    // nrow x ncol
+    int*            index;   // nrow x ncol, source row of each sorted value
+    rs_pair*        pairs;   // nrow
+    float*          lists;   // 4 x ncol
+    float*          window;  // median window
+    float*          aux;     // FFT windows and savgol coefficients
+    float _Complex* cbuf;    // FFT buffer, allocated on first use
+    fft_plan*       fwd;
+    fft_plan*       bwd;
+} rs_work;
+
+//============================================================================//
+
+static void
+rs_work_init(rs_work* work, int nrow, int ncol, int wsize)
+{
+    size_t npix = (size_t) nrow * ncol;
+    int    naux = 2 * (nrow + ncol) + 4 * (RS_FILTER_PAD + RS_FIT_PAD);
+
+    work->nrow   = nrow;
+    work->ncol   = ncol;
+    work->sino   = (float*) malloc(npix * sizeof(float));
+    work->tmp    = (float*) malloc(npix * sizeof(float));
+    work->tmp2   = (float*) malloc(npix * sizeof(float));
+    work->index  = (int*) malloc(npix * sizeof(int));
+    work->pairs  = (rs_pair*) malloc(nrow * sizeof(rs_pair));
+    work->lists  = (float*) malloc(4 * ncol * sizeof(float));
+    work->window = (float*) malloc((wsize > 0 ? wsize : 1) * sizeof(float));
+    work->aux    = (float*) malloc(naux * sizeof(float));
+    work->cbuf   = NULL;
+    work->fwd    = NULL;
+    work->bwd    = NULL;
+}
+
+//============================================================================//
+
+static void
+rs_work_free(rs_work* work)
+{
+    free(work->sino);
+    free(work->tmp);
+    free(work->tmp2);
+    free(work->index);
+    free(work->pairs);
+    free(work->lists);
+    free(work->window);
+    free(work->aux);
+    fft_destroy(work->fwd);
+    fft_destroy(work->bwd);
+    if(work->cbuf)
+        fft_free(work->cbuf);
+}
+
+//============================================================================//
+
+static int
+compare_floats(const void* a, const void* b)
+{
+    float fa = *(const float*) a;
+    float fb = *(const float*) b;
+    return (fa > fb) - (fa < fb);
+}
+
+static int
+compare_pairs(const void* a, const void* b)
+{
+    const rs_pair* pa = (const rs_pair*) a;
+    const rs_pair* pb = (const rs_pair*) b;
+    if(pa->value < pb->value)
+        return -1;
+    if(pa->value > pb->value)
+        return 1;
+    return pa->index - pb->index;
+}
+
+// Sort column j of sino in ascending order into work->pairs.
+static void
+sort_column(const rs_work* work, const float* sino, int j)
+{
+    int r;
+    for(r = 0; r < work->nrow; r++)
+    {
+        work->pairs[r].value = sino[r * work->ncol + j];
+        work->pairs[r].index = r;
+    }
+    qsort(work->pairs, work->nrow, sizeof(rs_pair), compare_pairs);
+}
+
+// Sort every column of sino into ``sorted`` and record in work->index the
+// source row of each sorted value.
+static void
+sort_columns(rs_work* work, const float* sino, float* sorted)
+{
+    int nrow = work->nrow, ncol = work->ncol;
+    int r, j;
+    for(j = 0; j < ncol; j++)
+    {
+        sort_column(work, sino, j);
+        for(r = 0; r < nrow; r++)
+        {
+            sorted[r * ncol + j]      = work->pairs[r].value;
+            work->index[r * ncol + j] = work->pairs[r].index;
+        }
+    }
+}
+
+//============================================================================//
+
+// Algorithm 4 in the paper. Used to locate stripes; ``buf`` holds n floats.
+static void
+detect_stripe(const float* list, float* mask, int n, float snr, float* buf)
+{
+    int    ndrop = (int) (0.25 * n);
+    int    i, m;
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    double slope, intercept, numt1, noise, val1, val2;
+
+    for(i = 0; i < n; i++)
+        mask[i] = 0.0f;
+
+    // Fit a line to the middle of the list sorted in descending order
+    for(i = 0; i < n; i++)
+        buf[i] = -list[i];
+    qsort(buf, n, sizeof(float), compare_floats);
+    m = n - 2 * ndrop - 1;
+    if(m < 2)
+        return;
+    for(i = ndrop; i < ndrop + m; i++)
+    {
+        double y = -buf[i];
+        sx += i;
+        sy += y;
+        sxx += (double) i * i;
+        sxy += i * y;
+    }
+    slope     = (m * sxy - sx * sy) / (m * sxx - sx * sx);
+    intercept = (sy - slope * sx) / m;
+
+    numt1 = intercept + slope * (n - 1);
+    noise = fabs(numt1 - intercept);
+    val1  = fabs(-buf[0] - intercept) / noise;
+    val2  = fabs(-buf[n - 1] - numt1) / noise;
+    if(val1 >= snr)
+    {
+        double upper = intercept + noise * snr * 0.5;
+        for(i = 0; i < n; i++)
+            if(list[i] > upper)
+                mask[i] = 1.0f;
+    }
+    if(val2 >= snr)
+    {
+        double lower = numt1 - noise * snr * 0.5;
+        for(i = 0; i < n; i++)
+            if(list[i] <= lower)
+                mask[i] = 1.0f;
+    }
+}
+
+// Binary dilation with a [1, 1, 1] structure.
+static void
+dilate_mask(const float* in, float* out, int n)
+{
+    int i;
+    for(i = 0; i < n; i++)
+    {
+        out[i] = (in[i] > 0.0f || (i > 0 && in[i - 1] > 0.0f) ||
+                  (i < n - 1 && in[i + 1] > 0.0f))
+                     ? 1.0f
+                     : 0.0f;
+    }
+}
+
+//============================================================================//
+
+// Algorithm 3 in the paper. Remove stripes using the sorting technique.
+static void
+rs_sort(rs_work* work, int size)
+{
+    int nrow = work->nrow, ncol = work->ncol;
+    int r, j;
+
+    sort_columns(work, work->sino, work->tmp);
+    median_filter_2d(work->tmp, work->tmp2, nrow, ncol, 1, size,
+                     work->window);
+    for(r = 0; r < nrow; r++)
+        for(j = 0; j < ncol; j++)
+            work->sino[work->index[r * ncol + j] * ncol + j] =
+                work->tmp2[r * ncol + j];
+}
+
+//============================================================================//
+
+// Algorithm 2 in the paper. Remove stripes using the filtering technique.
+static void
+rs_filter(rs_work* work, float sigma, int size)
+{
+    int    nrow = work->nrow, ncol = work->ncol;
+    int    pad = RS_FILTER_PAD;
+    int    n = nrow + 2 * pad;
+    int    nbatch = (ncol < RS_FFT_BATCH) ? ncol : RS_FFT_BATCH;
+    float* window = work->aux;
+    float  center = 0.5f * (n - 1);
+    int    j0, j, m, r;
+
+    if(work->cbuf == NULL)
+    {
+        work->cbuf = fft_malloc_c((size_t) n * nbatch);
+        work->fwd  = fft_plan_1d(n, nbatch, FFT_FORWARD);
+        work->bwd  = fft_plan_1d(n, nbatch, FFT_BACKWARD);
+    }
+
+    // Gaussian window centered on the sign-shifted spectrum, with the
+    // inverse transform normalization folded in
+    for(m = 0; m < n; m++)
+    {
+        float t   = (m - center) / sigma;
+        window[m] = expf(-0.5f * t * t) / n;
+    }
+
+    // Low-pass every column of the mirror-padded sinogram
+    for(j0 = 0; j0 < ncol; j0 += nbatch)
+    {
+        int nb = (ncol - j0 < nbatch) ? ncol - j0 : nbatch;
+        for(j = 0; j < nbatch; j++)
         {
-            smooth_row[i] = 0;
-            for(j = 0; j < size; j++)
+            float _Complex* col = work->cbuf + (size_t) j * n;
+            if(j >= nb)
             {
-                k = i + j - size / 2;
-                if(k < 0)
-                    k = 0;
-                if(k > dz - 1)
-                    k = dz - 1;
-                smooth_row[i] += avrage_row[k];
+                for(m = 0; m < n; m++)
+                    col[m] = 0.0f;
+                continue;
+            }
+            for(m = 0; m < n; m++)
+            {
+                float v = work->sino[mirror_index(m - pad, nrow) * ncol + j0 + j];
+                col[m]  = (m % 2) ? -v : v;
+            }
+        }
+        fft_execute(work->fwd, work->cbuf);
+        for(j = 0; j < nb; j++)
+        {
+            float _Complex* col = work->cbuf + (size_t) j * n;
+            for(m = 0; m < n; m++)
+                col[m] *= window[m];
+        }
+        fft_execute(work->bwd, work->cbuf);
+        for(j = 0; j < nb; j++)
+        {
+            float _Complex* col = work->cbuf + (size_t) j * n;
+            for(r = 0; r < nrow; r++)
+            {
+                float v = crealf(col[r + pad]);
+                work->tmp[r * ncol + j0 + j] = ((r + pad) % 2) ? -v : v;
             }
-            smooth_row[i] /= size;
         }
+    }
+
+    // Median filter the smooth part, keep the sharp part
+    median_filter_2d(work->tmp, work->tmp2, nrow, ncol, 1, size,
+                     work->window);
+    for(r = 0; r < nrow * ncol; r++)
+        work->sino[r] = work->tmp2[r] + (work->sino[r] - work->tmp[r]);
+}
+
+//============================================================================//
+
+// Savitzky-Golay smoothing coefficients for a window of 2 * half + 1 samples
+// and a polynomial of the given order, written to coef[0 .. 2 * half].
+static void
+savgol_coeffs(int half, int order, float* coef)
+{
+    int     np  = order + 1;
+    double* ata = (double*) malloc(np * (np + 1) * sizeof(double));
+    int     i, j, k, col;
 
-        // For each projection.
-        for(p = 0; p < dx; p++)
+#define ATA(i, j) ata[(i) * (np + 1) + (j)]
+
+    // Normal equations in coordinates scaled to [-1, 1], solved for the
+    // value of the fitted polynomial at the window center
+    for(i = 0; i < np; i++)
+    {
+        for(j = 0; j < np; j++)
         {
-            // Subtract this difference from each row in sinogram.
-            for(j = 0; j < dz; j++)
+            double s = 0.0;
+            for(k = -half; k <= half; k++)
             {
-                data[j + s * dz + p * dy * dz] -=
-                    (avrage_row[j] - smooth_row[j]);
+                double u = (half > 0) ? (double) k / half : 0.0;
+                s += pow(u, i + j);
             }
+            ATA(i, j) = s;
+        }
+        ATA(i, np) = (i == 0) ? 1.0 : 0.0;
+    }
+    for(col = 0; col < np; col++)
+    {
+        int    piv = col;
+        double f;
+        for(i = col + 1; i < np; i++)
+            if(fabs(ATA(i, col)) > fabs(ATA(piv, col)))
+                piv = i;
+        for(j = 0; j <= np; j++)
+        {
+            double t      = ATA(col, j);
+            ATA(col, j)   = ATA(piv, j);
+            ATA(piv, j)   = t;
         }
+        for(i = 0; i < np; i++)
+        {
+            if(i == col)
+                continue;
+            f = ATA(i, col) / ATA(col, col);
+            for(j = col; j <= np; j++)
+                ATA(i, j) -= f * ATA(col, j);
+        }
+    }
+    for(k = -half; k <= half; k++)
+    {
+        double u = (half > 0) ? (double) k / half : 0.0;
+        double s = 0.0;
+        for(i = 0; i < np; i++)
+            s += ATA(i, np) / ATA(i, i) * pow(u, i);
+        coef[k + half] = (float) s;
+    }
+#undef ATA
+    free(ata);
+}
 
-        free(avrage_row);
-        free(smooth_row);
+// Algorithm 1 in the paper. Remove stripes using the fitting technique.
+static void
+rs_fit(rs_work* work, int order, float sigmax, float sigmay)
+{
+    int     nrow = work->nrow, ncol = work->ncol;
+    int     pad = RS_FIT_PAD;
+    int     height = nrow + 2 * pad, width = ncol + 2 * pad;
+    int     nwin = (nrow % 2) ? nrow : nrow - 1;
+    int     half = nwin / 2;
+    float*  fit = work->tmp;
+    float*  smooth = work->tmp2;
+    float*  colmean = work->lists;
+    float*  winx = work->aux;
+    float*  winy = winx + width;
+    float*  coef = winy + height;
+    double  sum1 = 0.0, sum2 = 0.0;
+    float   scale;
+    int     r, j, k, x, y;
+
+    if(order >= nwin)
+        order = nwin - 1;
+    if(order < 0)
+        order = 0;
+
+    if(work->cbuf == NULL)
+    {
+        work->cbuf = fft_malloc_c((size_t) height * width);
+        work->fwd  = fft_plan_2d(height, width, FFT_FORWARD);
+        work->bwd  = fft_plan_2d(height, width, FFT_BACKWARD);
+    }
+
+    // Polynomial fit of every column with 'mirror' boundaries
+    savgol_coeffs(half, order, coef);
+    for(r = 0; r < nrow; r++)
+    {
+        float* out = fit + r * ncol;
+        for(j = 0; j < ncol; j++)
+            out[j] = 0.0f;
+        for(k = -half; k <= half; k++)
+        {
+            const float* row = work->sino + mirror_index(r + k, nrow) * ncol;
+            float        c   = coef[k + half];
+#pragma omp simd
+            for(j = 0; j < ncol; j++)
+                out[j] += c * row[j];
+        }
+    }
+
+    // 2D Gaussian low-pass of the fit, edge-padded along rows and padded
+    // with the column mean along columns
+    for(j = 0; j < ncol; j++)
+        colmean[j] = 0.0f;
+    for(r = 0; r < nrow; r++)
+        for(j = 0; j < ncol; j++)
+            colmean[j] += fit[r * ncol + j];
+    for(j = 0; j < ncol; j++)
+        colmean[j] /= nrow;
+    for(x = 0; x < width; x++)
+    {
+        float t = x - 0.5f * (width - 1);
+        winx[x] = expf(-t * t / (2.0f * sigmax * sigmax));
+    }
+    for(y = 0; y < height; y++)
+    {
+        float t = y - 0.5f * (height - 1);
+        winy[y] = expf(-t * t / (2.0f * sigmay * sigmay)) / (height * width);
+    }
+    for(y = 0; y < height; y++)
+    {
+        float _Complex* line = work->cbuf + (size_t) y * width;
+        int             in   = (y >= pad && y < pad + nrow);
+        const float*    row  = in ? fit + (y - pad) * ncol : colmean;
+        for(x = 0; x < width; x++)
+        {
+            int   xs = x - pad;
+            float v  = row[xs < 0 ? 0 : (xs >= ncol ? ncol - 1 : xs)];
+            line[x]  = ((x + y) % 2) ? -v : v;
+        }
+    }
+    fft_execute(work->fwd, work->cbuf);
+    for(y = 0; y < height; y++)
+    {
+        float _Complex* line = work->cbuf + (size_t) y * width;
+        for(x = 0; x < width; x++)
+            line[x] *= winx[x] * winy[y];
+    }
+    fft_execute(work->bwd, work->cbuf);
+    for(r = 0; r < nrow; r++)
+    {
+        y = r + pad;
+        for(j = 0; j < ncol; j++)
+        {
+            x = j + pad;
+            float v = crealf(work->cbuf[(size_t) y * width + x]);
+            smooth[r * ncol + j] = ((x + y) % 2) ? -v : v;
+        }
+    }
+
+    for(r = 0; r < nrow * ncol; r++)
+    {
+        sum1 += fit[r];
+        sum2 += smooth[r];
+    }
+    scale = (float) (sum1 / sum2);
+    for(r = 0; r < nrow * ncol; r++)
+        work->sino[r] = work->sino[r] / fit[r] * (scale * smooth[r]);
+}
+
+//============================================================================//
+
+// Algorithm 5 in the paper. Remove large stripes by: locating stripes,
+// normalizing to remove full stripes, using the sorting technique to remove
+// partial stripes.
+static void
+rs_large(rs_work* work, float snr, int size)
+{
+    int    nrow = work->nrow, ncol = work->ncol;
+    int    ndrop = (int) (0.05 * nrow);
+    float* sorted = work->tmp;
+    float* smoothed = work->tmp2;
+    float* fact = work->lists;
+    float* mask = fact + ncol;
+    float* dmask = mask + ncol;
+    float* buf = dmask + ncol;
+    int    r, j;
+
+    sort_columns(work, work->sino, sorted);
+    median_filter_2d(sorted, smoothed, nrow, ncol, 1, size, work->window);
+    for(j = 0; j < ncol; j++)
+    {
+        double sum1 = 0.0, sum2 = 0.0;
+        for(r = ndrop; r < nrow - ndrop; r++)
+        {
+            sum1 += sorted[r * ncol + j];
+            sum2 += smoothed[r * ncol + j];
+        }
+        fact[j] = (float) (sum1 / sum2);
+    }
+
+    // Locate stripes
+    detect_stripe(fact, mask, ncol, snr, buf);
+    dilate_mask(mask, dmask, ncol);
+
+    // Normalize
+    for(r = 0; r < nrow; r++)
+        for(j = 0; j < ncol; j++)
+            work->sino[r * ncol + j] /= fact[j];
+
+    // Replace stripe columns by the smoothed sorted values
+    for(j = 0; j < ncol; j++)
+    {
+        if(dmask[j] <= 0.0f)
+            continue;
+        sort_column(work, work->sino, j);
+        for(r = 0; r < nrow; r++)
+            work->sino[work->pairs[r].index * ncol + j] =
+                smoothed[r * ncol + j];
+    }
+}
+
+//============================================================================//
+
+// Algorithm 6 in the paper. Remove unresponsive and fluctuating stripes.
+static void
+rs_dead(rs_work* work, float snr, int size)
+{
+    int    nrow = work->nrow, ncol = work->ncol;
+    int    nuni = 10;
+    float* smoothed = work->tmp;
+    float* diff = work->lists;
+    float* mask = diff + ncol;
+    float* dmask = mask + ncol;
+    float* bck = dmask + ncol;
+    double nmean = 0.0;
+    int    r, j, k;
+
+    // Fluctuation of every column around its running mean
+    for(r = 0; r < nrow; r++)
+    {
+        float* out = smoothed + r * ncol;
+        for(j = 0; j < ncol; j++)
+            out[j] = 0.0f;
+        for(k = -nuni / 2; k < nuni - nuni / 2; k++)
+        {
+            const float* row = work->sino + reflect_index(r + k, nrow) * ncol;
+#pragma omp simd
+            for(j = 0; j < ncol; j++)
+                out[j] += row[j];
+        }
+        for(j = 0; j < ncol; j++)
+            out[j] /= nuni;
+    }
+    for(j = 0; j < ncol; j++)
+        diff[j] = 0.0f;
+    for(r = 0; r < nrow; r++)
+        for(j = 0; j < ncol; j++)
+            diff[j] += fabsf(work->sino[r * ncol + j] - smoothed[r * ncol + j]);
+    for(j = 0; j < ncol; j++)
+        nmean += diff[j];
+    nmean /= ncol;
+
+    median_filter_2d(diff, bck, 1, ncol, 1, size, work->window);
+    for(j = 0; j < ncol; j++)
+    {
+        if(bck[j] == 0.0f)
+            bck[j] = (float) nmean;
+        diff[j] /= bck[j];
+    }
+
+    // Locate stripes, never at the two outermost columns of each side
+    detect_stripe(diff, mask, ncol, snr, bck);
+    dilate_mask(mask, dmask, ncol);
+    for(j = 0; j < 2 && j < ncol; j++)
+    {
+        dmask[j]            = 0.0f;
+        dmask[ncol - 1 - j] = 0.0f;
+    }
+
+    // Linear interpolation across the stripe columns
+    for(j = 0; j < ncol; j++)
+    {
+        int   jl, jr;
+        float w;
+        if(dmask[j] <= 0.0f)
+            continue;
+        for(jl = j - 1; jl >= 0 && dmask[jl] > 0.0f; jl--)
+            ;
+        for(jr = j + 1; jr < ncol && dmask[jr] > 0.0f; jr++)
+            ;
+        if(jl < 0 || jr >= ncol)
+            continue;
+        w = (float) (j - jl) / (jr - jl);
+        for(r = 0; r < nrow; r++)
+        {
+            float* row = work->sino + r * ncol;
+            row[j]     = row[jl] + w * (row[jr] - row[jl]);
+        }
+    }
+
+    // Use algorithm 5 to remove residual stripes
+    rs_large(work, snr, size);
+}
+
+//============================================================================//
+
+static void
+rs_apply(rs_work* work, const rs_params* par)
+{
+    switch(par->method)
+    {
+        case RS_SORT: rs_sort(work, par->size); break;
+        case RS_FILTER: rs_filter(work, par->sigma, par->size); break;
+        case RS_FIT: rs_fit(work, par->order, par->sigmax, par->sigmay); break;
+        case RS_LARGE: rs_large(work, par->snr, par->size); break;
+        case RS_DEAD: rs_dead(work, par->snr, par->size); break;
+        case RS_ALL:
+            rs_dead(work, par->snr, par->size);
+            rs_sort(work, par->sm_size);
+            break;
+    }
+}
+
+// Apply a method to every slice, batching slices over ``ncore`` threads in
+// chunks of ``nchunk`` slices (defaults when not positive).
+static void
+remove_stripe_vo(float* data, int dx, int dy, int dz, const rs_params* par,
+                 int ncore, int nchunk)
+{
+    int wsize = (par->size > par->sm_size) ? par->size : par->sm_size;
+
+#pragma omp parallel num_threads(get_nthreads(ncore))
+    {
+        rs_work work;
+        int     s, p;
+
+        rs_work_init(&work, dx, dz, wsize);
+
+#pragma omp for schedule(dynamic, (nchunk > 0) ? nchunk : 1)
+        for(s = 0; s < dy; s++)
+        {
+            for(p = 0; p < dx; p++)
+                memcpy(work.sino + p * dz, data + s * dz + p * dy * dz,
+                       dz * sizeof(float));
+            rs_apply(&work, par);
+            for(p = 0; p < dx; p++)
+                memcpy(data + s * dz + p * dy * dz, work.sino + p * dz,
+                       dz * sizeof(float));
+        }
+
+        rs_work_free(&work);
     }
 }
+
+//============================================================================//
+
+void
+remove_stripe_based_sorting(float* data, int dx, int dy, int dz, int size,
+                            int ncore, int nchunk)
+{
+    rs_params par = { RS_SORT, size, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
+
+//============================================================================//
+
+void
+remove_stripe_based_filtering(float* data, int dx, int dy, int dz,
+                              float sigma, int size, int ncore, int nchunk)
+{
+    rs_params par = { RS_FILTER, size, 0, 0, 0.0f, sigma, 0.0f, 0.0f };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
+
+//============================================================================//
+
+void
+remove_stripe_based_fitting(float* data, int dx, int dy, int dz, int order,
+                            float sigmax, float sigmay, int ncore, int nchunk)
+{
+    rs_params par = { RS_FIT, 0, 0, order, 0.0f, 0.0f, sigmax, sigmay };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
+
+//============================================================================//
+
+void
+remove_large_stripe(float* data, int dx, int dy, int dz, float snr, int size,
+                    int ncore, int nchunk)
+{
+    rs_params par = { RS_LARGE, size, 0, 0, snr, 0.0f, 0.0f, 0.0f };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
+
+//============================================================================//
+
+void
+remove_dead_stripe(float* data, int dx, int dy, int dz, float snr, int size,
+                   int ncore, int nchunk)
+{
+    rs_params par = { RS_DEAD, size, 0, 0, snr, 0.0f, 0.0f, 0.0f };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
+
+//============================================================================//
+
+void
+remove_all_stripe(float* data, int dx, int dy, int dz, float snr, int la_size,
+                  int sm_size, int ncore, int nchunk)
+{
+    rs_params par = { RS_ALL, la_size, sm_size, 0, snr, 0.0f, 0.0f, 0.0f };
+    remove_stripe_vo(data, dx, dy, dz, &par, ncore, nchunk);
+}
@@ -41,6 +41,8 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "affinity.h"
+#include "profile.h"
 #include "utils.h"
 
 void
@@ -155,6 +157,7 @@ tv(const float* data, int dy, int dt, int dx, const float* center,
             // initialize sum_dist and update to zero
             memset(sum_dist, 0, (ngridx * ngridy) * sizeof(float));
 
+            PROFILE_START(t_slice);
             // For each projection angle
             for(p = 0; p < dt; p++)
             {
@@ -218,6 +221,9 @@ tv(const float* data, int dy, int dt, int dx, const float* center,
                                 r * prox1[ind_data] * dist[n];
                 }
             }
+            PROFILE_STOP(t_slice, "tv.project",
+                         sizeof(float) * (size_t) dt * dx * 2);
+            PROFILE_RESTART(t_slice);
 
             // copy recon = update
             memcpy(&recon[ind_recon], &update[ind_recon],
@@ -253,6 +259,8 @@ tv(const float* data, int dy, int dt, int dx, const float* center,
                     recon[ind_recon + iy * ngridx + ix] =
                         2 * update[ind_recon + iy * ngridx + ix] -
                         recon[ind_recon + iy * ngridx + ix];
+            PROFILE_STOP(t_slice, "tv.update",
+                         sizeof(float) * (size_t) ngridx * ngridy * 3);
         }
     }
 
@@ -285,3 +293,259 @@ tv(const float* data, int dy, int dt, int dx, const float* center,
     free(prox1);
     free(adjdata);
 }
+
+//============================================================================//
+
+// 3D total variation: the primal-dual iteration of tv() with the gradient
+// and its divergence taken along the slices too.
+//
+// Each thread owns contiguous blocks of ``nchunk`` slices (one block per
+// thread by default). An iteration runs in two phases separated by a
+// barrier: the dual step reads the first slice of the next block, and the
+// primal step reads prox0z of the last slice of the previous block. Those
+// halo slices are therefore always read as the neighbouring block left them
+// at the end of the previous phase.
+void
+tv3d(const float* data, int dy, int dt, int dx, const float* center,
+     const float* theta, float* recon, int ngridx, int ngridy, int num_iter,
+     const float* reg_pars, int ncore, int nchunk)
+{
+    size_t npix     = (size_t) ngridx * ngridy;
+    int    nthreads = get_nthreads(ncore);
+    int    nblock   = volume_chunk(dy, nthreads, nchunk, 0);
+    int    nblocks  = (dy + nblock - 1) / nblock;
+    float* update   = (float*) malloc(dy * npix * sizeof(float));
+    float* prox0x   = (float*) calloc(dy * npix, sizeof(float));
+    float* prox0y   = (float*) calloc(dy * npix, sizeof(float));
+    float* prox0z   = (float*) calloc(dy * npix, sizeof(float));
+    float* prox1    = (float*) calloc((size_t) dy * dt * dx, sizeof(float));
+
+    assert(update != NULL && prox0x != NULL && prox0y != NULL &&
+           prox0z != NULL && prox1 != NULL);
+
+    // regularization parameters
+    const float lambda = reg_pars[0];
+    const float c      = 0.35;
+
+    // scaling constant r such that r*R(r*R^*(data)) ~ data
+    const float r = 1 / sqrt(dx * dt / 2.0);
+
+    if(nthreads > nblocks)
+        nthreads = nblocks;
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        float* gridx   = (float*) malloc((ngridx + 1) * sizeof(float));
+        float* gridy   = (float*) malloc((ngridy + 1) * sizeof(float));
+        float* coordx  = (float*) malloc((ngridy + 1) * sizeof(float));
+        float* coordy  = (float*) malloc((ngridx + 1) * sizeof(float));
+        float* ax      = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* ay      = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* bx      = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* by      = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* coorx   = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* coory   = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        float* dist    = (float*) malloc((ngridx + ngridy) * sizeof(float));
+        int*   indi    = (int*) malloc((ngridx + ngridy) * sizeof(int));
+        float* simdata = (float*) malloc((size_t) dt * dx * sizeof(float));
+        float* adjdata = (float*) malloc(npix * sizeof(float));
+
+        assert(coordx != NULL && coordy != NULL && ax != NULL && ay != NULL &&
+               by != NULL && bx != NULL && coorx != NULL && coory != NULL &&
+               dist != NULL && indi != NULL && simdata != NULL &&
+               adjdata != NULL);
+
+        int    b, s, s1, p, d, i, n, ix, iy;
+        int    quadrant;
+        float  theta_p, sin_p, cos_p;
+        float  mov, xi, yi;
+        int    asize, bsize, csize;
+        double upd;
+        size_t ind_data;
+        float  sum_dist2;
+        size_t k;
+        int    t = 0, nt = 1;
+#ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+#endif
+        numa_pin(t, nt);
+
+        // scale initial guess
+#pragma omp for schedule(static, 1)
+        for(b = 0; b < nblocks; b++)
+        {
+            s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+            for(k = (size_t) b * nblock * npix; k < s1 * npix; k++)
+            {
+                recon[k] /= r;
+                update[k] = recon[k];
+            }
+        }
+
+        // Iterations
+        for(i = 0; i < num_iter; i++)
+        {
+            // compute proximal of the gradient in x, y and z directions
+            // prox0 = prox0+c*grad(recon);
+            // prox0 = prox0/max(1,abs(prox0)/lambda);
+#pragma omp for schedule(static, 1)
+            for(b = 0; b < nblocks; b++)
+            {
+                s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+                for(s = b * nblock; s < s1; s++)
+                    for(iy = 0; iy < ngridy - 1; iy++)
+                        for(ix = 0; ix < ngridx - 1; ix++)
+                        {
+                            k = s * npix + iy * ngridx + ix;
+                            prox0x[k] += c * (recon[k + 1] - recon[k]);
+                            prox0y[k] += c * (recon[k + ngridx] - recon[k]);
+                            if(s < dy - 1)
+                                prox0z[k] += c * (recon[k + npix] - recon[k]);
+                            upd = sqrt(prox0x[k] * prox0x[k] +
+                                       prox0y[k] * prox0y[k] +
+                                       prox0z[k] * prox0z[k]) /
+                                  lambda;
+                            upd = upd < 1 ? 1 : upd;
+                            prox0x[k] /= upd;
+                            prox0y[k] /= upd;
+                            prox0z[k] /= upd;
+                        }
+            }
+
+#pragma omp for schedule(static, 1)
+            for(b = 0; b < nblocks; b++)
+            {
+                s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+                for(s = b * nblock; s < s1; s++)
+                {
+                    float* rs = recon + s * npix;
+                    float* us = update + s * npix;
+
+                    // compute proximal of the projections
+                    // prox1 = 1*(prox1+c*R(recon)-c*data)/(1+c);
+                    preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
+                                  gridy);  // Outputs: mov, gridx, gridy
+
+                    memset(simdata, 0, (size_t) dt * dx * sizeof(float));
+                    memset(adjdata, 0, npix * sizeof(float));
+
+                    PROFILE_START(t_slice);
+                    // For each projection angle
+                    for(p = 0; p < dt; p++)
+                    {
+                        theta_p  = fmodf(theta[p], 2.0f * (float) M_PI);
+                        quadrant = calc_quadrant(theta_p);
+                        sin_p    = sinf(theta_p);
+                        cos_p    = cosf(theta_p);
+
+                        // For each detector pixel
+                        for(d = 0; d < dx; d++)
+                        {
+                            xi = -ngridx - ngridy;
+                            yi = 0.5f * (1 - dx) + d + mov;
+                            calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p,
+                                        gridx, gridy, coordx, coordy);
+                            trim_coords(ngridx, ngridy, coordx, coordy, gridx,
+                                        gridy, &asize, ax, ay, &bsize, bx, by);
+                            sort_intersections(quadrant, asize, ax, ay, bsize,
+                                               bx, by, &csize, coorx, coory);
+                            calc_dist(ngridx, ngridy, csize, coorx, coory,
+                                      indi, dist);
+
+                            // Calculate simdata
+                            calc_simdata(0, p, d, ngridx, ngridy, dt, dx,
+                                         csize, indi, dist, rs, simdata);
+
+                            ind_data = (size_t) s * dt * dx +
+                                       (size_t) p * dx + d;
+                            prox1[ind_data] =
+                                (prox1[ind_data] +
+                                 c * simdata[d + p * dx] * r -
+                                 c * data[ind_data]) /
+                                (1 + c);
+
+                            sum_dist2 = 0.0f;
+                            for(n = 0; n < csize - 1; n++)
+                                sum_dist2 += dist[n] * dist[n];
+
+                            // adjoint Radon of the prox1 for further
+                            // computations adjdata = R^*(prox1)
+                            if(sum_dist2 != 0.0f)
+                                for(n = 0; n < csize - 1; n++)
+                                    adjdata[indi[n]] +=
+                                        r * prox1[ind_data] * dist[n];
+                        }
+                    }
+                    PROFILE_STOP(t_slice, "tv3d.project",
+                                 sizeof(float) * (size_t) dt * dx * 2);
+                    PROFILE_RESTART(t_slice);
+
+                    // copy recon = update
+                    memcpy(rs, us, npix * sizeof(float));
+
+                    // backward step. update with the divergence of prox0 and
+                    // the adjoint of prox1
+                    // update = update-c*R^*(prox1)-c*div(prox0);
+                    for(iy = 0; iy < ngridy; iy++)
+                        for(ix = 0; ix < ngridx; ix++)
+                        {
+                            k = s * npix + iy * ngridx + ix;
+                            update[k] -= c * adjdata[iy * ngridx + ix];
+                            if(ix == 0)
+                                update[k] += c * prox0x[k];
+                            else
+                                update[k] += c * (prox0x[k] - prox0x[k - 1]);
+                            if(iy == 0)
+                                update[k] += c * prox0y[k];
+                            else
+                                update[k] +=
+                                    c * (prox0y[k] - prox0y[k - ngridx]);
+                            if(s == 0)
+                                update[k] += c * prox0z[k];
+                            else
+                                update[k] += c * (prox0z[k] - prox0z[k - npix]);
+                        }
+
+                    // update of recon
+                    // recon = 2*update - recon
+                    for(k = 0; k < npix; k++)
+                        rs[k] = 2 * us[k] - rs[k];
+                    PROFILE_STOP(t_slice, "tv3d.update",
+                                 sizeof(float) * (size_t) ngridx * ngridy * 3);
+                }
+            }
+        }
+
+        // scale result
+#pragma omp for schedule(static, 1)
+        for(b = 0; b < nblocks; b++)
+        {
+            s1 = (b * nblock + nblock < dy) ? b * nblock + nblock : dy;
+            for(k = (size_t) b * nblock * npix; k < s1 * npix; k++)
+                recon[k] *= r;
+        }
+
+        numa_unpin();
+        free(gridx);
+        free(gridy);
+        free(coordx);
+        free(coordy);
+        free(ax);
+        free(ay);
+        free(bx);
+        free(by);
+        free(coorx);
+        free(coory);
+        free(dist);
+        free(indi);
+        free(simdata);
+        free(adjdata);
+    }
+
+    free(update);
+    free(prox0x);
+    free(prox0y);
+    free(prox0z);
+    free(prox1);
+}
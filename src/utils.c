@@ -61,6 +61,49 @@ initlibtomopy(void)
 
 //============================================================================//
 
+static int num_threads = 0;
+
+void
+set_num_threads(int nthreads)
+{
+    num_threads = nthreads;
+}
+
+//============================================================================//
+
+int
+get_num_threads(void)
+{
+    if(num_threads <= 0)
+    {
+        const char* env = getenv("TOMOPY_NUM_THREADS");
+        int         n   = (env) ? atoi(env) : 0;
+#ifdef _OPENMP
+        if(n <= 0)
+            n = omp_get_max_threads();
+#else
+        if(n <= 0)
+            n = 1;
+#endif
+        num_threads = n;
+    }
+    return num_threads;
+}
+
+//============================================================================//
+
+int
+has_openmp(void)
+{
+#ifdef _OPENMP
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+//============================================================================//
+
 void
 preprocessing(int ry, int rz, int num_pixels, float center, float* mov,
               float* gridx, float* gridy)
@@ -457,3 +500,209 @@ calc_simdata3(int s, int p, int d, int ry, int rz, int dt, int dx, int csize,
 }
 
 //============================================================================//
+
+void
+ray_alloc(ray_buffers* b, int ox, int oz)
+{
+    b->coordx = (float*) malloc((oz + 1) * sizeof(float));
+    b->coordy = (float*) malloc((ox + 1) * sizeof(float));
+    b->ax     = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->ay     = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->bx     = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->by     = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->coorx  = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->coory  = (float*) malloc((ox + oz + 2) * sizeof(float));
+    b->dist   = (float*) malloc((ox + oz + 1) * sizeof(float));
+    b->indi   = (int*) malloc((ox + oz + 1) * sizeof(int));
+
+    assert(b->coordx != NULL && b->coordy != NULL && b->ax != NULL &&
+           b->ay != NULL && b->by != NULL && b->bx != NULL &&
+           b->coorx != NULL && b->coory != NULL && b->dist != NULL &&
+           b->indi != NULL);
+}
+
+//============================================================================//
+
+void
+ray_free(ray_buffers* b)
+{
+    free(b->coordx);
+    free(b->coordy);
+    free(b->ax);
+    free(b->ay);
+    free(b->bx);
+    free(b->by);
+    free(b->coorx);
+    free(b->coory);
+    free(b->dist);
+    free(b->indi);
+}
+
+//============================================================================//
+
+// Trace the ray at offset yi from the origin, at the angle given by
+// quadrant, sin_p and cos_p. Returns the number of intersection points,
+// left in (b->coorx, b->coory); the pixel indices and lengths of the
+// csize - 1 segments are left in b->indi and b->dist.
+int
+trace_ray(int ox, int oz, float yi, int quadrant, float sin_p, float cos_p,
+          const float* gridx, const float* gridy, ray_buffers* b)
+{
+    float xi = -ox - oz;
+    int   asize, bsize, csize;
+
+    calc_coords(ox, oz, xi, yi, sin_p, cos_p, gridx, gridy, b->coordx,
+                b->coordy);
+
+    // Merge the (coordx, gridy) and (gridx, coordy)
+    trim_coords(ox, oz, b->coordx, b->coordy, gridx, gridy, &asize, b->ax,
+                b->ay, &bsize, b->bx, b->by);
+
+    // Sort the array of intersection points (ax, ay) and (bx, by).
+    sort_intersections(quadrant, asize, b->ax, b->ay, bsize, b->bx, b->by,
+                       &csize, b->coorx, b->coory);
+
+    // Calculate the distances (dist) between the intersection points
+    // (coorx, coory) and the indices of the pixels they cross.
+    calc_dist(ox, oz, csize, b->coorx, b->coory, b->indi, b->dist);
+    return csize;
+}
+
+//============================================================================//
+
+// k-th smallest element of a, partially reorders a.
+float
+select_kth(float* a, int n, int k)
+{
+    int lo = 0, hi = n - 1;
+    while(lo < hi)
+    {
+        float pivot = a[k];
+        int   i = lo, j = hi;
+        while(i <= j)
+        {
+            while(a[i] < pivot)
+                i++;
+            while(a[j] > pivot)
+                j--;
+            if(i <= j)
+            {
+                float t = a[i];
+                a[i]    = a[j];
+                a[j]    = t;
+                i++;
+                j--;
+            }
+        }
+        if(j < k)
+            lo = i;
+        if(k < i)
+            hi = j;
+    }
+    return a[k];
+}
+
+// Median of a as np.median (mean of the two middle values for even n),
+// partially reorders a.
+float
+select_median(float* a, int n)
+{
+    float hi = select_kth(a, n, n / 2);
+    if(n % 2 == 0)
+    {
+        // select_kth leaves the lower half in a[0, n / 2)
+        float lo = a[0];
+        int   i;
+        for(i = 1; i < n / 2; i++)
+            if(a[i] > lo)
+                lo = a[i];
+        hi = 0.5f * (lo + hi);
+    }
+    return hi;
+}
+
+//============================================================================//
+
+// Median filter of a row-major (ny, nx) image with a (sy, sx) window and
+// 'reflect' boundaries, as scipy.ndimage.median_filter. ``window`` holds at
+// least sy * sx floats.
+void
+median_filter_2d(const float* in, float* out, int ny, int nx, int sy, int sx,
+                 float* window)
+{
+    int nwin = sy * sx;
+    int rank = nwin / 2;
+    int hy = sy / 2, hx = sx / 2;
+    int y, x, k, l;
+
+    for(y = 0; y < ny; y++)
+    {
+        for(x = 0; x < nx; x++)
+        {
+            int n = 0;
+            for(k = 0; k < sy; k++)
+            {
+                const float* row = in + reflect_index(y + k - hy, ny) * nx;
+                int          x0  = x - hx;
+                if(x0 >= 0 && x0 + sx <= nx)
+                {
+                    for(l = 0; l < sx; l++)
+                        window[n++] = row[x0 + l];
+                }
+                else
+                {
+                    for(l = 0; l < sx; l++)
+                        window[n++] = row[reflect_index(x0 + l, nx)];
+                }
+            }
+            out[y * nx + x] = select_kth(window, nwin, rank);
+        }
+    }
+}
+
+//============================================================================//
+
+void
+convert_raw_sinogram(const uint16_t* data, const float* flat,
+                     const float* dark, int s, int dt, int dx, float* out)
+{
+    const uint16_t* src = data + (size_t) s * dt * dx;
+    const float*    f   = flat + (size_t) s * dx;
+    const float*    d   = dark + (size_t) s * dx;
+    int             p, j;
+
+    for(p = 0; p < dt; p++)
+    {
+#pragma omp simd
+        for(j = 0; j < dx; j++)
+        {
+            float denom = f[j] - d[j];
+            if(denom < 1e-6f)
+                denom = 1e-6f;
+            out[j + p * dx] = -logf(((float) src[j + p * dx] - d[j]) / denom);
+        }
+    }
+}
+
+//============================================================================//
+
+void
+pad_row(const float* src, int n, int left, int right, int mode, float cval,
+        float* dst)
+{
+    int j;
+
+    for(j = 0; j < left; j++)
+    {
+        int i  = pad_index(j - left, n, mode);
+        dst[j] = (i < 0) ? cval : src[i];
+    }
+    memcpy(dst + left, src, n * sizeof(float));
+    for(j = 0; j < right; j++)
+    {
+        int i = pad_index(n + j, n, mode);
+        dst[left + n + j] = (i < 0) ? cval : src[i];
+    }
+}
+
+//============================================================================//
@@ -41,832 +41,469 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
-#include "utils.h"
-
-void
-vector(const float* data, int dy, int dt, int dx, const float* center,
-       const float* theta, float* recon1, float* recon2, int ngridx, int ngridy,
-       int num_iter)
-{
-    float* gridx  = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordx = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* ay     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* bx     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* by     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coorx  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coory  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* dist   = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    int*   indx   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-    int*   indy   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-
-    assert(gridx != NULL && gridy != NULL && coordx != NULL && coordy != NULL &&
-           ax != NULL && ay != NULL && by != NULL && bx != NULL &&
-           coorx != NULL && coory != NULL && dist != NULL && indx != NULL &&
-           indy != NULL);
-
-    int    s, p, d, i, n, m;
-    int    quadrant;
-    float  theta_p, sin_p, cos_p;
-    float  mov, xi, yi;
-    int    asize, bsize, csize;
-    float* simdata;
-    float  upd;
-    int    ind_data;
-    float  srcx, srcy, detx, dety, dv, vx, vy;
-    float* sum_dist;
-    float  sum_dist2;
-    float *update1, *update2;
-
-    for(i = 0; i < num_iter; i++)
-    {
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata2(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    recon1[n + m * ngridy + s * ngridx * ngridy] +=
-                        update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    recon2[n + m * ngridy + s * ngridx * ngridy] +=
-                        update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-    }
-
-    free(gridx);
-    free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indx);
-    free(indy);
-}
-
-void
-vector2(const float* data1, const float* data2, int dy, int dt, int dx,
-        const float* center1, const float* center2, const float* theta1,
-        const float* theta2, float* recon1, float* recon2, float* recon3,
-        int ngridx, int ngridy, int num_iter, int axis1, int axis2)
-{
-    float* gridx  = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordx = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* ay     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* bx     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* by     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coorx  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coory  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* dist   = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    int*   indx   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-    int*   indy   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-
-    assert(gridx != NULL && gridy != NULL && coordx != NULL && coordy != NULL &&
-           ax != NULL && ay != NULL && by != NULL && bx != NULL &&
-           coorx != NULL && coory != NULL && dist != NULL && indx != NULL &&
-           indy != NULL);
-
-    int    s, p, d, i, n, m;
-    int    quadrant;
-    float  theta_p, sin_p, cos_p;
-    float  mov, xi, yi;
-    int    asize, bsize, csize;
-    float* simdata;
-    float  upd;
-    int    ind_data;
-    float  srcx, srcy, detx, dety, dv, vx, vy;
-    float* sum_dist;
-    float  sum_dist2;
-    float *update1, *update2;
-
-    for(i = 0; i < num_iter; i++)
-    {
-        printf("iter=%d\n", i);
-
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center1[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta1[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata3(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2, recon3,
-                                  axis1,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data1[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    if(sum_dist[n + m * ngridy] != 0.0)
-                    {
-                        recon2[s + m * ngridy + n * ngridx * ngridy] +=
-                            update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                        recon3[s + m * ngridy + n * ngridx * ngridy] +=
-                            update2[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    }
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center1[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta1[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata3(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2, recon3,
-                                  axis2,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data2[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    if(sum_dist[n + m * ngridy] != 0.0)
-                    {
-                        recon1[m + s * ngridy + n * ngridx * ngridy] +=
-                            update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                        recon3[m + s * ngridy + n * ngridx * ngridy] +=
-                            update2[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    }
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-    }
-
-    free(gridx);
-    free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indx);
-    free(indy);
-}
-
-void
-vector3(const float* data1, const float* data2, const float* data3, int dy,
-        int dt, int dx, const float* center1, const float* center2,
-        const float* center3, const float* theta1, const float* theta2,
-        const float* theta3, float* recon1, float* recon2, float* recon3,
-        int ngridx, int ngridy, int num_iter, int axis1, int axis2, int axis3)
-{
-    float* gridx  = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* gridy  = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordx = (float*) malloc((ngridy + 1) * sizeof(float));
-    float* coordy = (float*) malloc((ngridx + 1) * sizeof(float));
-    float* ax     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* ay     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* bx     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* by     = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coorx  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* coory  = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    float* dist   = (float*) malloc((ngridx + ngridy) * sizeof(float));
-    int*   indx   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-    int*   indy   = (int*) malloc((ngridx + ngridy + 1) * sizeof(int));
-
-    assert(gridx != NULL && gridy != NULL && coordx != NULL && coordy != NULL &&
-           ax != NULL && ay != NULL && by != NULL && bx != NULL &&
-           coorx != NULL && coory != NULL && dist != NULL && indx != NULL &&
-           indy != NULL);
-
-    int    s, p, d, i, n, m;
-    int    quadrant;
-    float  theta_p, sin_p, cos_p;
-    float  mov, xi, yi;
-    int    asize, bsize, csize;
-    float* simdata;
-    float  upd;
-    int    ind_data;
-    float  srcx, srcy, detx, dety, dv, vx, vy;
-    float* sum_dist;
-    float  sum_dist2;
-    float *update1, *update2;
-
-    for(i = 0; i < num_iter; i++)
-    {
-        printf("iter=%d\n", i);
-
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center1[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta1[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata3(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2, recon3,
-                                  axis1,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data1[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    if(sum_dist[n + m * ngridy] != 0.0)
-                    {
-                        recon1[n + m * ngridy + s * ngridx * ngridy] +=
-                            update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                        recon2[n + m * ngridy + s * ngridx * ngridy] +=
-                            update2[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    }
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center1[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta1[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata3(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2, recon3,
-                                  axis2,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data2[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    if(sum_dist[n + m * ngridy] != 0.0)
-                    {
-                        recon2[s + m * ngridy + n * ngridx * ngridy] +=
-                            update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                        recon3[s + m * ngridy + n * ngridx * ngridy] +=
-                            update2[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    }
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-
-        simdata = (float*) calloc((dt * dy * dx), sizeof(float));
-
-        // For each slice
-        for(s = 0; s < dy; s++)
-        {
-            preprocessing(ngridx, ngridy, dx, center1[s], &mov, gridx,
-                          gridy);  // Outputs: mov, gridx, gridy
-
-            sum_dist = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update1  = (float*) calloc((ngridx * ngridy), sizeof(float));
-            update2  = (float*) calloc((ngridx * ngridy), sizeof(float));
-
-            // For each projection angle
-            for(p = 0; p < dt; p++)
-            {
-                // Calculate the sin and cos values
-                // of the projection angle and find
-                // at which quadrant on the cartesian grid.
-                theta_p  = fmod(theta1[p], 2 * M_PI);
-                quadrant = calc_quadrant(theta_p);
-                sin_p    = sinf(theta_p);
-                cos_p    = cosf(theta_p);
-
-                // For each detector pixel
-                for(d = 0; d < dx; d++)
-                {
-                    // Calculate coordinates
-                    xi = -ngridx - ngridy;
-                    yi = (1 - dx) / 2.0 + d + mov;
-
-                    srcx = xi * cos_p - yi * sin_p;
-                    srcy = xi * sin_p + yi * cos_p;
-                    detx = -xi * cos_p - yi * sin_p;
-                    dety = -xi * sin_p + yi * cos_p;
-
-                    dv = sqrt(pow(srcx - detx, 2) + pow(srcy - dety, 2));
-                    vx = (srcx - detx) / dv;
-                    vy = (srcy - dety) / dv;
-
-                    calc_coords(ngridx, ngridy, xi, yi, sin_p, cos_p, gridx,
-                                gridy, coordx, coordy);
-
-                    // Merge the (coordx, gridy) and (gridx, coordy)
-                    trim_coords(ngridx, ngridy, coordx, coordy, gridx, gridy,
-                                &asize, ax, ay, &bsize, bx, by);
-
-                    // Sort the array of intersection points (ax, ay) and
-                    // (bx, by). The new sorted intersection points are
-                    // stored in (coorx, coory). Total number of points
-                    // are csize.
-                    sort_intersections(quadrant, asize, ax, ay, bsize, bx, by,
-                                       &csize, coorx, coory);
-
-                    // Calculate the distances (dist) between the
-                    // intersection points (coorx, coory). Find the
-                    // indices of the pixels on the reconstruction grid.
-                    calc_dist2(ngridx, ngridy, csize, coorx, coory, indx, indy,
-                               dist);
-
-                    // Calculate simdata
-                    calc_simdata3(s, p, d, ngridx, ngridy, dt, dx, csize, indx,
-                                  indy, dist, vx, vy, recon1, recon2, recon3,
-                                  axis3,
-                                  simdata);  // Output: simdata
-
-                    // Calculate dist*dist
-                    sum_dist2 = 0.0;
-                    for(n = 0; n < csize - 1; n++)
-                    {
-                        sum_dist2 += dist[n] * dist[n];
-                        sum_dist[indy[n] + indx[n] * ngridy] += dist[n];
-                    }
-
-                    // Update
-                    if(sum_dist2 != 0.0)
-                    {
-                        ind_data = d + p * dx + s * dt * dx;
-                        upd = (data3[ind_data] - simdata[ind_data]) / sum_dist2;
-                        for(n = 0; n < csize - 1; n++)
-                        {
-                            update1[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vx;
-                            update2[indy[n] + indx[n] * ngridy] +=
-                                upd * dist[n] * vy;
-                        }
-                    }
-                }
-            }
-
-            for(m = 0; m < ngridx; m++)
-            {
-                for(n = 0; n < ngridy; n++)
-                {
-                    if(sum_dist[n + m * ngridy] != 0.0)
-                    {
-                        recon1[m + s * ngridy + n * ngridx * ngridy] +=
-                            update1[n + m * ngridy] / sum_dist[n + m * ngridy];
-                        recon3[m + s * ngridy + n * ngridx * ngridy] +=
-                            update2[n + m * ngridy] / sum_dist[n + m * ngridy];
-                    }
-                }
-            }
-
-            free(sum_dist);
-            free(update1);
-            free(update2);
-        }
-
-        free(simdata);
-    }
-
-    free(gridx);
-    free(gridy);
-    free(coordx);
-    free(coordy);
-    free(ax);
-    free(ay);
-    free(bx);
-    free(by);
-    free(coorx);
-    free(coory);
-    free(dist);
-    free(indx);
-    free(indy);
-}
+#include "affinity.h"
+#include "utils.h"
+
+// Ray geometry kept for the whole call, at most this many bytes; slabs of
+// any further centers trace their rays again on every pass.
+#define VECTOR_CACHE_BYTES ((size_t) 512 << 20)
+
+// Rays of one rotation center. Ray r = p * dx + d keeps the pixel indices
+// and lengths of its nseg[r] segments at r * (ngridx + ngridy + 1) in indi
+// and dist.
+typedef struct
+{
+    int*   nseg;
+    int*   indi;
+    float* dist;
+    float* wray;  // 1 / sum of squared lengths, 0 for a ray that misses
+    float* wpix;  // 1 / summed length through each pixel, 0 if not crossed
+} vector_rays;
+
+// Slabs of consecutive slices sharing a center, updated by one thread each.
+// Slab k holds slices s0[k] .. s0[k + 1] - 1 and uses rays[run[k]], which
+// is NULL when its center is not cached.
+typedef struct
+{
+    int           nslab, maxns, nrun;
+    int*          s0;
+    int*          run;
+    vector_rays** rays;
+} vector_plan;
+
+static vector_rays*
+vector_trace(int ngridx, int ngridy, int dt, int dx, float center,
+             const float* theta, int nthreads)
+{
+    size_t       npix   = (size_t) ngridx * ngridy;
+    size_t       nray   = (size_t) dt * dx;
+    size_t       stride = (size_t) ngridx + ngridy + 1;
+    vector_rays* r      = (vector_rays*) malloc(sizeof(vector_rays));
+    float*       gridx  = (float*) malloc((ngridx + 1) * sizeof(float));
+    float*       gridy  = (float*) malloc((ngridy + 1) * sizeof(float));
+    size_t       i;
+    int          n;
+    float        mov;
+
+    assert(r != NULL && gridx != NULL && gridy != NULL);
+
+    r->nseg = (int*) malloc(nray * sizeof(int));
+    r->indi = (int*) malloc(nray * stride * sizeof(int));
+    r->dist = (float*) malloc(nray * stride * sizeof(float));
+    r->wray = (float*) malloc(nray * sizeof(float));
+    r->wpix = (float*) calloc(npix, sizeof(float));
+
+    assert(r->nseg != NULL && r->indi != NULL && r->dist != NULL &&
+           r->wray != NULL && r->wpix != NULL);
+
+    preprocessing(ngridx, ngridy, dx, center, &mov, gridx,
+                  gridy);  // Outputs: mov, gridx, gridy
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        ray_buffers b;
+        int         p, d, n, csize, quadrant;
+        float       theta_p, sin_p, cos_p, sum2;
+
+        ray_alloc(&b, ngridx, ngridy);
+
+#pragma omp for schedule(dynamic, 1)
+        for(p = 0; p < dt; p++)
+        {
+            theta_p  = fmod(theta[p], 2 * M_PI);
+            quadrant = calc_quadrant(theta_p);
+            sin_p    = sinf(theta_p);
+            cos_p    = cosf(theta_p);
+
+            for(d = 0; d < dx; d++)
+            {
+                size_t ray  = (size_t) p * dx + d;
+                int*   indi = r->indi + ray * stride;
+                float* dist = r->dist + ray * stride;
+
+                csize = trace_ray(ngridx, ngridy, (1 - dx) / 2.0 + d + mov,
+                                  quadrant, sin_p, cos_p, gridx, gridy, &b);
+                r->nseg[ray] = (csize > 1) ? csize - 1 : 0;
+
+                sum2 = 0.0f;
+                for(n = 0; n < r->nseg[ray]; n++)
+                {
+                    indi[n] = b.indi[n];
+                    dist[n] = b.dist[n];
+                    sum2 += dist[n] * dist[n];
+                }
+                r->wray[ray] = (sum2 != 0.0f) ? 1.0f / sum2 : 0.0f;
+            }
+        }
+
+        ray_free(&b);
+    }
+
+    // Rays of every angle cross the same pixels, so the lengths are summed
+    // serially, in the order the slice-by-slice update used.
+    for(i = 0; i < nray; i++)
+        for(n = 0; n < r->nseg[i]; n++)
+            r->wpix[r->indi[i * stride + n]] += r->dist[i * stride + n];
+    for(i = 0; i < npix; i++)
+        r->wpix[i] = (r->wpix[i] != 0.0f) ? 1.0f / r->wpix[i] : 0.0f;
+
+    free(gridx);
+    free(gridy);
+    return r;
+}
+
+//============================================================================//
+
+static void
+vector_plan_init(vector_plan* pl, int dy, int dt, int dx, const float* center,
+                 const float* theta, int ngridx, int ngridy, int nthreads,
+                 int nchunk)
+{
+    size_t npix  = (size_t) ngridx * ngridy;
+    size_t nray  = (size_t) dt * dx;
+    size_t bytes = nray * (((size_t) ngridx + ngridy + 1) *
+                               (sizeof(int) + sizeof(float)) +
+                           sizeof(int) + sizeof(float)) +
+                   npix * sizeof(float);
+    size_t cached = 0;
+    int    nslab  = volume_chunk(dy, nthreads, nchunk, 0);
+    int    limit  = (int) (((size_t) 16 << 20) / npix);
+    int    s0, s1;
+
+    // Each thread keeps two slabs of both components: at most 256 MB.
+    if(nslab > limit)
+        nslab = (limit < 1) ? 1 : limit;
+
+    pl->s0   = (int*) malloc((dy + 1) * sizeof(int));
+    pl->run  = (int*) malloc(dy * sizeof(int));
+    pl->rays = (vector_rays**) malloc(dy * sizeof(vector_rays*));
+    assert(pl->s0 != NULL && pl->run != NULL && pl->rays != NULL);
+
+    pl->nslab = pl->maxns = pl->nrun = 0;
+    for(s0 = 0; s0 < dy; s0 = s1)
+    {
+        for(s1 = s0 + 1;
+            s1 < dy && s1 - s0 < nslab && center[s1] == center[s0]; s1++)
+            ;
+
+        if(s0 == 0 || center[s0] != center[s0 - 1])
+        {
+            vector_rays* r = NULL;
+            if(cached + bytes <= VECTOR_CACHE_BYTES)
+            {
+                r = vector_trace(ngridx, ngridy, dt, dx, center[s0], theta,
+                                 nthreads);
+                cached += bytes;
+            }
+            pl->rays[pl->nrun++] = r;
+        }
+
+        pl->run[pl->nslab]  = pl->nrun - 1;
+        pl->s0[pl->nslab++] = s0;
+        if(s1 - s0 > pl->maxns)
+            pl->maxns = s1 - s0;
+    }
+    pl->s0[pl->nslab] = dy;
+}
+
+//============================================================================//
+
+static void
+vector_plan_free(vector_plan* pl)
+{
+    int i;
+
+    for(i = 0; i < pl->nrun; i++)
+    {
+        vector_rays* r = pl->rays[i];
+        if(r == NULL)
+            continue;
+        free(r->nseg);
+        free(r->indi);
+        free(r->dist);
+        free(r->wray);
+        free(r->wpix);
+        free(r);
+    }
+    free(pl->s0);
+    free(pl->run);
+    free(pl->rays);
+}
+
+//============================================================================//
+
+// One SIRT pass over ``data`` updating the pair of components read along
+// ``axis``, as in calc_simdata3: (recon1, recon2) for axis 0, (recon2,
+// recon3) for axis 1 and (recon1, recon3) for axis 2. A slice only reads
+// and writes its own plane of the volume, so the slabs of a pass are
+// independent. Each slab is transposed to [pixel][component][slice] and
+// every ray updates all of its slices in one sweep. With ``same`` set both
+// components take the x update, as vector() always has.
+static void
+vector_pass(const float* data, int dy, int dt, int dx, const float* center,
+            const float* theta, float* recon1, float* recon2, float* recon3,
+            int axis, int same, int ngridx, int ngridy, const vector_plan* pl,
+            int nthreads)
+{
+    size_t npix    = (size_t) ngridx * ngridy;
+    size_t stride  = (size_t) ngridx + ngridy + 1;
+    float* c0      = (axis == 1) ? recon2 : recon1;
+    float* c1      = (axis == 0) ? recon2 : recon3;
+    size_t sstride = (axis == 1) ? 1 : (axis == 2) ? (size_t) ngridy : npix;
+
+    (void) dy;
+    if(nthreads > pl->nslab)
+        nthreads = pl->nslab;
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        size_t ms    = pl->maxns;
+        float* gridx = (float*) malloc((ngridx + 1) * sizeof(float));
+        float* gridy = (float*) malloc((ngridy + 1) * sizeof(float));
+        float* slab  = (float*) malloc(2 * npix * ms * sizeof(float));
+        float* upd   = (float*) malloc(2 * npix * ms * sizeof(float));
+        float* res   = (float*) malloc(ms * sizeof(float));
+        float* wsum  = (float*) malloc(npix * sizeof(float));
+        ray_buffers b;
+        int         k, p, d, n, s, ns, s0, nseg, csize, quadrant;
+        size_t      i;
+        float       theta_p, sin_p, cos_p, vx, vy, mov = 0.0f, w;
+
+        assert(gridx != NULL && gridy != NULL && slab != NULL &&
+               upd != NULL && res != NULL && wsum != NULL);
+        ray_alloc(&b, ngridx, ngridy);
+
+#pragma omp for schedule(dynamic, 1)
+        for(k = 0; k < pl->nslab; k++)
+        {
+            const vector_rays* r    = pl->rays[pl->run[k]];
+            const float*       wpix = (r != NULL) ? r->wpix : wsum;
+
+            s0 = pl->s0[k];
+            ns = pl->s0[k + 1] - s0;
+
+            if(r == NULL)
+            {
+                preprocessing(ngridx, ngridy, dx, center[s0], &mov, gridx,
+                              gridy);  // Outputs: mov, gridx, gridy
+                memset(wsum, 0, npix * sizeof(float));
+            }
+
+            for(i = 0; i < npix; i++)
+            {
+                // Grid pixel i = indx * ngridy + indy, see calc_dist
+                size_t indx = i / ngridy;
+                size_t indy = i % ngridy;
+                size_t off  = (axis == 1)   ? indx * ngridy + indy * npix
+                              : (axis == 2) ? indx + indy * npix
+                                            : i;
+                float* col  = slab + i * 2 * ns;
+                for(s = 0; s < ns; s++)
+                {
+                    col[s]      = c0[off + (s0 + s) * sstride];
+                    col[ns + s] = c1[off + (s0 + s) * sstride];
+                }
+            }
+            memset(upd, 0, 2 * npix * ns * sizeof(float));
+
+            // For each projection angle
+            for(p = 0; p < dt; p++)
+            {
+                theta_p  = fmod(theta[p], 2 * M_PI);
+                quadrant = calc_quadrant(theta_p);
+                sin_p    = sinf(theta_p);
+                cos_p    = cosf(theta_p);
+
+                // Unit vector from detector to source
+                vx = -cos_p;
+                vy = -sin_p;
+
+                // For each detector pixel
+                for(d = 0; d < dx; d++)
+                {
+                    const int*   indi;
+                    const float* dist;
+
+                    if(r != NULL)
+                    {
+                        size_t ray = (size_t) p * dx + d;
+                        nseg       = r->nseg[ray];
+                        indi       = r->indi + ray * stride;
+                        dist       = r->dist + ray * stride;
+                        w          = r->wray[ray];
+                    }
+                    else
+                    {
+                        csize = trace_ray(ngridx, ngridy,
+                                          (1 - dx) / 2.0 + d + mov, quadrant,
+                                          sin_p, cos_p, gridx, gridy, &b);
+                        nseg  = (csize > 1) ? csize - 1 : 0;
+                        indi  = b.indi;
+                        dist  = b.dist;
+                        w     = 0.0f;
+                        for(n = 0; n < nseg; n++)
+                        {
+                            w += dist[n] * dist[n];
+                            wsum[indi[n]] += dist[n];
+                        }
+                        w = (w != 0.0f) ? 1.0f / w : 0.0f;
+                    }
+                    if(w == 0.0f)
+                        continue;
+
+                    // Simulated data of the ray in every slice
+                    for(s = 0; s < ns; s++)
+                        res[s] = 0.0f;
+                    for(n = 0; n < nseg; n++)
+                    {
+                        const float* col = slab + (size_t) indi[n] * 2 * ns;
+                        const float  len = dist[n];
+#pragma omp simd
+                        for(s = 0; s < ns; s++)
+                            res[s] += (col[s] * vx + col[ns + s] * vy) * len;
+                    }
+
+                    // Residual over the squared ray length
+                    for(s = 0; s < ns; s++)
+                        res[s] = (data[(size_t)(s0 + s) * dt * dx +
+                                       (size_t) p * dx + d] -
+                                  res[s]) *
+                                 w;
+
+                    for(n = 0; n < nseg; n++)
+                    {
+                        float*      col = upd + (size_t) indi[n] * 2 * ns;
+                        const float len = dist[n];
+#pragma omp simd
+                        for(s = 0; s < ns; s++)
+                        {
+                            col[s] += res[s] * len * vx;
+                            col[ns + s] += res[s] * len * vy;
+                        }
+                    }
+                }
+            }
+
+            if(r == NULL)
+                for(i = 0; i < npix; i++)
+                    wsum[i] = (wsum[i] != 0.0f) ? 1.0f / wsum[i] : 0.0f;
+
+            // Update, normalized by the summed length through each pixel
+            for(i = 0; i < npix; i++)
+            {
+                size_t       indx = i / ngridy;
+                size_t       indy = i % ngridy;
+                size_t       off  = (axis == 1)   ? indx * ngridy + indy * npix
+                                    : (axis == 2) ? indx + indy * npix
+                                                  : i;
+                const float* col  = upd + i * 2 * ns;
+                const float* coly = (same) ? col : col + ns;
+
+                if(wpix[i] == 0.0f)
+                    continue;
+                for(s = 0; s < ns; s++)
+                {
+                    c0[off + (s0 + s) * sstride] += col[s] * wpix[i];
+                    c1[off + (s0 + s) * sstride] += coly[s] * wpix[i];
+                }
+            }
+        }
+
+        ray_free(&b);
+        free(gridx);
+        free(gridy);
+        free(slab);
+        free(upd);
+        free(res);
+        free(wsum);
+    }
+}
+
+//============================================================================//
+
+// All passes trace the rays of center1 and theta1, so their geometry is
+// cached once for the whole call. The passes of one iteration run in turn:
+// each reads components the previous pass has just updated.
+void
+vector(const float* data, int dy, int dt, int dx, const float* center,
+       const float* theta, float* recon1, float* recon2, int ngridx, int ngridy,
+       int num_iter, int ncore, int nchunk)
+{
+    int         nthreads = get_nthreads(ncore);
+    vector_plan pl;
+    int         i;
+
+    vector_plan_init(&pl, dy, dt, dx, center, theta, ngridx, ngridy, nthreads,
+                     nchunk);
+
+    for(i = 0; i < num_iter; i++)
+    {
+        vector_pass(data, dy, dt, dx, center, theta, recon1, recon2, NULL, 0,
+                    1, ngridx, ngridy, &pl, nthreads);
+    }
+
+    vector_plan_free(&pl);
+}
+
+//============================================================================//
+
+void
+vector2(const float* data1, const float* data2, int dy, int dt, int dx,
+        const float* center1, const float* center2, const float* theta1,
+        const float* theta2, float* recon1, float* recon2, float* recon3,
+        int ngridx, int ngridy, int num_iter, int axis1, int axis2, int ncore,
+        int nchunk)
+{
+    int         nthreads = get_nthreads(ncore);
+    vector_plan pl;
+    int         i;
+
+    (void) center2;
+    (void) theta2;
+    vector_plan_init(&pl, dy, dt, dx, center1, theta1, ngridx, ngridy,
+                     nthreads, nchunk);
+
+    for(i = 0; i < num_iter; i++)
+    {
+        vector_pass(data1, dy, dt, dx, center1, theta1, recon1, recon2, recon3,
+                    axis1, 0, ngridx, ngridy, &pl, nthreads);
+        vector_pass(data2, dy, dt, dx, center1, theta1, recon1, recon2, recon3,
+                    axis2, 0, ngridx, ngridy, &pl, nthreads);
+    }
+
+    vector_plan_free(&pl);
+}
+
+//============================================================================//
+
+void
+vector3(const float* data1, const float* data2, const float* data3, int dy,
+        int dt, int dx, const float* center1, const float* center2,
+        const float* center3, const float* theta1, const float* theta2,
+        const float* theta3, float* recon1, float* recon2, float* recon3,
+        int ngridx, int ngridy, int num_iter, int axis1, int axis2, int axis3,
+        int ncore, int nchunk)
+{
+    int         nthreads = get_nthreads(ncore);
+    vector_plan pl;
+    int         i;
+
+    (void) center2;
+    (void) center3;
+    (void) theta2;
+    (void) theta3;
+    vector_plan_init(&pl, dy, dt, dx, center1, theta1, ngridx, ngridy,
+                     nthreads, nchunk);
+
+    for(i = 0; i < num_iter; i++)
+    {
+        vector_pass(data1, dy, dt, dx, center1, theta1, recon1, recon2, recon3,
+                    axis1, 0, ngridx, ngridy, &pl, nthreads);
+        vector_pass(data2, dy, dt, dx, center1, theta1, recon1, recon2, recon3,
+                    axis2, 0, ngridx, ngridy, &pl, nthreads);
+        vector_pass(data3, dy, dt, dx, center1, theta1, recon1, recon2, recon3,
+                    axis3, 0, ngridx, ngridy, &pl, nthreads);
+    }
+
+    vector_plan_free(&pl);
+}
@@ -51,9 +51,10 @@ from __future__ import (absolute_import, division, print_function,
 
 import unittest
 from ..util import read_file, loop_dim
-from tomopy.misc.morph import downsample, upsample, sino_360_to_180
+from tomopy.misc.morph import (downsample, upsample, sino_360_to_180,
+                               swap_stack_order, pad)
 import numpy as np
-from numpy.testing import assert_array_almost_equal
+from numpy.testing import assert_array_almost_equal, assert_array_equal
 
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
@@ -67,6 +68,47 @@ class MorphingTestCase(unittest.TestCase):
     def test_upsample(self):
         loop_dim(upsample, read_file('obj.npy'))
 
+    def test_downsample_binning(self):
+        obj = read_file('obj.npy')
+        nx, ny, nz = (n // f for n, f in zip(obj.shape, (2, 3, 2)))
+        blocks = obj[:nx * 2, :ny * 3, :nz * 2].reshape(nx, 2, ny, 3, nz, 2)
+        assert_array_almost_equal(
+            downsample(obj, binning=(2, 3, 2)), blocks.mean(axis=(1, 3, 5)))
+        assert_array_almost_equal(
+            downsample(obj, binning=(2, 3, 2), median=True),
+            np.median(blocks.transpose(0, 2, 4, 1, 3, 5).reshape(
+                nx, ny, nz, -1), axis=-1))
+        assert_array_almost_equal(
+            downsample(obj, binning=(2, 3, 2), nchunk=3),
+            downsample(obj, binning=(2, 3, 2)))
+        self.assertRaises(ValueError, downsample, obj, binning=(2, 0, 2))
+        self.assertRaises(ValueError, upsample, obj, binning=(1, -1, 1))
+        self.assertRaises(ValueError, downsample, obj, axis=3)
+
+    def test_upsample_binning(self):
+        obj = read_file('obj.npy')
+        expected = obj.repeat(2, axis=0).repeat(3, axis=1).repeat(2, axis=2)
+        assert_array_almost_equal(upsample(obj, binning=(2, 3, 2)), expected)
+        assert_array_almost_equal(
+            upsample(obj, binning=(2, 3, 2), nchunk=5), expected)
+
+    def test_swap_stack_order(self):
+        for shape, dtype in (((37, 41, 9), 'float32'), ((5, 3, 1), 'uint16'),
+                             ((300, 70, 2), 'float32')):
+            arr = np.arange(np.prod(shape)).reshape(shape).astype(dtype)
+            expected = np.swapaxes(arr, 0, 1)
+            assert_array_equal(swap_stack_order(arr, ncore=3), expected)
+            assert_array_equal(
+                swap_stack_order(arr.copy(), ncore=2, inplace=True), expected)
+
+    def test_swap_stack_order_bad_out(self):
+        arr = np.zeros((4, 6, 3), dtype='float32')
+        for out in (np.zeros((4, 6, 3), dtype='float32'),
+                    np.zeros((6, 4, 3), dtype='float64'),
+                    np.zeros((6, 3, 4), dtype='float32').swapaxes(1, 2)):
+            for a in (arr, arr[:, :, ::-1]):
+                self.assertRaises(ValueError, swap_stack_order, a, out=out)
+
     def test_sino_360_to_180(self):
         ltest_im = np.random.random((32, 32, 128)).astype(np.float32)
         ltest_im[16:, :, :32 ] = ltest_im[:16, :, :32][:,:,::-1]
@@ -82,3 +124,29 @@ class MorphingTestCase(unittest.TestCase):
             rtest[:, :, :128], rtest_im[:16, :, :])
         assert_array_almost_equal(
             rtest[:, :, -128:], rtest_im[16:, :, :][:, :, ::-1])
+
+    def test_sino_360_to_180_native(self):
+        im = np.random.random((33, 8, 40)).astype(np.float32)
+        for rotation in ('left', 'right'):
+            for overlap in (0, 1, 12, 40):
+                ref = sino_360_to_180(im.astype(np.float64), overlap,
+                                      rotation)
+                out = np.empty(ref.shape, dtype=np.float32)
+                res = sino_360_to_180(im, overlap, rotation, ncore=2,
+                                      out=out)
+                self.assertIs(res, out)
+                assert_array_almost_equal(res, ref, decimal=6)
+        self.assertRaises(ValueError, sino_360_to_180, im, 0, 'up')
+
+    def test_pad(self):
+        arr = np.random.random((5, 6, 7)).astype(np.float32)
+        for axis in range(3):
+            width = [(0, 0)] * 3
+            width[axis] = (4, 4)
+            for mode, kwargs in (('constant', {'constant_values': 2}),
+                                 ('edge', {}), ('reflect', {})):
+                ref = np.pad(arr, width, mode, **kwargs)
+                assert_array_equal(pad(arr, axis, 4, mode, **kwargs), ref)
+                assert_array_equal(
+                    pad(arr.astype(np.float64), axis, 4, mode, **kwargs), ref)
+        self.assertRaises(ValueError, pad, arr, 0, -1)
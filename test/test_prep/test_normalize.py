@@ -50,9 +50,12 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import unittest
-from tomopy.prep.normalize import normalize, normalize_bg, normalize_nf
+from tomopy.prep.normalize import (
+    minus_log, normalize, normalize_bg, normalize_fused, normalize_nf)
+from tomopy.misc.corr import remove_outlier
 from ..util import read_file
 from numpy.testing import assert_allclose
+import numpy as np
 
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
@@ -73,6 +76,16 @@ class NormalizationTestCase(unittest.TestCase):
             normalize_bg(read_file('tomo.npy')),
             read_file('normalize_bg.npy'))
 
+    def test_normalize_bg_median(self):
+        tomo = read_file('tomo.npy').astype(np.float32) + 100
+        ramp = np.linspace(0, 1, tomo.shape[2], dtype=np.float32)
+        for air in (3, 4):
+            left = np.median(tomo[:, :, :air], axis=2, keepdims=True)
+            right = np.median(tomo[:, :, -air:], axis=2, keepdims=True)
+            assert_allclose(
+                normalize_bg(tomo, air=air, median=True),
+                tomo / (left + (right - left) * ramp), rtol=1e-5)
+
     def test_normalize_nf(self):
         assert_allclose(
             normalize_nf(
@@ -81,3 +94,52 @@ class NormalizationTestCase(unittest.TestCase):
                 read_file('dark.npy'),
                 (0, 4, 8, 12, 16)),
             read_file('normalize_nf.npy'))
+
+    def test_normalize_fused(self):
+        assert_allclose(
+            normalize_fused(
+                read_file('tomo.npy').astype(np.uint16),
+                read_file('flat.npy'),
+                read_file('dark.npy'),
+                minus_log=False),
+            read_file('normalize.npy'))
+
+    def test_normalize_fused_mean_fields(self):
+        tomo = read_file('tomo.npy').astype(np.uint16)
+        flat = read_file('flat.npy')
+        dark = read_file('dark.npy')
+        assert_allclose(
+            normalize_fused(tomo, flat.mean(axis=0), dark.mean(axis=0)),
+            normalize_fused(tomo, flat, dark), rtol=1e-6)
+
+    def test_normalize_fused_pipeline(self):
+        tomo = read_file('tomo.npy') + 100
+        tomo[3, 4, 20] = 3000
+        flat = read_file('flat.npy')
+        dark = read_file('dark.npy')
+        out = normalize(tomo, flat, dark, cutoff=1.5)
+        out = remove_outlier(out, dif=0.5, size=3)
+        out = minus_log(normalize_bg(out, air=2))
+        for arr in (tomo.astype(np.uint16), tomo.astype(np.float32)):
+            assert_allclose(
+                normalize_fused(
+                    arr, flat, dark, cutoff=1.5, dif=0.5, size=3, air=2),
+                out, rtol=1e-6)
+        out = minus_log(normalize_bg(
+            normalize(tomo, flat, dark), air=3, median=True))
+        assert_allclose(
+            normalize_fused(
+                tomo.astype(np.uint16), flat, dark, air=3, air_median=True),
+            out, rtol=1e-6)
+
+    def test_normalize_fused_out(self):
+        tomo = read_file('tomo.npy').astype(np.uint16)
+        flat = read_file('flat.npy')
+        dark = read_file('dark.npy')
+        out = np.empty(tomo.shape, dtype=np.float32)
+        assert normalize_fused(tomo, flat, dark, out=out) is out
+        for bad in (np.empty(tomo.shape, dtype=np.float64),
+                    np.empty(tomo.shape[::-1], dtype=np.float32).T,
+                    np.empty(tomo.shape[1:], dtype=np.float32)):
+            self.assertRaises(ValueError, normalize_fused,
+                              tomo, flat, dark, out=bad)
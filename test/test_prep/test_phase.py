@@ -50,9 +50,11 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import unittest
-from tomopy.prep.phase import retrieve_phase
+from tomopy.prep.phase import (retrieve_phase, _paganin_filter_factor,
+                               _reciprocal_grid)
 from ..util import read_file
 from numpy.testing import assert_allclose
+import numpy as np
 
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
@@ -64,3 +66,29 @@ class TestDistributeJobs(unittest.TestCase):
         assert_allclose(
             retrieve_phase(read_file('proj.npy')),
             read_file('retrieve_phase.npy'), rtol=1e-6)
+
+    def test_retrieve_phase_threads(self):
+        prj = read_file('proj.npy')
+        assert_allclose(
+            retrieve_phase(prj, ncore=2, nchunk=1),
+            retrieve_phase(prj, ncore=1), rtol=1e-6)
+
+    def test_retrieve_phase_nopad(self):
+        prj = read_file('proj.npy')
+        w2 = _reciprocal_grid(1e-4, prj.shape[1], prj.shape[2])
+        phase_filter = np.fft.fftshift(
+            _paganin_filter_factor(20, 50, 1e-3, w2))
+        phase_filter /= phase_filter.max()
+        ref = np.real(np.fft.ifft2(np.fft.fft2(prj) * phase_filter))
+        assert_allclose(
+            retrieve_phase(prj, pad=False), ref, rtol=1e-4, atol=1e-5)
+
+    def test_retrieve_phase_pad_mode(self):
+        prj = read_file('proj.npy')
+        assert_allclose(
+            retrieve_phase(prj, pad='edge'), retrieve_phase(prj), rtol=1e-6)
+        for mode in ('reflect', 'constant'):
+            res = retrieve_phase(prj, pad=mode)
+            self.assertEqual(res.shape, prj.shape)
+            self.assertTrue(np.all(np.isfinite(res)))
+        self.assertRaises(ValueError, retrieve_phase, prj, pad='wrap')
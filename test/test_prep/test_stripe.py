@@ -50,7 +50,10 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import unittest
-from tomopy.prep.stripe import remove_stripe_fw, remove_stripe_ti
+from tomopy.prep.stripe import (
+    remove_stripe_fw, remove_stripe_ti, remove_stripe_based_sorting,
+    remove_stripe_based_filtering, remove_stripe_based_fitting,
+    remove_large_stripe, remove_dead_stripe, remove_all_stripe)
 from ..util import read_file
 from numpy.testing import assert_allclose
 
@@ -69,3 +72,34 @@ class StripeRemovalTestCase(unittest.TestCase):
         assert_allclose(
             remove_stripe_ti(read_file('proj.npy')),
             read_file('remove_stripe_ti.npy'), rtol=1e-2)
+
+    def test_remove_stripe_based_sorting(self):
+        assert_allclose(
+            remove_stripe_based_sorting(read_file('stripes.npy')),
+            read_file('remove_stripe_based_sorting.npy'), rtol=1e-2)
+
+    def test_remove_stripe_based_filtering(self):
+        assert_allclose(
+            remove_stripe_based_filtering(read_file('stripes.npy')),
+            read_file('remove_stripe_based_filtering.npy'), rtol=1e-2)
+
+    def test_remove_stripe_based_fitting(self):
+        assert_allclose(
+            remove_stripe_based_fitting(read_file('stripes.npy')),
+            read_file('remove_stripe_based_fitting.npy'), rtol=1e-2)
+
+    def test_remove_large_stripe(self):
+        assert_allclose(
+            remove_large_stripe(read_file('stripes.npy'), snr=3, size=11),
+            read_file('remove_large_stripe.npy'), rtol=1e-2)
+
+    def test_remove_dead_stripe(self):
+        assert_allclose(
+            remove_dead_stripe(read_file('stripes.npy'), snr=3, size=11),
+            read_file('remove_dead_stripe.npy'), rtol=1e-2)
+
+    def test_remove_all_stripe(self):
+        assert_allclose(
+            remove_all_stripe(
+                read_file('stripes.npy'), snr=3, la_size=11, sm_size=5),
+            read_file('remove_all_stripe.npy'), rtol=1e-2)
@@ -51,7 +51,10 @@ from __future__ import (absolute_import, division, print_function,
 
 import unittest
 from ..util import read_file
-from tomopy.recon.algorithm import recon
+from tomopy.recon.algorithm import recon, recon_async, recon_stream, fdk
+from tomopy.sim.project import project_cone
+from tomopy.prep.normalize import minus_log, normalize
+from tomopy.util.mproc import get_dispatcher, set_numa_mode
 from numpy.testing import assert_allclose
 import numpy as np
 
@@ -113,6 +116,125 @@ class ReconstructionAlgorithmTestCase(unittest.TestCase):
             recon(self.prj, self.ang, algorithm='gridrec', filter_name='butterworth'),
             read_file('gridrec_butterworth.npy'), rtol=1e-2)
 
+    def test_gridrec_pad(self):
+        dx = self.prj.shape[2]
+        npad = 6
+        for mode in ('constant', 'edge', 'reflect'):
+            padded = np.pad(self.prj, ((0, 0), (0, 0), (npad, npad)), mode)
+            ref = recon(padded, self.ang, algorithm='gridrec',
+                        center=(dx + 2 * npad) / 2)
+            assert_allclose(
+                recon(self.prj, self.ang, algorithm='gridrec',
+                      pad_width=npad, pad_mode=mode),
+                ref[:, npad:npad + dx, npad:npad + dx], rtol=1e-4, atol=1e-4)
+        self.assertRaises(ValueError, recon, self.prj, self.ang,
+                          algorithm='gridrec', pad_width=-1)
+
+    def test_raw_uint16(self):
+        tomo = read_file('tomo.npy') + 100
+        flat = read_file('flat.npy')
+        dark = read_file('dark.npy')
+        ang = np.linspace(0, np.pi, tomo.shape[0], dtype=np.float32)
+        prj = minus_log(normalize(tomo, flat, dark))
+        for algorithm in ('gridrec', 'fbp'):
+            assert_allclose(
+                recon(tomo.astype(np.uint16), ang, algorithm=algorithm,
+                      flat=flat, dark=dark),
+                recon(prj, ang, algorithm=algorithm), rtol=1e-4, atol=1e-6)
+
+    def test_volume_split(self):
+        for algorithm in ('gridrec', 'sirt'):
+            expected = recon(self.prj, self.ang, algorithm=algorithm, ncore=1)
+            for ncore, nchunk in ((3, None), (2, 0), (4, 3)):
+                assert_allclose(
+                    recon(self.prj, self.ang, algorithm=algorithm,
+                          ncore=ncore, nchunk=nchunk),
+                    expected, rtol=1e-5, atol=1e-5)
+
+    def test_numa_mode(self):
+        expected = recon(self.prj, self.ang, algorithm='sirt', num_iter=2)
+        set_numa_mode(True)
+        try:
+            result = recon(self.prj, self.ang, algorithm='sirt', num_iter=2,
+                           ncore=3)
+        finally:
+            set_numa_mode(False)
+        assert_allclose(result, expected, rtol=1e-5, atol=1e-6)
+
+    def test_recon_async(self):
+        expected = recon(self.prj, self.ang, algorithm='sirt', num_iter=2)
+        done = []
+        futures = recon_async(self.prj, self.ang, algorithm='sirt',
+                              nchunk=3, callback=done.append, num_iter=2)
+        result = np.concatenate([f.result() for f in futures])
+        assert_allclose(result, expected, rtol=1e-5, atol=1e-6)
+        self.assertEqual(len(futures), -(-self.prj.shape[1] // 4))
+        # callbacks run on the dispatcher before its next job
+        get_dispatcher().submit(int).result()
+        self.assertEqual(len(done), len(futures))
+
+    def test_recon_async_grid_shape(self):
+        # num_gridy defaults to dx, as in recon
+        expected = recon(self.prj, self.ang, algorithm='sirt', num_gridx=16,
+                         num_iter=2)
+        futures = recon_async(self.prj, self.ang, algorithm='sirt',
+                              num_gridx=16, num_iter=2, nchunk=2)
+        result = np.concatenate([f.result() for f in futures])
+        assert_allclose(result, expected, rtol=1e-5, atol=1e-6)
+        init = np.full(expected.shape, 2e-6, dtype=np.float32)
+        futures = recon_async(self.prj, self.ang, algorithm='sirt',
+                              num_gridx=16, num_iter=2, nchunk=2,
+                              init_recon=init)
+        assert_allclose(
+            np.concatenate([f.result() for f in futures]),
+            recon(self.prj, self.ang, algorithm='sirt', num_gridx=16,
+                  num_iter=2, init_recon=init), rtol=1e-5, atol=1e-6)
+        self.assertRaises(ValueError, recon_async, self.prj, self.ang,
+                          out=np.empty((1, 2, 3), dtype=np.float32))
+        self.assertRaises(ValueError, recon, self.prj, self.ang,
+                          algorithm='sirt', init_recon=np.ones((1, 2, 3)))
+
+    def test_recon_stream(self):
+        expected = recon(self.prj, self.ang, algorithm='gridrec')
+        out = np.zeros_like(expected)
+        recon_stream(self.prj, self.ang, algorithm='gridrec', out=out,
+                     nchunk=3, nproj=5)
+        assert_allclose(out, expected, rtol=1e-5, atol=1e-5)
+
+        tomo = read_file('tomo.npy') + 100
+        flat = read_file('flat.npy')
+        dark = read_file('dark.npy')
+        ang = np.linspace(0, np.pi, tomo.shape[0], dtype=np.float32)
+        expected = recon(minus_log(normalize(tomo, flat, dark)), ang,
+                         algorithm='sirt', num_iter=2)
+        assert_allclose(
+            recon_stream(tomo.astype(np.uint16), ang, algorithm='sirt',
+                         flat=flat, dark=dark, prep=[lambda x: x + 0],
+                         nchunk=2, num_iter=2),
+            expected, rtol=1e-4, atol=1e-5)
+
+    def test_recon_stream_grid_shape(self):
+        expected = recon(self.prj, self.ang, algorithm='sirt', num_gridx=16,
+                         num_iter=2)
+        assert_allclose(
+            recon_stream(self.prj, self.ang, algorithm='sirt', num_gridx=16,
+                         num_iter=2, nchunk=2),
+            expected, rtol=1e-5, atol=1e-6)
+        self.assertRaises(ValueError, recon_stream, self.prj, self.ang,
+                          out=np.empty((1, 2, 3), dtype=np.float32))
+
+    def test_fdk(self):
+        obj = read_file('obj.npy')
+        ang = np.linspace(0, 2 * np.pi, 90, endpoint=False, dtype='float32')
+        tomo = project_cone(obj, ang, 40)
+        rec = fdk(tomo, ang, 40, num_gridx=32, num_gridy=32, num_slice=8)
+        # The central slices of the unit cube, with gridrec-level error
+        assert_allclose(rec[3:5].mean(), 1, rtol=0.1)
+        assert np.abs(rec - obj)[3:5].mean() < 0.1
+        assert_allclose(
+            fdk(tomo, ang, 40, num_gridx=32, num_gridy=32, num_slice=8,
+                ncore=2, nchunk=3), rec, rtol=1e-5, atol=1e-5)
+
     def test_mlem(self):
         assert_allclose(
             recon(self.prj, self.ang, algorithm='mlem', num_iter=4),
@@ -138,6 +260,21 @@ class ReconstructionAlgorithmTestCase(unittest.TestCase):
             recon(self.prj, self.ang, algorithm='pml_hybrid', num_iter=4),
             read_file('pml_hybrid.npy'), rtol=1e-2)
 
+    def test_pml_hybrid3d(self):
+        # A single slice has no neighbours across slices.
+        assert_allclose(
+            recon(self.prj[:, :1], self.ang, algorithm='pml_hybrid3d',
+                  num_iter=4),
+            read_file('pml_hybrid.npy')[:1], rtol=1e-2)
+        rng = np.random.RandomState(0)
+        noisy = (self.prj + rng.normal(0, 0.5, self.prj.shape)).astype(
+            np.float32)
+        assert_allclose(
+            recon(noisy, self.ang, algorithm='pml_hybrid3d', num_iter=4,
+                  ncore=3, nchunk=2),
+            recon(noisy, self.ang, algorithm='pml_hybrid3d', num_iter=4,
+                  ncore=1), rtol=1e-5, atol=1e-6)
+
     def test_pml_quad(self):
         assert_allclose(
             recon(self.prj, self.ang, algorithm='pml_quad', num_iter=4),
@@ -153,6 +290,25 @@ class ReconstructionAlgorithmTestCase(unittest.TestCase):
             recon(self.prj, self.ang, algorithm='tv', num_iter=4),
             read_file('tv.npy'), rtol=1e-2)
 
+    def test_tv3d(self):
+        assert_allclose(
+            recon(self.prj, self.ang, algorithm='tv3d', num_iter=4),
+            read_file('tv.npy'), rtol=1e-2)
+        rng = np.random.RandomState(0)
+        noisy = (self.prj + rng.normal(0, 0.5, self.prj.shape)).astype(
+            np.float32)
+        rec = recon(noisy, self.ang, algorithm='tv3d', num_iter=10,
+                    reg_par=0.1, ncore=1)
+        assert_allclose(
+            recon(noisy, self.ang, algorithm='tv3d', num_iter=10,
+                  reg_par=0.1, ncore=3, nchunk=2),
+            rec, rtol=1e-5, atol=1e-6)
+        # Noise is smoothed across slices too
+        rec2d = recon(noisy, self.ang, algorithm='tv', num_iter=10,
+                      reg_par=0.1)
+        assert (np.abs(np.diff(rec, axis=0)).mean() <
+                np.abs(np.diff(rec2d, axis=0)).mean())
+
     def test_grad(self):
         assert_allclose(
             recon(self.prj, self.ang, algorithm='grad', num_iter=4),
@@ -52,7 +52,8 @@ from __future__ import (absolute_import, division, print_function,
 import unittest
 from ..util import read_file
 from tomopy.recon.rotation import write_center, find_center, find_center_vo, \
-    find_center_pc
+    find_center_tilt, find_center_pc, _calc_metric, _create_mask, _sweep_gridrec
+from tomopy.recon.algorithm import recon
 import numpy as np
 from scipy.ndimage.interpolation import shift as image_shift
 import os.path
@@ -83,6 +84,16 @@ class CenterFindingTestCase(unittest.TestCase):
                         str('{0:.2f}'.format(cen[m]) + '.tiff'))), True)
         shutil.rmtree(dpath)
 
+    def test_sweep_gridrec(self):
+        sino = read_file('proj.npy')[:, 2, :]
+        theta = read_file('angle.npy')
+        cen = np.arange(5, 7.5, 0.5)
+        rec = _sweep_gridrec(sino, theta, cen, filter_name='parzen')
+        stack = np.repeat(sino[:, np.newaxis, :], cen.size, axis=1)
+        expected = recon(stack, theta, center=cen, algorithm='gridrec',
+                         filter_name='parzen', nchunk=1)
+        assert_allclose(rec, expected, atol=1e-5)
+
     def test_find_center(self):
         sim = read_file('sinogram.npy')
         ang = np.linspace(0, np.pi, sim.shape[0])
@@ -102,6 +113,25 @@ class CenterFindingTestCase(unittest.TestCase):
         cen = find_center_vo(sim)
         assert_allclose(cen, 45.28, rtol=0.015)
 
+    def test_calc_metric(self):
+        sino = read_file('sinogram.npy')[:, 0, :]
+        nrow, ncol = sino.shape
+        mask = _create_mask(2 * nrow, ncol, 0.25 * ncol, 20)
+        shifts = np.arange(-10, 11)
+        expected = [np.mean(np.abs(np.fft.fftshift(np.fft.fft2(np.vstack(
+            (sino, np.roll(np.fliplr(sino), s, axis=1)))))) * mask)
+            for s in shifts]
+        metric = _calc_metric(sino, shifts, 0.5, 20, ncore=2)
+        assert_allclose(metric, expected, rtol=1e-4)
+
+    def test_find_center_tilt(self):
+        sim = read_file('sinogram.npy')[:, 0, :]
+        off = np.linspace(-4, 4, 17)
+        tomo = np.stack([image_shift(sim, (0, o), order=1) for o in off], 1)
+        cen = find_center_tilt(tomo, nind=5)
+        assert_equals(cen.shape, (17, ))
+        assert_allclose(cen - off, 45.28, rtol=0.015)
+
     def test_find_center_pc(self):
         proj_0 = read_file('projection.npy')
         proj_180 = image_shift(np.fliplr(proj_0), (0, 18.75), mode='reflect')
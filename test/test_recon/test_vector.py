@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# #########################################################################
+# Copyright (c) 2015-2019, UChicago Argonne, LLC. All rights reserved.    #
+#                                                                         #
+# Copyright 2015-2019. UChicago Argonne, LLC. This software was produced  #
+# under U.S. Government contract DE-AC02-06CH11357 for Argonne National   #
+# Laboratory (ANL), which is operated by UChicago Argonne, LLC for the    #
+# U.S. Department of Energy. The U.S. Government has rights to use,       #
+# reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR    #
+# UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR        #
+# ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is     #
+# modified to produce derivative works, such modified software should     #
+# be clearly marked, so as not to confuse it with the version available   #
+# from ANL.                                                               #
+#                                                                         #
+# Additionally, redistribution and use in source and binary forms, with   #
+# or without modification, are permitted provided that the following      #
+# conditions are met:                                                     #
+#                                                                         #
+#     * Redistributions of source code must retain the above copyright    #
+#       notice, this list of conditions and the following disclaimer.     #
+#                                                                         #
+#     * Redistributions in binary form must reproduce the above copyright #
+#       notice, this list of conditions and the following disclaimer in   #
+#       the documentation and/or other materials provided with the        #
+#       distribution.                                                     #
+#                                                                         #
+#     * Neither the name of UChicago Argonne, LLC, Argonne National       #
+#       Laboratory, ANL, the U.S. Government, nor the names of its        #
+#       contributors may be used to endorse or promote products derived   #
+#       from this software without specific prior written permission.     #
+#                                                                         #
+# THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS     #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT       #
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS       #
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago     #
+# Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,        #
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,    #
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;        #
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        #
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT      #
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN       #
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE         #
+# POSSIBILITY OF SUCH DAMAGE.                                             #
+# #########################################################################
+
+from __future__ import (absolute_import, division, print_function,
+                        unicode_literals)
+
+import unittest
+from ..util import read_file
+from tomopy.recon.vector import vector, vector3
+from tomopy.sim.project import project2, project3
+from numpy.testing import assert_allclose
+import numpy as np
+
+__author__ = "Doga Gursoy"
+__copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
+__docformat__ = 'restructuredtext en'
+
+
+class VectorReconstructionTestCase(unittest.TestCase):
+    def setUp(self):
+        obj = read_file('obj.npy')[:, :8, :8]
+        self.obj = obj, obj[::-1], obj[:, ::-1]
+        self.ang = read_file('angle.npy').astype('float32')
+
+    def test_vector(self):
+        objx, objy, _ = self.obj
+        prj = project2(objx, objy, self.ang, pad=False)
+        ref = vector(prj, self.ang, num_iter=2, ncore=1, nchunk=1)
+        rec = vector(prj, self.ang, num_iter=2, ncore=2, nchunk=3)
+        assert_allclose(rec, ref, rtol=1e-5, atol=1e-6)
+        # Both components take the x update.
+        assert_allclose(ref[0], ref[1])
+
+    def test_vector3(self):
+        prj = [project3(*self.obj, theta=self.ang, axis=axis, pad=False)
+               for axis in range(3)]
+        ref = vector3(*prj, theta1=self.ang, theta2=self.ang,
+                      theta3=self.ang, num_iter=4, ncore=1, nchunk=1)
+        rec = vector3(*prj, theta1=self.ang, theta2=self.ang,
+                      theta3=self.ang, num_iter=4, ncore=2, nchunk=3)
+        assert_allclose(rec, ref, rtol=1e-5, atol=1e-6)
+        # The reconstruction reproduces the data it was fitted to.
+        for axis in range(3):
+            sim = project3(*rec, theta=self.ang, axis=axis, pad=False)
+            err = np.linalg.norm(sim - prj[axis]) / np.linalg.norm(prj[axis])
+            self.assertLess(err, 0.5)
@@ -50,6 +50,7 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import unittest
+import numpy as np
 from ..util import read_file
 from tomopy.sim.project import *
 from numpy.testing import assert_allclose
@@ -64,3 +65,62 @@ class JobDistributionTestCase(unittest.TestCase):
         assert_allclose(
             project(read_file('obj.npy'), read_file('angle.npy')),
             read_file('proj.npy'), rtol=1e-2)
+
+    def test_project_threads(self):
+        obj = read_file('obj.npy')
+        ang = read_file('angle.npy')
+        ref = project(obj, ang, sinogram_order=True, ncore=1, nchunk=1)
+        for ncore, nchunk in ((1, None), (2, 3), (4, None)):
+            assert_allclose(
+                project(obj, ang, sinogram_order=True, ncore=ncore,
+                        nchunk=nchunk), ref, rtol=1e-5, atol=1e-5)
+
+    def test_project_per_slice_center(self):
+        obj = read_file('obj.npy')
+        ang = read_file('angle.npy')
+        center = 15.5 + np.arange(obj.shape[0], dtype='float32') % 2
+        tomo = project(obj, ang, center=center, sinogram_order=True)
+        for s in range(obj.shape[0]):
+            assert_allclose(
+                tomo[s],
+                project(obj[s:s + 1], ang, center=center[s],
+                        sinogram_order=True)[0], rtol=1e-5, atol=1e-5)
+
+    def test_project2_direction(self):
+        obj = read_file('obj.npy')
+        zero = np.zeros_like(obj)
+        ang = np.array([np.pi, 1.5 * np.pi], dtype='float32')
+        tomo = project(obj, ang, sinogram_order=True)
+        # The ray direction is (-cos, -sin): (1, 0) at pi, (0, 1) at 3pi/2.
+        assert_allclose(
+            project2(obj, zero, ang, sinogram_order=True)[:, 0],
+            tomo[:, 0], rtol=1e-5, atol=1e-5)
+        assert_allclose(
+            project2(zero, obj, ang, sinogram_order=True)[:, 1],
+            tomo[:, 1], rtol=1e-5, atol=1e-5)
+
+    def test_project3_threads(self):
+        obj = read_file('obj.npy')[:, :8, :8]
+        objx, objy, objz = obj, obj[::-1], obj[:, ::-1]
+        ang = read_file('angle.npy')
+        assert_allclose(
+            project3(objx, objy, objz, ang, axis=0),
+            project2(objx, objy, ang), rtol=1e-5, atol=1e-5)
+        for axis in range(3):
+            ref = project3(objx, objy, objz, ang, axis=axis, ncore=1,
+                           nchunk=1)
+            assert_allclose(
+                project3(objx, objy, objz, ang, axis=axis, ncore=2,
+                         nchunk=3), ref, rtol=1e-5, atol=1e-5)
+
+    def test_project_cone(self):
+        obj = read_file('obj.npy')
+        ang = read_file('angle.npy')
+        # A distant source approaches the parallel beam.
+        assert_allclose(
+            project_cone(obj, ang, 1e5, pad=False),
+            project(obj, ang, pad=False), rtol=1e-2, atol=0.05)
+        ref = project_cone(obj, ang, 40, sinogram_order=True, ncore=1)
+        assert_allclose(
+            project_cone(obj, ang, 40, sinogram_order=True, ncore=2,
+                         nchunk=3), ref, rtol=1e-5, atol=1e-5)
@@ -51,10 +51,76 @@ from __future__ import (absolute_import, division, print_function,
 
 import unittest
 from ..util import read_file
-# from tomopy.sim.propagate import ...
+from tomopy.sim.propagate import (propagate_tie, propagate_fresnel,
+                                  calc_intensity, probe_gauss)
 import numpy as np
 from numpy.testing import assert_array_almost_equal
 
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
 __docformat__ = 'restructuredtext en'
+
+
+class PropagateTestCase(unittest.TestCase):
+    def setUp(self):
+        obj = read_file('obj.npy')
+        self.mu = 0.1 * obj[:, :12, :]
+        self.delta = 1e-6 * obj[:, ::-1, :][:, :12, :]
+
+    def test_propagate_tie(self):
+        ref = np.zeros(self.delta.shape)
+        for m in range(self.delta.shape[0]):
+            i1 = np.exp(-self.mu[m])
+            dx, dy = np.gradient(self.delta[m], 1e-4)
+            d2x, _ = np.gradient(i1 * dx, 1e-4)
+            _, d2y = np.gradient(i1 * dy, 1e-4)
+            ref[m] = i1 + 50 * (d2x + d2y)
+        assert_array_almost_equal(
+            propagate_tie(self.mu, self.delta, 1e-4, 50, ncore=2), ref, 5)
+
+    def test_propagate_fresnel(self):
+        # A smooth phase object at a short distance is in the transport of
+        # intensity limit.
+        y, x = np.mgrid[:32, :32] - 15.5
+        blob = np.exp(-(x ** 2 + y ** 2) / 18.)[np.newaxis]
+        mu, delta = 0.1 * blob, 5e-9 * blob
+        tie = propagate_tie(mu, delta, 1e-4, 1)
+        contrast = np.abs(tie - np.exp(-mu)).max()
+        err = np.abs(propagate_fresnel(mu, delta, 1e-4, 1, 20) - tie).max()
+        self.assertGreater(contrast, 0.05)
+        self.assertLess(err, 0.1 * contrast)
+
+    def test_calc_intensity(self):
+        probe = probe_gauss(8, 8)
+        proj = read_file('obj.npy')[:2]
+        for mode in ('near', 'far'):
+            out = calc_intensity(probe, proj, mode=mode, ncore=2)
+            for m in range(proj.shape[0]):
+                psi = np.array([probe * proj[m, i:i + 8, j:j + 8]
+                                for i in range(0, 25, 4)
+                                for j in range(0, 25, 4)])
+                if mode == 'far':
+                    psi = np.fft.fftshift(np.fft.fft2(psi), axes=(1, 2))
+                ref = np.abs(psi) ** 2
+                assert_array_almost_equal(out[m] / ref.max(),
+                                          ref / ref.max(), 5)
+                assert_array_almost_equal(
+                    calc_intensity(probe, proj[m], mode=mode) / ref.max(),
+                    ref / ref.max(), 5)
+
+    def test_calc_intensity_complex(self):
+        probe = probe_gauss(8, 8) * np.exp(1j * np.linspace(0, 3, 64)
+                                           ).reshape(8, 8)
+        proj = read_file('obj.npy')[:2]
+        proj = np.exp(-0.1 * proj + 1j * proj)
+        for mode in ('near', 'far'):
+            out = calc_intensity(probe, proj, mode=mode, ncore=2)
+            for m in range(proj.shape[0]):
+                psi = np.array([probe * proj[m, i:i + 8, j:j + 8]
+                                for i in range(0, 25, 4)
+                                for j in range(0, 25, 4)])
+                if mode == 'far':
+                    psi = np.fft.fftshift(np.fft.fft2(psi), axes=(1, 2))
+                ref = np.abs(psi) ** 2
+                assert_array_almost_equal(out[m] / ref.max(),
+                                          ref / ref.max(), 5)
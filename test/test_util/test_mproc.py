@@ -49,7 +49,11 @@
 from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
+import glob
+import os
+import tempfile
 import tomopy.util.mproc as mproc
+import tomopy.util.dtype as dtype
 import numpy as np
 from numpy.testing import assert_allclose, assert_array_equal
 import unittest
@@ -64,6 +68,10 @@ def _synthetic_func(a, val):
         a[m, :, :] = val
 
 
+def _add_func(a, val):
+    return a + val
+
+
 def _test_shape(a, expected_shape):
     assert a.shape == expected_shape
     return a
@@ -109,3 +117,45 @@ class TestDistributeJobs(unittest.TestCase):
                 args=(1.,),
                 axis=0),
             np.ones((8, 8, 8)))
+
+    def test_distribute_jobs_mapped(self):
+        a = dtype.empty_mapped_array((8, 8, 8))
+        a[:] = 0
+        ret = mproc.distribute_jobs(
+            a, func=_synthetic_func, args=(1.,), axis=0, ncore=2)
+        # mapped input is worked on in place and the pool is kept alive
+        assert ret is a
+        assert_allclose(a, np.ones((8, 8, 8)))
+        pool = mproc.POOL
+        mproc.distribute_jobs(
+            a, func=_synthetic_func, args=(2.,), axis=1, ncore=2)
+        assert mproc.POOL is pool
+        assert_allclose(a, 2 * np.ones((8, 8, 8)))
+        # fewer cores means fewer jobs, not a smaller pool
+        mproc.distribute_jobs(
+            a, func=_synthetic_func, args=(3.,), axis=2, ncore=2, nchunk=7)
+        assert mproc.POOL is pool
+        assert_allclose(a, 3 * np.ones((8, 8, 8)))
+
+    def test_distribute_jobs_unlinks_copies(self):
+        def files():
+            return set(glob.glob(os.path.join(dtype.MAPPED_DIR, 'tomopy-*')))
+        before = files()
+        out = np.zeros((8, 8, 8))
+        mproc.distribute_jobs(
+            np.zeros((8, 8, 8)), func=_add_func, args=(1.,), axis=0,
+            ncore=2, out=out)
+        assert_allclose(out, np.ones((8, 8, 8)))
+        assert files() == before
+
+    def test_mapped_dir_fallback(self):
+        free_bytes = dtype._free_bytes
+        dtype._free_bytes = lambda path: 0
+        try:
+            a = dtype.empty_mapped_array((8, 8))
+        finally:
+            dtype._free_bytes = free_bytes
+        name = dtype.get_mapped_name(a)
+        assert os.path.dirname(name) == tempfile.gettempdir()
+        dtype.release_mapped(a)
+        assert not os.path.exists(name)
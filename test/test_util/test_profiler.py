@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# #########################################################################
+# Copyright (c) 2015-2019, UChicago Argonne, LLC. All rights reserved.    #
+#                                                                         #
+# Copyright 2015-2019. UChicago Argonne, LLC. This software was produced  #
+# under U.S. Government contract DE-AC02-06CH11357 for Argonne National   #
+# Laboratory (ANL), which is operated by UChicago Argonne, LLC for the    #
+# U.S. Department of Energy. The U.S. Government has rights to use,       #
+# reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR    #
+# UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR        #
+# ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is     #
+# modified to produce derivative works, such modified software should     #
+# be clearly marked, so as not to confuse it with the version available   #
+# from ANL.                                                               #
+#                                                                         #
+# Additionally, redistribution and use in source and binary forms, with   #
+# or without modification, are permitted provided that the following      #
+# conditions are met:                                                     #
+#                                                                         #
+#     * Redistributions of source code must retain the above copyright    #
+#       notice, this list of conditions and the following disclaimer.     #
+#                                                                         #
+#     * Redistributions in binary form must reproduce the above copyright #
+#       notice, this list of conditions and the following disclaimer in   #
+#       the documentation and/or other materials provided with the        #
+#       distribution.                                                     #
+#                                                                         #
+#     * Neither the name of UChicago Argonne, LLC, Argonne National       #
+#       Laboratory, ANL, the U.S. Government, nor the names of its        #
+#       contributors may be used to endorse or promote products derived   #
+#       from this software without specific prior written permission.     #
+#                                                                         #
+# THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS     #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT       #
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS       #
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago     #
+# Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,        #
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,    #
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;        #
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        #
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT      #
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN       #
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE         #
+# POSSIBILITY OF SUCH DAMAGE.                                             #
+# #########################################################################
+
+from __future__ import (absolute_import, division, print_function,
+                        unicode_literals)
+
+import json
+import os
+import tempfile
+import unittest
+from ..util import read_file
+from tomopy.recon.algorithm import recon
+import tomopy.util.profiler as profiler
+
+__author__ = "Doga Gursoy"
+__copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
+__docformat__ = 'restructuredtext en'
+
+
+@unittest.skipUnless(profiler.profile_enabled(),
+                     'libtomopy built without -DTOMOPY_PROFILE')
+class ProfilerTestCase(unittest.TestCase):
+    def test_gridrec_phases(self):
+        prj = read_file('proj.npy')
+        ang = read_file('angle.npy').astype('float32')
+        profiler.reset_profile()
+        recon(prj, ang, algorithm='gridrec', ncore=2)
+        phases = profiler.get_profile()
+        events = profiler.get_profile_events()
+        npair = -(-prj.shape[1] // 2)
+        for name in ('gridrec.fft2d', 'gridrec.grid', 'gridrec.pswf'):
+            self.assertEqual(phases[name]['calls'], npair)
+            self.assertGreater(phases[name]['bytes'], 0)
+        self.assertEqual(
+            sum(e['phase'] == 'gridrec.fft2d' for e in events), npair)
+
+        fd, fname = tempfile.mkstemp(suffix='.json')
+        os.close(fd)
+        try:
+            profiler.dump_profile(fname, trace=True)
+            with open(fname) as f:
+                trace = json.load(f)['traceEvents']
+            self.assertEqual(len(trace), len(events))
+        finally:
+            os.remove(fname)
+
+    def test_iterative_phases(self):
+        prj = read_file('proj.npy')
+        ang = read_file('angle.npy').astype('float32')
+        for algorithm in ('art', 'bart', 'grad', 'mlem', 'osem',
+                          'ospml_hybrid', 'ospml_quad', 'pml_hybrid',
+                          'pml_hybrid3d', 'pml_quad', 'sirt', 'tv', 'tv3d'):
+            profiler.reset_profile()
+            recon(prj, ang, algorithm=algorithm, num_iter=1, ncore=2)
+            phases = profiler.get_profile()
+            self.assertGreater(
+                phases[algorithm + '.project']['calls'], 0, algorithm)
+
+
+@unittest.skipIf(profiler.profile_enabled(),
+                 'libtomopy built with -DTOMOPY_PROFILE')
+class ProfilerDisabledTestCase(unittest.TestCase):
+    def test_nothing_recorded(self):
+        prj = read_file('proj.npy')
+        ang = read_file('angle.npy').astype('float32')
+        profiler.reset_profile()
+        recon(prj, ang, algorithm='gridrec', ncore=2)
+        self.assertEqual(
+            sum(p['calls'] for p in profiler.get_profile().values()), 0)
+        self.assertEqual(profiler.get_profile_events(), [])
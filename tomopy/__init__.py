@@ -66,7 +66,8 @@ from tomopy.recon.vector import *
 from tomopy.recon.acceleration import *
 from tomopy.sim.project import *
 from tomopy.sim.propagate import *
-from tomopy.util.mproc import set_debug
+from tomopy.util.mproc import (set_debug, set_num_threads, get_num_threads,
+                               set_numa_mode, get_numa_mode)
 
 import logging
 logging.getLogger(__name__).addHandler(logging.NullHandler())
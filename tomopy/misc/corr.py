@@ -565,7 +565,7 @@ def remove_ring(rec, center_x=None, center_y=None, thresh=300.0,
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
-        Chunk size for each core.
+        Unused, slices are spread over the cores in C.
     out : ndarray, optional
         Output array for result. If same as arr, process
         will be done in-place.
@@ -600,12 +600,7 @@ def remove_ring(rec, center_x=None, center_y=None, thresh=300.0,
     args = (center_x, center_y, dx, dy, dz, thresh_max, thresh_min,
             thresh, theta_min, rwidth, int_mode)
 
-    axis_size = rec.shape[0]
-    ncore, nchunk = mproc.get_ncore_nchunk(axis_size, ncore, nchunk)
-    with cf.ThreadPoolExecutor(ncore) as e:
-        for offset in range(0, axis_size, nchunk):
-            slc = np.s_[offset:offset+nchunk]
-            e.submit(extern.c_remove_ring, out[slc], *args)
+    extern.c_remove_ring(out, *args, ncore=ncore)
     return out
 
 
@@ -71,6 +71,7 @@ __all__ = ['downsample',
            'pad',
            'sino_360_to_180',
            'sino_360_t0_180',  # For backward compatibility
+           'swap_stack_order',
            'trim_sinogram']
 
 
@@ -96,6 +97,9 @@ def pad(arr, axis, npad=None, mode='constant', ncore=None, **kwargs):
             Pads with a constant value.
         'edge'
             Pads with the edge values of array.
+        'reflect'
+            Pads with the reflection of the array mirrored on its first
+            and last values, as np.pad.
     constant_values : float, optional
         Used in 'constant'. Pad value
     ncore : int, optional
@@ -105,10 +109,18 @@ def pad(arr, axis, npad=None, mode='constant', ncore=None, **kwargs):
     -------
     ndarray
         Padded 3D array.
+
+    Notes
+    -----
+    3D float32 arrays are padded in one native pass over the output rows.
+    gridrec (``pad_mode``, ``pad_width``) and
+    :func:`tomopy.prep.phase.retrieve_phase` pad their rows as they load
+    them, so there is no need to pad a stack before passing it to them.
     """
 
     allowedkwargs = {'constant': ['constant_values'],
-                     'edge': [], }
+                     'edge': [],
+                     'reflect': [], }
 
     kwdefaults = {'constant_values': 0, }
 
@@ -127,14 +139,26 @@ def pad(arr, axis, npad=None, mode='constant', ncore=None, **kwargs):
 
     if npad is None:
         npad = _get_npad(arr.shape[axis])
+    elif npad < 0:
+        raise ValueError('npad must be non-negative, got %s' % npad)
 
     newshape = list(arr.shape)
     newshape[axis] += 2*npad
 
+    if arr.ndim == 3 and arr.dtype == np.float32:
+        out = np.empty(newshape, dtype=np.float32)
+        return extern.c_pad_volume(
+            np.require(arr, requirements='C'), axis, npad, mode,
+            kwargs.get('constant_values', 0), ncore, out)
+
+    if mode == 'reflect':
+        return np.pad(arr, _get_pad_sequence(arr.shape, axis, npad),
+                      mode='reflect')
+
     slc_in, slc_l, slc_r, slc_l_v, slc_r_v = _get_slices(arr.shape, axis, npad)
 
     out = np.empty(newshape, dtype=arr.dtype)
-    if arr.dtype in [np.float32, np.float64, np.bool,
+    if arr.dtype in [np.float32, np.float64, np.bool_,
                      np.int32, np.int64, np.complex128]:
         # Datatype supported by numexpr
         with mproc.set_numexpr_threads(ncore):
@@ -176,7 +200,8 @@ def _get_slices(shape, axis, npad):
     slc_l_v[axis] = slice(0, 1)
     slc_r_v = [slice(None)]*len(shape)
     slc_r_v[axis] = slice(shape[axis]-1, shape[axis])
-    return slc_in, slc_l, slc_r, slc_l_v, slc_r_v
+    return (tuple(slc_in), tuple(slc_l), tuple(slc_r), tuple(slc_l_v),
+            tuple(slc_r_v))
 
 
 def _get_pad_sequence(shape, axis, npad):
@@ -189,7 +214,8 @@ def _get_pad_sequence(shape, axis, npad):
     return pad_seq
 
 
-def downsample(arr, level=1, axis=2):
+def downsample(arr, level=1, axis=2, binning=None, median=False,
+               ncore=None, nchunk=None, out=None):
     """
     Downsample along specified axis of a 3D array.
 
@@ -201,16 +227,31 @@ def downsample(arr, level=1, axis=2):
         Downsampling level in powers of two.
     axis : int, optional
         Axis along which downsampling will be performed.
+    binning : sequence of 3 int, optional
+        Integer downsampling factor along each axis, e.g. (2, 2, 2).
+        Overrides level and axis.
+    median : bool, optional
+        Take the median instead of the mean of each block.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of downsampled planes along the first axis computed at a
+        time. Only one chunk of arr is converted to float32 at once, so
+        arr and out can be out-of-core arrays (e.g. np.memmap or h5py
+        datasets).
+    out : ndarray, optional
+        Output array for result.
 
     Returns
     -------
     ndarray
         Downsampled 3D array in float32.
     """
-    return _sample(arr, level, axis, mode=0)
+    return _sample(arr, level, axis, 0, binning, median, ncore, nchunk, out)
 
 
-def upsample(arr, level=1, axis=2):
+def upsample(arr, level=1, axis=2, binning=None, ncore=None, nchunk=None,
+             out=None):
     """
     Upsample along specified axis of a 3D array.
 
@@ -222,35 +263,115 @@ def upsample(arr, level=1, axis=2):
         Downsampling level in powers of two.
     axis : int, optional
         Axis along which upsampling will be performed.
+    binning : sequence of 3 int, optional
+        Integer upsampling factor along each axis, e.g. (2, 2, 2).
+        Overrides level and axis.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of input planes along the first axis processed at a time.
+        Only one chunk of arr is converted to float32 at once, so arr and
+        out can be out-of-core arrays (e.g. np.memmap or h5py datasets).
+    out : ndarray, optional
+        Output array for result.
 
     Returns
     -------
     ndarray
         Upsampled 3D array in float32.
     """
-    return _sample(arr, level, axis, mode=1)
+    return _sample(arr, level, axis, 1, binning, False, ncore, nchunk, out)
+
+
+def _sample(arr, level, axis, mode, binning, median, ncore, nchunk, out):
+    if binning is None:
+        if not 0 <= axis <= 2:
+            raise ValueError('axis must be 0, 1 or 2, got %s' % axis)
+        if level < 0:
+            raise ValueError('level must be non-negative, got %s' % level)
+        binning = [1, 1, 1]
+        binning[axis] = 2 ** level
+    factor = np.array(binning, dtype=np.int32)
+    if factor.shape != (3, ) or np.any(factor < 1):
+        raise ValueError(
+            'binning must be three integers >= 1, got %s' % (binning, ))
+
+    # Determine the new shape of the down-/up-sampled array
+    if mode == 0:
+        shape = tuple(n // f for n, f in zip(arr.shape, factor))
+        nplane = shape[0]
+    else:
+        shape = tuple(n * f for n, f in zip(arr.shape, factor))
+        nplane = arr.shape[0]
+    if out is None:
+        out = np.empty(shape, dtype=np.float32)
+
+    # Process the binned planes of the first axis in chunks
+    step = nchunk if nchunk else max(nplane, 1)
+    for start in range(0, nplane, step):
+        stop = min(start + step, nplane)
+        if mode == 0:
+            src = arr[start * factor[0]:stop * factor[0]]
+            dst = slice(start, stop)
+        else:
+            src = arr[start:stop]
+            dst = slice(start * factor[0], stop * factor[0])
+        src = np.require(src, dtype=np.float32, requirements='C')
+        chunk = out[dst]
+        direct = (isinstance(chunk, np.ndarray) and
+                  chunk.dtype == np.float32 and chunk.flags.c_contiguous)
+        buf = chunk if direct else np.empty(chunk.shape, dtype=np.float32)
+        extern.c_sample(mode, src, factor, median, ncore, buf)
+        if not direct:
+            out[dst] = buf
+    return out
 
 
-def _sample(arr, level, axis, mode):
-    arr = dtype.as_float32(arr.copy())
-    dx, dy, dz = arr.shape
-    # Determine the new size, dim, of the down-/up-sampled dimension
-    if mode == 0:
-        dim = int(arr.shape[axis] / np.power(2, level))
-    if mode == 1:
-        dim = int(arr.shape[axis] * np.power(2, level))
+def swap_stack_order(arr, ncore=None, out=None, inplace=False):
+    """
+    Swap the first two axes of a 3D array into a new C-contiguous array,
+    e.g. to turn projections into sinograms or back.
 
-    out = _init_out(arr, axis, dim)
-    return extern.c_sample(mode, arr, dx, dy, dz, level, axis, out)
+    Unlike ``np.swapaxes`` followed by a copy, rows are moved in tiles that
+    stay in cache and the work is spread over threads.
 
+    Parameters
+    ----------
+    arr : ndarray
+        3D input array.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    out : ndarray, optional
+        C-contiguous output array of the swapped shape and arr's dtype.
+    inplace : bool, optional
+        Reorder the data of a C-contiguous arr in place and return it as a
+        view of the swapped shape. Only a bit per row of extra memory is
+        used; arr itself is left with scrambled data.
 
-def _init_out(arr, axis, dim, val=0.):
-    if axis > 3:
-        logger.warning('Maximum allowable dimension is three.')
-    dx, dy, dz = arr.shape
-    shape = [dx, dy, dz]
-    shape[axis] = dim
-    return val * np.ones(shape, dtype='float32')
+    Returns
+    -------
+    ndarray
+        Array of shape (arr.shape[1], arr.shape[0], arr.shape[2]).
+    """
+    arr = np.asarray(arr)
+    shape = (arr.shape[1], arr.shape[0]) + arr.shape[2:]
+    if inplace and arr.flags.c_contiguous:
+        return extern.c_swap_stack_inplace(arr, ncore)
+    if out is not None and (out.shape != shape or out.dtype != arr.dtype or
+                            not out.flags.c_contiguous):
+        raise ValueError(
+            'out must be a C-contiguous %s array of shape %s' %
+            (arr.dtype, shape))
+    if not arr.flags.c_contiguous:
+        # a strided copy is as good as any for scattered input
+        swapped = np.swapaxes(arr, 0, 1)
+        if out is None:
+            return np.require(swapped, requirements='AC')
+        out[...] = swapped
+        return out
+    if out is None:
+        out = np.empty(shape, dtype=arr.dtype)
+    return extern.c_swap_stack(arr, out, ncore)
 
 
 def trim_sinogram(data, center, x, y, diameter):
@@ -309,13 +430,16 @@ def trim_sinogram(data, center, x, y, diameter):
     return roidata
 
 
-def sino_360_to_180(data, overlap=0, rotation='left'):
+def sino_360_to_180(data, overlap=0, rotation='left', ncore=None, out=None):
     """
     Converts 0-360 degrees sinogram to a 0-180 sinogram.
 
     If the number of projections in the input data is odd, the last projection
     will be discarded.
 
+    Float32 data is flipped, blended and concatenated in a single native
+    pass over the slices; other dtypes are converted with numpy.
+
     Parameters
     ----------
     data : ndarray
@@ -328,6 +452,13 @@ def sino_360_to_180(data, overlap=0, rotation='left'):
         Left if rotation center is close to the left of the
         field-of-view, right otherwise.
 
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+
+    out : ndarray, optional
+        Output array of shape (dx // 2, dy, 2 * dz - overlap) and data's
+        dtype.
+
     Returns
     -------
     ndarray
@@ -336,21 +467,42 @@ def sino_360_to_180(data, overlap=0, rotation='left'):
     dx, dy, dz = data.shape
 
     overlap = int(np.round(overlap))
+    if rotation not in ('left', 'right'):
+        raise ValueError("rotation must be 'left' or 'right'")
+    if not 0 <= overlap <= dz:
+        raise ValueError('overlap must be in [0, %d]' % dz)
 
     n = dx//2
-
-    out = np.empty((n, dy, 2*dz-overlap), dtype=data.dtype)
-
+    shape = (n, dy, 2*dz-overlap)
+
+    if out is None:
+        out = np.empty(shape, dtype=data.dtype)
+    elif out.shape != shape:
+        raise ValueError('out must have shape %s' % (shape, ))
+
+    if data.dtype == np.float32:
+        src = np.require(data[:2*n], dtype=np.float32, requirements='C')
+        direct = out.dtype == np.float32 and out.flags.c_contiguous
+        buf = out if direct else np.empty(shape, dtype=np.float32)
+        extern.c_sino_360_to_180(
+            src, overlap, rotation == 'left', ncore, buf)
+        if not direct:
+            out[...] = buf
+        return out
+
+    a = data[:n]
+    b = data[n:2*n]
+    keep = dz - overlap
     if rotation == 'left':
         weights = np.linspace(0, 1.0, overlap)
-        out[:, :, -dz+overlap:] = data[:n, :, overlap:]
-        out[:, :, :dz-overlap] = data[n:2*n, :, overlap:][:, :, ::-1]
-        out[:, :, dz-overlap:dz] = weights*data[:n, :, :overlap] + (weights*data[n:2*n, :, :overlap])[:, :, ::-1]
-    elif rotation == 'right':
+        out[:, :, dz:] = a[:, :, overlap:]
+        out[:, :, :keep] = b[:, :, overlap:][:, :, ::-1]
+        out[:, :, keep:dz] = weights*a[:, :, :overlap] + (weights*b[:, :, :overlap])[:, :, ::-1]
+    else:
         weights = np.linspace(1.0, 0, overlap)
-        out[:, :, :dz-overlap] = data[:n, :, :-overlap]
-        out[:, :, -dz+overlap:] = data[n:2*n, :, :-overlap][:, :, ::-1]
-        out[:, :, dz-overlap:dz] = weights*data[:n, :, -overlap:] + (weights*data[n:2*n, :, -overlap:])[:, :, ::-1]
+        out[:, :, :keep] = a[:, :, :keep]
+        out[:, :, dz:] = b[:, :, :keep][:, :, ::-1]
+        out[:, :, keep:dz] = weights*a[:, :, keep:] + (weights*b[:, :, keep:])[:, :, ::-1]
     return out
 
 # For backward compatibility
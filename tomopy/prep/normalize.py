@@ -70,6 +70,7 @@ __docformat__ = 'restructuredtext en'
 __all__ = ['minus_log',
            'normalize',
            'normalize_bg',
+           'normalize_fused',
            'normalize_roi',
            'normalize_nf']
 
@@ -180,7 +181,7 @@ def _normalize_roi(proj, roi):
         np.true_divide(proj, bg, proj)
 
 
-def normalize_bg(tomo, air=1, ncore=None, nchunk=None):
+def normalize_bg(tomo, air=1, ncore=None, nchunk=None, median=False):
     """
     Normalize 3D tomgraphy data based on background intensity.
 
@@ -198,23 +199,96 @@ def normalize_bg(tomo, air=1, ncore=None, nchunk=None):
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
         Chunk size for each core.
+    median : bool, optional
+        Estimate the air level at each boundary with the median instead
+        of the mean, which is robust to outliers.
 
     Returns
     -------
     ndarray
         Corrected 3D tomographic data.
     """
-    tomo = dtype.as_float32(tomo)
+    tomo = np.array(tomo, dtype=np.float32, order='C', copy=True)
     air = dtype.as_int32(air)
 
-    arr = mproc.distribute_jobs(
-        tomo,
-        func=extern.c_normalize_bg,
-        args=(air,),
-        axis=0,
-        ncore=ncore,
-        nchunk=nchunk)
-    return arr
+    extern.c_normalize_bg(tomo, air, median, ncore, nchunk)
+    return tomo
+
+
+def normalize_fused(arr, flat, dark, cutoff=None, dif=None, size=3, air=0,
+                    air_median=False, minus_log=True, ncore=None, out=None):
+    """
+    Normalize raw projection data and prepare it for reconstruction in a
+    single pass over the data.
+
+    Equivalent to :func:`normalize`, followed by
+    :func:`tomopy.misc.corr.remove_outlier` on each projection (if ``dif``
+    is given), :func:`normalize_bg` (if ``air`` is positive) and
+    :func:`minus_log` (if ``minus_log`` is True), without intermediate
+    copies of the stack. Raw uint16 data is converted on the fly.
+
+    Parameters
+    ----------
+    arr : ndarray
+        3D stack of raw projections, uint16 or float.
+    flat : ndarray
+        3D flat field data, or its 2D mean over the first axis.
+    dark : ndarray
+        3D dark field data, or its 2D mean over the first axis.
+    cutoff : float, optional
+        Permitted maximum vaue for the normalized data.
+    dif : float, optional
+        Expected difference value between outlier value and the median
+        value of the normalized projection. No outlier removal if None.
+    size : int, optional
+        Size of the median filter used for outlier removal.
+    air : int, optional
+        Number of pixels at each boundary to calculate the background
+        scaling factor. No background normalization if 0.
+    air_median : bool, optional
+        Estimate the background with the median of the air pixels
+        instead of the mean (see :func:`normalize_bg`).
+    minus_log : bool, optional
+        Take the minus log of the normalized data.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    out : ndarray, optional
+        Float32 output array for result. If same as a float32 arr,
+        process will be done in-place.
+
+    Returns
+    -------
+    ndarray
+        Normalized 3D tomographic data.
+    """
+    if not (isinstance(arr, np.ndarray) and arr.dtype == np.uint16):
+        arr = dtype.as_float32(arr)
+    arr = np.require(arr, requirements='C')
+    flat = _field_mean(flat)
+    dark = _field_mean(dark)
+    if out is None:
+        out = np.empty(arr.shape, dtype=np.float32)
+    elif (out.shape != arr.shape or out.dtype != np.float32 or
+          not out.flags.c_contiguous):
+        raise ValueError(
+            'out must be a C-contiguous float32 array of shape %s' %
+            (arr.shape,))
+
+    extern.c_normalize_fused(
+        arr, flat, dark, out,
+        np.inf if cutoff is None else cutoff,
+        np.inf if dif is None else dif,
+        0 if dif is None else size,
+        air, air_median, minus_log, ncore)
+    return out
+
+
+def _field_mean(field):
+    # Callers normalizing many tiles pass the mean in, it is computed once.
+    field = np.asarray(field)
+    if field.ndim == 3:
+        field = np.mean(field, axis=0, dtype=np.float32)
+    return np.require(field, dtype=np.float32, requirements='C')
 
 
 def normalize_nf(tomo, flats, dark, flat_loc,
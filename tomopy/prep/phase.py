@@ -54,10 +54,7 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import numpy as np
-from tomopy.util.misc import (fft2, ifft2)
-
-
-import tomopy.util.mproc as mproc
+import tomopy.util.extern as extern
 import logging
 
 logger = logging.getLogger(__name__)
@@ -99,8 +96,12 @@ def retrieve_phase(
         Energy of incident wave in keV.
     alpha : float, optional
         Regularization parameter.
-    pad : bool, optional
-        If True, extend the size of the projections by padding with zeros.
+    pad : bool or str, optional
+        If True or 'edge', extend the size of the projections by repeating
+        their edges. 'reflect' mirrors them instead and 'constant' fills the
+        border with the mean of the first and last columns. The padded
+        samples are generated as each projection is loaded, without a
+        padded copy of tomo.
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
@@ -111,6 +112,11 @@ def retrieve_phase(
     ndarray
         Approximated 3D tomographic phase data.
     """
+    mode = 'edge' if pad is True else pad
+    if pad and mode not in extern.PAD_MODES:
+        raise ValueError('pad must be a bool or one of %s' %
+                         list(extern.PAD_MODES))
+
     # New dimensions and pad value after padding.
     py, pz, val = _calc_pad(tomo, pixel_size, dist, energy, pad)
 
@@ -122,34 +128,35 @@ def retrieve_phase(
     phase_filter = np.fft.fftshift(
         _paganin_filter_factor(energy, dist, alpha, w2))
 
-    prj = np.full((dy + 2 * py, dz + 2 * pz), val, dtype='float32')
-    arr = mproc.distribute_jobs(
-        tomo,
-        func=_retrieve_phase,
-        args=(phase_filter, py, pz, prj, pad),
-        axis=0,
-        ncore=ncore,
-        nchunk=nchunk)
-    return arr
+    tomo = np.array(tomo, dtype=np.float32, order='C', copy=True)
+    extern.c_retrieve_phase(
+        tomo, _half_spectrum(phase_filter), py, pz, mode or 'edge', val,
+        ncore, nchunk)
+    return tomo
 
 
-def _retrieve_phase(tomo, phase_filter, px, py, prj, pad):
-    dx, dy, dz = tomo.shape
-    num_jobs = tomo.shape[0]
-    normalized_phase_filter = phase_filter / phase_filter.max()
-    for m in range(num_jobs):
-        prj[px:dy + px, py:dz + py] = tomo[m]
-        prj[:px] = prj[px]
-        prj[-px:] = prj[-px-1]
-        prj[:, :py] = prj[:, py][:, np.newaxis]
-        prj[:, -py:] = prj[:, -py-1][:, np.newaxis]
-        fproj = fft2(prj, extra_info=num_jobs)
-        fproj *= normalized_phase_filter
-        proj = np.real(ifft2(fproj, extra_info=num_jobs, overwrite_input=True))
-        if pad:
-            proj = proj[px:dy + px, py:dz + py]
-        tomo[m] = proj
+def _half_spectrum(phase_filter):
+    """
+    Half spectrum of the normalized filter for the real transforms.
+
+    The filter is first made even, F(k) = F(-k), which leaves the real part
+    of the filtered projection unchanged, and the 1 / (ny * nz) scaling of
+    the inverse transform is folded in.
 
+    Parameters
+    ----------
+    phase_filter : ndarray
+        Filter on the (ny, nz) frequency grid of the padded projection.
+
+    Returns
+    -------
+    ndarray
+        C-contiguous (ny, nz // 2 + 1) float32 filter.
+    """
+    ny, nz = phase_filter.shape
+    mirror = np.roll(phase_filter[::-1, ::-1], 1, axis=(0, 1))
+    even = (phase_filter + mirror) * (0.5 / (phase_filter.max() * ny * nz))
+    return np.ascontiguousarray(even[:, :nz // 2 + 1], dtype=np.float32)
 
 
 def _calc_pad(tomo, pixel_size, dist, energy, pad):
@@ -166,8 +173,8 @@ def _calc_pad(tomo, pixel_size, dist, energy, pad):
         Propagation distance of the wavefront in cm.
     energy : float
         Energy of incident wave in keV.
-    pad : bool
-        If True, extend the size of the projections by padding with zeros.
+    pad : bool or str
+        If set, extend the size of the projections.
 
     Returns
     -------
@@ -54,11 +54,14 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import six
+import functools
 import numpy as np
 import tomopy.util.mproc as mproc
 import tomopy.util.extern as extern
 import tomopy.util.dtype as dtype
 from tomopy.sim.project import get_center
+from tomopy.prep.normalize import normalize_fused
+from tomopy.misc.morph import swap_stack_order
 import logging
 import concurrent.futures as cf
 
@@ -68,7 +71,7 @@ logger = logging.getLogger(__name__)
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
 __docformat__ = 'restructuredtext en'
-__all__ = ['recon', 'init_tomo']
+__all__ = ['recon', 'recon_async', 'recon_stream', 'fdk', 'init_tomo']
 
 
 allowed_recon_kwargs = {
@@ -76,7 +79,8 @@ allowed_recon_kwargs = {
     'bart': ['num_gridx', 'num_gridy', 'num_iter',
              'num_block', 'ind_block'],
     'fbp': ['num_gridx', 'num_gridy', 'filter_name', 'filter_par'],
-    'gridrec': ['num_gridx', 'num_gridy', 'filter_name', 'filter_par'],
+    'gridrec': ['num_gridx', 'num_gridy', 'filter_name', 'filter_par',
+                'pad_width', 'pad_mode'],
     'mlem': ['num_gridx', 'num_gridy', 'num_iter'],
     'osem': ['num_gridx', 'num_gridy', 'num_iter',
              'num_block', 'ind_block'],
@@ -85,16 +89,19 @@ allowed_recon_kwargs = {
     'ospml_quad': ['num_gridx', 'num_gridy', 'num_iter',
                    'reg_par', 'num_block', 'ind_block'],
     'pml_hybrid': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
+    'pml_hybrid3d': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
     'pml_quad': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
     'sirt': ['num_gridx', 'num_gridy', 'num_iter'],
     'tv': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
+    'tv3d': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
     'grad': ['num_gridx', 'num_gridy', 'num_iter', 'reg_par'],
 }
 
 
 def recon(
         tomo, theta, center=None, sinogram_order=False, algorithm=None,
-        init_recon=None, ncore=None, nchunk=None, **kwargs):
+        init_recon=None, ncore=None, nchunk=None, flat=None, dark=None,
+        **kwargs):
     """
     Reconstruct object from projection data.
 
@@ -136,6 +143,8 @@ def recon(
         'pml_hybrid'
             Penalized maximum likelihood algorithm with weighted linear
             and quadratic penalties :cite:`Chang:04`.
+        'pml_hybrid3d'
+            'pml_hybrid' with the penalty also coupling neighbouring slices.
         'pml_quad'
             Penalized maximum likelihood algorithm with quadratic penalty.
         'sirt'
@@ -143,6 +152,8 @@ def recon(
         'tv'
             Total Variation reconstruction technique
             :cite:`Chambolle:11`.
+        'tv3d'
+            'tv' with the total variation also taken across slices.
         'grad'
             Gradient descent method with a constant step size
 
@@ -178,6 +189,14 @@ def recon(
 
     filter_par: list, optional
         Filter parameters as a list.
+    pad_width : int, optional
+        For 'gridrec', the number of samples added on both sides of each
+        sinogram row, generated as the rows are loaded instead of padding
+        tomo beforehand. The reconstruction grid is unchanged; custom
+        filters are sized for `num_detector_columns + 2*pad_width`.
+    pad_mode : str, optional
+        How 'gridrec' pads: 'constant' (zeros, default), 'edge' or
+        'reflect', as np.pad.
     num_iter : int, optional
         Number of algorithm iterations performed.
     num_block : int, optional
@@ -191,7 +210,13 @@ def recon(
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
-        Chunk size for each core.
+        Chunk size for each core. For the 3D algorithms, the number of
+        slices per block of the halo-exchanged split.
+    flat, dark : ndarray, optional
+        3D flat and dark field data. Only for 'gridrec' and 'fbp' with
+        raw uint16 tomo: the data is then normalized and minus-logged
+        slice by slice while it is loaded, without a float32 copy of the
+        whole stack.
 
     Returns
     -------
@@ -240,8 +265,19 @@ def recon(
     >>> pylab.show()
     """
 
+    # Raw uint16 data is passed through to the C core with flat/dark tables.
+    raw = flat is not None or dark is not None
+    if raw:
+        if algorithm not in ('gridrec', 'fbp'):
+            raise ValueError(
+                'flat and dark are only supported by gridrec and fbp')
+        if flat is None or dark is None:
+            raise ValueError('flat and dark must be given together')
+        raw = getattr(tomo, 'dtype', None) == np.uint16
+
     # Initialize tomography data.
-    tomo = init_tomo(tomo, sinogram_order, sharedmem=False)
+    tomo = init_tomo(tomo, sinogram_order, sharedmem=False, raw=raw,
+                     ncore=ncore)
 
     generic_kwargs = ['num_gridx', 'num_gridy', 'options']
 
@@ -276,6 +312,13 @@ def recon(
         for kw in allowed_recon_kwargs[algorithm]:
             kwargs.setdefault(kw, kwargs_defaults[kw])
 
+        if 'pad_mode' in kwargs and kwargs['pad_mode'] not in extern.PAD_MODES:
+            raise ValueError('pad_mode must be one of %s' %
+                             list(extern.PAD_MODES))
+        if 'pad_width' in kwargs and kwargs['pad_width'] < 0:
+            raise ValueError('pad_width must be non-negative, got %s' %
+                             kwargs['pad_width'])
+
     elif hasattr(algorithm, '__call__'):
         # Set kwarg defaults.
         for kw in generic_kwargs:
@@ -288,20 +331,366 @@ def recon(
     # Generate args for the algorithm.
     center_arr = get_center(tomo.shape, center)
     args = _get_algorithm_args(theta)
+    if raw:
+        kwargs['flat'] = _init_raw_table(flat)
+        kwargs['dark'] = _init_raw_table(dark)
+    elif flat is not None:
+        # Data that is not uint16 is normalized up front instead.
+        flat = _init_raw_table(flat)[:, np.newaxis]
+        dark = _init_raw_table(dark)[:, np.newaxis]
+        denom = np.maximum(flat - dark, np.float32(1e-6))
+        tomo = np.require(
+            -np.log((tomo - dark) / denom), dtype=np.float32,
+            requirements="AC")
 
     # Initialize reconstruction.
     recon_shape = (tomo.shape[0], kwargs['num_gridx'], kwargs['num_gridy'])
+    if isinstance(algorithm, six.string_types):
+        # The C core splits the volume over its own threads. Left untouched
+        # here, the recon pages are first written by the thread that uses
+        # them.
+        init = None
+        if init_recon is None:
+            recon = np.empty(recon_shape, dtype=np.float32)
+            init = 1e-6
+        else:
+            recon = _init_recon(recon_shape, init_recon, sharedmem=False)
+        if extern.c_has_openmp():
+            return extern.c_recon_volume(
+                algorithm, tomo, center_arr, recon, *args, ncore=ncore,
+                nchunk=nchunk, init=init, **kwargs)
+        # Built without OpenMP (the default on macOS), the C core runs on one
+        # thread, so chunks of the volume are spread over threads here.
+        kwargs = dict(kwargs, ncore=1, nchunk=None, init=init)
+        algorithm = functools.partial(extern.c_recon_volume, algorithm)
+        return _dist_recon(
+            tomo, center_arr, recon, algorithm, args, kwargs, ncore, nchunk)
     recon = _init_recon(recon_shape, init_recon, sharedmem=False)
     return _dist_recon(
-        tomo, center_arr, recon, _get_func(algorithm), args, kwargs, ncore, nchunk)
+        tomo, center_arr, recon, algorithm, args, kwargs, ncore, nchunk)
+
+
+def recon_async(
+        tomo, theta, center=None, sinogram_order=False, algorithm='gridrec',
+        ncore=None, nchunk=None, out=None, callback=None, flat=None,
+        dark=None, **kwargs):
+    """
+    Start reconstructing object from projection data and return at once.
+
+    The slices are split into chunks that are queued on the dispatcher
+    thread of the C library (see :func:`tomopy.util.mproc.get_dispatcher`).
+    Chunks of one call, and the calls themselves, run in order, each on
+    all threads of the library, so a pipeline can load or write the next
+    dataset while the current one is reconstructed.
+
+    Parameters
+    ----------
+    tomo : ndarray
+        3D tomographic data. It must not be modified until all futures are
+        done.
+    theta : array
+        Projection angles in radian.
+    center: array, optional
+        Location of rotation axis.
+    sinogram_order: bool, optional
+        Determins whether data is a stack of sinograms (True, y-axis first
+        axis) or a stack of radiographs (False, theta first axis).
+    algorithm : str, optional
+        Reconstruction algorithm, see :func:`recon`.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of slices per chunk. Defaults to two per thread of the C
+        library.
+    out : ndarray, optional
+        Output array for the (dy, num_gridx, num_gridy) reconstruction, with
+        the grid defaults of :func:`recon`.
+    callback : callable, optional
+        Called with each future when its chunk is done.
+    flat, dark : ndarray, optional
+        3D flat and dark field data, see :func:`recon`.
+    **kwargs
+        Keyword arguments of the algorithm, see :func:`recon`.
+
+    Returns
+    -------
+    list of concurrent.futures.Future
+        One future per chunk, in slice order. The result of each is its
+        chunk of out.
+    """
+    if sinogram_order:
+        dy, dt, dx = tomo.shape
+    else:
+        dt, dy, dx = tomo.shape
+    center = get_center((dy, dt, dx), center)
+    nchunk = _chunk_size(nchunk, ncore)
+    shape = _recon_shape((dy, dt, dx), kwargs)
+    if out is None:
+        out = np.empty(shape, dtype=np.float32)
+    _check_shape('out', out, shape)
+    init_recon = kwargs.pop('init_recon', None)
+    if init_recon is not None:
+        init_recon = np.asarray(init_recon)
+        _check_shape('init_recon', init_recon, shape)
+
+    def run(y0, y1):
+        data = tomo[y0:y1] if sinogram_order else tomo[:, y0:y1]
+        fields = {}
+        if flat is not None:
+            fields = {'flat': flat[:, y0:y1], 'dark': dark[:, y0:y1]}
+        if init_recon is not None:
+            fields['init_recon'] = init_recon[y0:y1]
+        rec = out[y0:y1]
+        if rec.dtype == np.float32 and rec.flags.c_contiguous:
+            # reconstruct straight into out, starting from the initial guess
+            if init_recon is None:
+                rec.fill(1e-6)
+            else:
+                rec[...] = fields['init_recon']
+            fields['init_recon'] = rec
+        result = recon(
+            data, theta, center=center[y0:y1],
+            sinogram_order=sinogram_order, algorithm=algorithm, ncore=ncore,
+            **dict(kwargs, **fields))
+        if result is not rec:
+            rec[...] = result
+        return rec
+
+    dispatcher = mproc.get_dispatcher()
+    futures = []
+    for y0 in range(0, dy, nchunk):
+        future = dispatcher.submit(run, y0, min(y0 + nchunk, dy))
+        if callback is not None:
+            future.add_done_callback(callback)
+        futures.append(future)
+    return futures
+
+
+def _recon_shape(shape, kwargs):
+    # Shape of the reconstruction of a (dy, dt, dx) stack, with the grid
+    # defaults of recon().
+    defaults = _get_algorithm_kwargs(shape)
+    return (shape[0],
+            kwargs.get('num_gridx', defaults['num_gridx']),
+            kwargs.get('num_gridy', defaults['num_gridy']))
+
+
+def _check_shape(name, arr, shape):
+    if np.shape(arr) != tuple(shape):
+        raise ValueError('%s must have shape %s, got %s' %
+                         (name, tuple(shape), np.shape(arr)))
+
+
+def _chunk_size(nchunk, ncore):
+    # Even, as gridrec works on pairs of slices.
+    if not nchunk:
+        nchunk = 2 * (ncore or mproc.get_num_threads())
+    return nchunk + nchunk % 2
+
+
+def recon_stream(
+        tomo, theta, center=None, algorithm='gridrec', out=None, flat=None,
+        dark=None, prep=None, ncore=None, nchunk=None, nproj=None, **kwargs):
+    """
+    Reconstruct a projection stack that does not fit in memory, one chunk
+    of sinograms at a time.
+
+    Each chunk is read from tomo in tiles of projections, normalized, and
+    transposed into sinogram order, then the prep functions and the
+    reconstruction are run on it. While a chunk is reconstructed, the next
+    one is read and the previous one is written to out on background
+    threads, so I/O overlaps with compute and only two chunks of input and
+    output are held in memory.
+
+    Parameters
+    ----------
+    tomo : ndarray or str
+        3D tomographic data in projection order. May be an out-of-core
+        array (e.g. np.memmap or an h5py dataset) or the path of a .npy
+        file, which is opened memory-mapped.
+    theta : array
+        Projection angles in radian.
+    center: array, optional
+        Location of rotation axis.
+    algorithm : str, optional
+        Reconstruction algorithm, see :func:`recon`.
+    out : ndarray or str, optional
+        Output array for the (dy, num_gridx, num_gridy) reconstruction, with
+        the grid defaults of :func:`recon`. May be an out-of-core array or
+        the path of a .npy file to create.
+    flat, dark : ndarray, optional
+        3D flat and dark field data. If given, tiles are normalized and
+        minus-logged with :func:`tomopy.prep.normalize.normalize_fused`
+        as they are read.
+    prep : sequence of callables, optional
+        Preprocessing steps, each called with a float32 chunk in
+        projection order and returning the processed chunk, e.g.
+        ``functools.partial(tomopy.remove_stripe_fw, level=4)``.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of sinograms per chunk. Defaults to two per thread of the C
+        library.
+    nproj : int, optional
+        Number of projections read per tile.
+    **kwargs
+        Keyword arguments of the algorithm, see :func:`recon`.
+
+    Returns
+    -------
+    ndarray
+        Reconstructed 3D object, out if it was given.
+    """
+    if isinstance(tomo, six.string_types):
+        tomo = np.load(tomo, mmap_mode='r')
+    dt, dy, dx = tomo.shape
+    center = get_center((dy, dt, dx), center)
+    theta = dtype.as_float32(theta)
+    prep = list(prep or [])
+    nchunk = _chunk_size(nchunk, ncore)
+    nproj = nproj or dt
+
+    shape = _recon_shape((dy, dt, dx), kwargs)
+    if out is None:
+        out = np.empty(shape, dtype=np.float32)
+    elif isinstance(out, six.string_types):
+        out = np.lib.format.open_memmap(
+            out, mode='w+', dtype=np.float32, shape=shape)
+    _check_shape('out', out, shape)
+
+    if flat is not None:
+        # averaged once here instead of again for every tile
+        flat_mean = np.mean(flat, axis=0, dtype=np.float32)
+        dark_mean = np.mean(dark, axis=0, dtype=np.float32)
+
+    def read(y0, y1):
+        sino = np.empty((y1 - y0, dt, dx), dtype=np.float32)
+        for p0 in range(0, dt, nproj):
+            tile = np.ascontiguousarray(tomo[p0:p0 + nproj, y0:y1])
+            if flat is not None:
+                tile = normalize_fused(
+                    tile, flat_mean[y0:y1], dark_mean[y0:y1], ncore=ncore)
+            if nproj >= dt:
+                return swap_stack_order(
+                    dtype.as_float32(tile), ncore, out=sino)
+            sino[:, p0:p0 + nproj] = np.swapaxes(tile, 0, 1)
+        return sino
+
+    def write(y0, y1, rec):
+        out[y0:y1] = rec
+
+    chunks = [(y0, min(y0 + nchunk, dy)) for y0 in range(0, dy, nchunk)]
+    with cf.ThreadPoolExecutor(1) as reader, \
+            cf.ThreadPoolExecutor(1) as writer:
+        pending = reader.submit(read, *chunks[0]) if chunks else None
+        written = None
+        for i, (y0, y1) in enumerate(chunks):
+            sino = pending.result()
+            if i + 1 < len(chunks):
+                pending = reader.submit(read, *chunks[i + 1])
+            for func in prep:
+                sino = swap_stack_order(
+                    func(swap_stack_order(sino, ncore)), ncore)
+            rec = recon(sino, theta, center=center[y0:y1],
+                        sinogram_order=True, algorithm=algorithm,
+                        ncore=ncore, **kwargs)
+            if written is not None:
+                written.result()
+            written = writer.submit(write, y0, y1, rec)
+        if written is not None:
+            written.result()
+    if hasattr(out, 'flush'):
+        out.flush()
+    return out
+
+
+def fdk(tomo, theta, dist, center=None, vcenter=None, sinogram_order=False,
+        num_gridx=None, num_gridy=None, num_slice=None, filter_name='shepp',
+        filter_par=None, ncore=None, nchunk=None):
+    """
+    Reconstruct cone-beam data with the Feldkamp-Davis-Kress algorithm.
+
+    The geometry is that of :func:`tomopy.sim.project.project_cone`: a
+    circular source orbit, a flat detector and lengths in voxels.
+    Projections are cosine weighted, ramp filtered along the detector rows
+    and backprojected voxel by voxel. Slices are reconstructed in slabs,
+    each of which filters only the detector rows it reads. The scan must be
+    a full 360 degree orbit; short scans are not Parker weighted.
+
+    Parameters
+    ----------
+    tomo : ndarray
+        3D tomographic data.
+    theta : array
+        Projection angles in radian, evenly covering 360 degrees.
+    dist : float
+        Distance from the source to the rotation axis in voxels.
+    center: float, optional
+        Location of rotation axis along the detector columns.
+    vcenter: float, optional
+        Detector row hit by the central ray.
+    sinogram_order: bool, optional
+        Determines whether data is a stack of sinograms (True, y-axis first axis)
+        or a stack of radiographs (False, theta first axis).
+    num_gridx, num_gridy : int, optional
+        Number of pixels along x- and y-axes in the reconstruction grid.
+    num_slice : int, optional
+        Number of reconstructed slices.
+    filter_name : str, optional
+        Window of the ramp filter, one of the non-custom filters of
+        :func:`recon`.
+    filter_par: list, optional
+        Filter parameters as a list.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of slices per slab. By default the filtered rows are
+        bounded by memory.
+
+    Returns
+    -------
+    ndarray
+        Reconstructed 3D object.
+    """
+    if filter_name in ('custom', 'custom2d'):
+        raise ValueError('Custom filters are not supported by fdk.')
+    tomo = dtype.as_float32(tomo)
+    if not sinogram_order:
+        tomo = swap_stack_order(tomo, ncore=ncore)
+    tomo = np.ascontiguousarray(tomo)
+    theta = np.ascontiguousarray(dtype.as_float32(theta))
+    dy, dt, dx = tomo.shape
+    # evenly spaced angles cover ptp * dt / (dt - 1) of the orbit
+    span = np.ptp(theta) * dt / max(dt - 1, 1)
+    if span < 1.99 * np.pi:
+        logger.warning('fdk expects a full 360 degree orbit, theta covers '
+                       '%.1f degrees', np.degrees(span))
+
+    nz = dy if num_slice is None else num_slice
+    ngridx = dx if num_gridx is None else num_gridx
+    ngridy = dx if num_gridy is None else num_gridy
+    if dist <= 0.5 * np.sqrt(ngridx * ngridx + ngridy * ngridy):
+        raise ValueError('The source must be outside the reconstruction grid.')
+    center = dx / 2. if center is None else center
+    vcenter = dy / 2. if vcenter is None else vcenter
+    if filter_par is None:
+        filter_par = [0.5, 8]
+    filter_par = np.array(filter_par, dtype='float32')
+
+    recon = np.zeros((nz, ngridx, ngridy), dtype='float32')
+    return extern.c_fdk(tomo, center, vcenter, recon, theta, dist,
+                        filter_name, filter_par, ncore=ncore, nchunk=nchunk)
 
 
 # Convert data to sinogram order
 # Also ensure contiguous data and set to sharedmem if parameter set to True
-def init_tomo(tomo, sinogram_order, sharedmem=True):
-    tomo = dtype.as_float32(tomo)
+def init_tomo(tomo, sinogram_order, sharedmem=True, raw=False, ncore=None):
+    if raw:
+        tomo = dtype.as_uint16(tomo)
+    else:
+        tomo = dtype.as_float32(tomo)
     if not sinogram_order:
-        tomo = np.swapaxes(tomo, 0, 1)  # doesn't copy data
+        tomo = swap_stack_order(tomo, ncore=ncore)
     if sharedmem:
         # copy data to sharedmem (if not already or not contiguous)
         tomo = dtype.as_sharedmem(tomo, copy=not dtype.is_contiguous(tomo))
@@ -311,6 +700,12 @@ def init_tomo(tomo, sinogram_order, sharedmem=True):
     return tomo
 
 
+def _init_raw_table(field):
+    """Per-pixel (dy, dx) average of a flat or dark field stack."""
+    return np.require(
+        np.mean(field, axis=0, dtype=np.float32), requirements="AC")
+
+
 def _init_recon(shape, init_recon, val=1e-6, sharedmem=True):
     if init_recon is None:
         if sharedmem:
@@ -319,26 +714,13 @@ def _init_recon(shape, init_recon, val=1e-6, sharedmem=True):
         else:
             recon = np.full(shape, val, dtype=np.float32)
     else:
+        _check_shape('init_recon', init_recon, shape)
         recon = np.require(init_recon, dtype=np.float32, requirements="AC")
         if sharedmem:
             recon = dtype.as_sharedmem(recon)
     return recon
 
 
-def _get_func(algorithm):
-    """Return the c function for the given algorithm.
-
-    Raises
-    ------
-    AttributeError
-        If 'c_' + algorithm is not a function defined in tomopy.util.extern.
-    """
-    try:
-        return getattr(extern, 'c_' + algorithm)
-    except TypeError:  # algorithm is not a string
-        return algorithm
-
-
 def _dist_recon(tomo, center, recon, algorithm, args, kwargs, ncore, nchunk):
     axis_size = recon.shape[0]
     ncore, slcs = mproc.get_ncore_slices(axis_size, ncore, nchunk)
@@ -346,15 +728,27 @@ def _dist_recon(tomo, center, recon, algorithm, args, kwargs, ncore, nchunk):
     if ncore == 1:
         for slc in slcs:
             # run in this thread (useful for debugging)
-            algorithm(tomo[slc], center[slc], recon[slc], *args, **kwargs)
+            algorithm(tomo[slc], center[slc], recon[slc], *args,
+                      **_slice_kwargs(kwargs, slc))
     else:
         # execute recon on ncore threads
         with cf.ThreadPoolExecutor(ncore) as e:
             for slc in slcs:
-                e.submit(algorithm, tomo[slc], center[slc], recon[slc], *args, **kwargs)
+                e.submit(algorithm, tomo[slc], center[slc], recon[slc], *args,
+                         **_slice_kwargs(kwargs, slc))
     return recon
 
 
+def _slice_kwargs(kwargs, slc):
+    """Restrict per-slice kwargs (raw flat/dark tables) to a chunk."""
+    if 'flat' not in kwargs:
+        return kwargs
+    kwargs = dict(kwargs)
+    kwargs['flat'] = np.require(kwargs['flat'][slc], requirements="AC")
+    kwargs['dark'] = np.require(kwargs['dark'][slc], requirements="AC")
+    return kwargs
+
+
 def _get_algorithm_args(theta):
     theta = dtype.as_float32(theta)
     return (theta, )
@@ -367,6 +761,8 @@ def _get_algorithm_kwargs(shape):
         'num_gridy': dx,
         'filter_name': 'shepp',
         'filter_par': np.array([0.5, 8], dtype='float32'),
+        'pad_width': dtype.as_int32(0),
+        'pad_mode': 'constant',
         'num_iter': dtype.as_int32(1),
         'reg_par': np.ones(10, dtype='float32'),
         'num_block': dtype.as_int32(1),
@@ -55,13 +55,14 @@ from __future__ import (absolute_import, division, print_function,
 
 import numpy as np
 from scipy import ndimage
-from tomopy.util.misc import fft2, write_tiff
+from tomopy.util.misc import write_tiff
 from scipy.optimize import minimize
 from skimage.feature import register_translation
 from tomopy.misc.corr import circ_mask
 from tomopy.misc.morph import downsample
 from tomopy.recon.algorithm import recon
 import tomopy.util.dtype as dtype
+import tomopy.util.extern as extern
 import os.path
 import logging
 
@@ -73,6 +74,7 @@ __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
 __docformat__ = 'restructuredtext en'
 __all__ = ['find_center',
            'find_center_vo',
+           'find_center_tilt',
            'find_center_pc',
            'write_center',
            'mask_empty_slice',
@@ -132,28 +134,24 @@ def find_center(
 
     # extract slice we are using to find center
     if sinogram_order:
-        tomo_ind = tomo[ind:ind + 1]
+        sino = tomo[ind]
     else:
-        tomo_ind = tomo[:, ind:ind + 1, :]
+        sino = tomo[:, ind, :]
 
-    hmin, hmax = _adjust_hist_limits(
-        tomo_ind, theta, mask, sinogram_order)
+    hmin, hmax = _adjust_hist_limits(sino, theta, mask)
 
     # Magic is ready to happen...
     res = minimize(
         _find_center_cost, init,
-        args=(tomo_ind, theta, hmin, hmax, mask, ratio, sinogram_order),
+        args=(sino, theta, hmin, hmax, mask, ratio),
         method='Nelder-Mead',
         tol=tol)
     return res.x
 
 
-def _adjust_hist_limits(tomo_ind, theta, mask, sinogram_order):
+def _adjust_hist_limits(sino, theta, mask):
     # Make an initial reconstruction to adjust histogram limits.
-    rec = recon(tomo_ind,
-                theta,
-                sinogram_order=sinogram_order,
-                algorithm='gridrec')
+    rec = _sweep_gridrec(sino, theta, sino.shape[1] / 2.)
 
     # Apply circular mask.
     if mask is True:
@@ -179,18 +177,12 @@ def _adjust_hist_max(val):
     return val
 
 
-def _find_center_cost(
-        center, tomo_ind, theta, hmin, hmax, mask, ratio,
-        sinogram_order=False):
+def _find_center_cost(center, sino, theta, hmin, hmax, mask, ratio):
     """
     Cost function used for the ``find_center`` routine.
     """
     logger.info('Trying rotation center: %s', center)
-    center = np.array(center, dtype='float32')
-    rec = recon(
-        tomo_ind, theta, center,
-        sinogram_order=sinogram_order,
-        algorithm='gridrec')
+    rec = _sweep_gridrec(sino, theta, center)
 
     if mask is True:
         rec = circ_mask(rec, axis=0)
@@ -203,7 +195,7 @@ def _find_center_cost(
 
 
 def find_center_vo(tomo, ind=None, smin=-50, smax=50, srad=6, step=0.25,
-                   ratio=0.5, drop=20):
+                   ratio=0.5, drop=20, ncore=None):
     """
     Find rotation axis location using Nghia Vo's method. :cite:`Vo:14`.
 
@@ -224,6 +216,8 @@ def find_center_vo(tomo, ind=None, smin=-50, smax=50, srad=6, step=0.25,
         It's used to generate the mask.
     drop : int, optional
         Drop lines around vertical center of the mask.
+    ncore : int, optional
+        Number of cores that will be assigned to the metric evaluation.
 
     Returns
     -------
@@ -242,99 +236,163 @@ def find_center_vo(tomo, ind=None, smin=-50, smax=50, srad=6, step=0.25,
     else:
         _tomo = tomo[:, ind, :]
 
+    fine_cen = _search_vo(
+        _tomo[np.newaxis], smin, smax, srad, step, ratio, drop, ncore)[0]
+    logger.debug('Rotation center search finished: %i', fine_cen)
+    return fine_cen
+
+
+def find_center_tilt(tomo, ind=None, nind=8, order=1, smin=-50, smax=50,
+                     srad=6, step=0.25, ratio=0.5, drop=20, ncore=None):
+    """
+    Find the rotation axis location of every slice, allowing for a tilted
+    rotation axis.
+
+    Nghia Vo's method :cite:`Vo:14` is run on a sparse set of slices at
+    once and a polynomial is fitted through the centers found.
+
+    Parameters
+    ----------
+    tomo : ndarray
+        3D tomographic data.
+    ind : array of int, optional
+        Indices of the slices to be searched. By default ``nind`` evenly
+        spaced slices away from the edges are used.
+    nind : int, optional
+        Number of slices searched when ``ind`` is not given.
+    order : int, optional
+        Order of the polynomial fitted to the centers: 1 for a tilted axis,
+        2 to also allow for curvature.
+    smin, smax : int, optional
+        Coarse search radius. Reference to the horizontal center of the sinogram.
+    srad : float, optional
+        Fine search radius.
+    step : float, optional
+        Step of fine searching.
+    ratio : float, optional
+        The ratio between the FOV of the camera and the size of object.
+        It's used to generate the mask.
+    drop : int, optional
+        Drop lines around vertical center of the mask.
+    ncore : int, optional
+        Number of cores that will be assigned to the metric evaluation.
+
+    Returns
+    -------
+    ndarray
+        Rotation axis location for every slice.
+    """
+    (depth, height, width) = tomo.shape
+    if ind is None:
+        ind = np.linspace(0, height - 1, nind + 2)[1:-1]
+    ind = np.unique(np.round(ind).astype('int'))
+    # Only the searched sinograms are converted.
+    sino = dtype.as_float32(np.swapaxes(tomo[:, ind, :], 0, 1))
+    cen = _search_vo(sino, smin, smax, srad, step, ratio, drop, ncore)
+    # Slices without sample give arbitrary centers. Drop those far from a
+    # robust (Theil-Sen) line before fitting.
+    i, j = np.triu_indices(ind.size, 1)
+    slope = np.median((cen[j] - cen[i]) / (ind[j] - ind[i])) \
+        if ind.size > 1 else 0.0
+    res = np.abs(cen - slope * ind - np.median(cen - slope * ind))
+    keep = res <= max(5 * np.median(res), 2.0)
+    fit = np.polyfit(ind[keep], cen[keep], min(order, keep.sum() - 1))
+    logger.debug('Rotation axis fit coefficients: %s', fit)
+    return dtype.as_float32(np.polyval(fit, np.arange(height)))
+
+
+def _search_vo(sino, smin, smax, srad, step, ratio, drop, ncore=None):
+    """
+    Coarse and fine searches on a stack of sinograms (nsino, nrow, ncol),
+    returning one center per sinogram.
+    """
     # Denoising
     # There's a critical reason to use different window sizes
     # between coarse and fine search.
-    _tomo_cs = ndimage.filters.gaussian_filter(_tomo, (3, 1))
-    _tomo_fs = ndimage.filters.gaussian_filter(_tomo, (2, 2))
+    sino_cs = ndimage.filters.gaussian_filter(sino, (0, 3, 1))
+    sino_fs = ndimage.filters.gaussian_filter(sino, (0, 2, 2))
 
     # Coarse and fine searches for finding the rotation center.
-    if _tomo.shape[0] * _tomo.shape[1] > 4e6:  # If data is large (>2kx2k)
-        _tomo_coarse = downsample(
-            np.expand_dims(_tomo_cs, 1), level=2)[:, 0, :]
+    if sino.shape[1] * sino.shape[2] > 4e6:  # If data is large (>2kx2k)
+        sino_coarse = downsample(sino_cs, level=2)
         init_cen = _search_coarse(
-            _tomo_coarse, smin / 4.0, smax / 4.0, ratio, drop)
-        fine_cen = _search_fine(_tomo_fs, srad, step,
-                                init_cen * 4, ratio, drop)
-    else:
-        init_cen = _search_coarse(_tomo_cs, smin, smax, ratio, drop)
-        fine_cen = _search_fine(_tomo_fs, srad, step, init_cen, ratio, drop)
-
-    logger.debug('Rotation center search finished: %i', fine_cen)
-    return fine_cen
+            sino_coarse, smin / 4.0, smax / 4.0, ratio, drop, ncore)
+        return _search_fine(
+            sino_fs, srad, step, init_cen * 4, ratio, drop, ncore)
+    init_cen = _search_coarse(sino_cs, smin, smax, ratio, drop, ncore)
+    return _search_fine(sino_fs, srad, step, init_cen, ratio, drop, ncore)
 
 
-def _search_coarse(sino, smin, smax, ratio, drop):
+def _search_coarse(sino, smin, smax, ratio, drop, ncore=None):
     """
-    Coarse search for finding the rotation center.
+    Coarse search for finding the rotation center of each sinogram.
     """
-    (nrow, ncol) = sino.shape
+    (nrow, ncol) = sino.shape[-2:]
     cen_fliplr = (ncol - 1.0) / 2.0
     smin = np.int16(np.clip(smin + cen_fliplr, 0, ncol - 1) - cen_fliplr)
     smax = np.int16(np.clip(smax + cen_fliplr, 0, ncol - 1) - cen_fliplr)
-    # Flip left-right the [0:Pi ] sinogram to make a full [0;2Pi] sinogram
-    flip_sino = np.fliplr(sino)
-    # Below image is used for compensating the shift of the [Pi;2Pi] sinogram
-    # It helps to avoid local minima.
-    comp_sino = np.flipud(sino)
     list_shift = np.arange(smin, smax + 1)
-    list_metric = np.zeros(len(list_shift), dtype='float32')
-    mask = _create_mask(2 * nrow, ncol, 0.5 * ratio * ncol, drop)
-    sino_sino = np.vstack((sino, flip_sino))
-    abs_fft2_sino = np.empty_like(sino_sino)
-    for i in list_shift:
-        _sino = sino_sino[nrow:]
-        _sino[...] = np.roll(flip_sino, i, axis=1)
-        if i >= 0:
-            _sino[:, 0:i] = comp_sino[:, 0:i]
-        else:
-            _sino[:, i:] = comp_sino[:, i:]
-        fft2sino = np.fft.fftshift(fft2(sino_sino))
-        np.abs(fft2sino, out=abs_fft2_sino)
-        abs_fft2_sino *= mask
-        list_metric[i - smin] = abs_fft2_sino.mean()
-    minpos = np.argmin(list_metric)
-    if minpos == 0:
+    list_metric = _calc_metric(sino, list_shift, ratio, drop, ncore)
+    minpos = np.argmin(list_metric, axis=-1)
+    if np.any(minpos == 0):
         logger.debug('WARNING!!!Global minimum is out of searching range')
         logger.debug('Please extend smin: %i', smin)
-    if minpos == len(list_metric) - 1:
+    if np.any(minpos == len(list_shift) - 1):
         logger.debug('WARNING!!!Global minimum is out of searching range')
         logger.debug('Please extend smax: %i', smax)
     init_cen = cen_fliplr + list_shift[minpos] / 2.0
     return init_cen
 
 
-def _search_fine(sino, srad, step, init_cen, ratio, drop):
+def _search_fine(sino, srad, step, init_cen, ratio, drop, ncore=None):
     """
-    Fine search for finding the rotation center.
+    Fine search for finding the rotation center of each sinogram.
     """
-    (nrow, ncol) = sino.shape
+    (nrow, ncol) = sino.shape[-2:]
     cen_fliplr = (ncol - 1.0) / 2.0
     srad = np.clip(np.abs(srad), 1.0, ncol / 4.0)
     step = np.clip(np.abs(step), 0.1, srad)
     init_cen = np.clip(init_cen, srad, ncol - srad - 1)
-    list_cor = init_cen + np.arange(-srad, srad + step, step)
-    flip_sino = np.fliplr(sino)
-    comp_sino = np.flipud(sino)  # Used to avoid local minima
-    list_metric = np.zeros(len(list_cor), dtype=np.float32)
-    mask = _create_mask(2 * nrow, ncol, 0.5 * ratio * ncol, drop)
-    for i, cor in enumerate(list_cor):
-        shift = 2.0 * (cor - cen_fliplr)
-        sino_shift = ndimage.interpolation.shift(
-            flip_sino, (0, shift), order=3, prefilter=True)
-        if shift >= 0:
-            shift_int = np.int16(np.ceil(shift))
-            sino_shift[:, :shift_int] = comp_sino[:, :shift_int]
-        else:
-            shift_int = np.int16(np.floor(shift))
-            sino_shift[:, shift_int:] = comp_sino[:, shift_int:]
-        sinojoin = np.vstack((sino, sino_shift))
-        list_metric[i] = np.mean(np.abs(
-            np.fft.fftshift(fft2(sinojoin))) * mask)
-    cor = list_cor[np.argmin(list_metric)]
+    list_cor = init_cen[:, np.newaxis] + \
+        np.arange(-srad, srad + step, step)[np.newaxis]
+    list_shift = 2.0 * (list_cor - cen_fliplr)
+    list_metric = _calc_metric(sino, list_shift, ratio, drop, ncore)
+    minpos = np.argmin(list_metric, axis=-1)
+    cor = list_cor[np.arange(minpos.size), minpos]
     return cor
 
 
+def _calc_metric(sino, list_shift, ratio, drop, ncore=None):
+    """
+    Evaluate the double-wedge metric of a sinogram joined with its flipped
+    copy for every shift in ``list_shift``.
+
+    The [Pi;2Pi] half is the left-right flipped sinogram shifted along the
+    detector axis. The shift is applied as a phase ramp on a single Fourier
+    transform of the joined sinogram, so it is circular and may be
+    fractional. ``sino`` may also be a stack of sinograms, searched with
+    the same shifts or with one row of ``list_shift`` each.
+
+    Returns
+    -------
+    ndarray
+        Metric value for each shift.
+    """
+    sino = np.asarray(sino)
+    (nrow, ncol) = sino.shape[-2:]
+    stack = sino.reshape((-1, nrow, ncol))
+    mask = _create_mask(2 * nrow, ncol, 0.5 * ratio * ncol, drop)
+    list_shift = np.asarray(list_shift, dtype='float32')
+    list_shift = np.broadcast_to(
+        list_shift, (stack.shape[0], list_shift.shape[-1]))
+    list_metric = np.zeros(list_shift.shape, dtype='float32')
+    extern.c_vo_center_metric(
+        dtype.as_float32(np.ascontiguousarray(stack)),
+        dtype.as_float32(mask), np.ascontiguousarray(list_shift), ncore,
+        list_metric)
+    return list_metric.reshape(sino.shape[:-2] + list_metric.shape[-1:])
+
+
 def _create_mask(nrow, ncol, radius, drop):
     """
     Make a binary mask to select coefficients outside the double-wedge region.
@@ -529,22 +587,24 @@ def write_center(
     else:
         center = np.arange(*cen_range)
 
-    stack = dtype.empty_shared_array((len(center), dt, dx))
-
-    for m in range(center.size):
-        if sinogram_order:
-            stack[m] = tomo[ind]
-        else:
-            stack[m] = tomo[:, ind, :]
+    if sinogram_order:
+        sino = tomo[ind]
+    else:
+        sino = tomo[:, ind, :]
 
     # Reconstruct the same slice with a range of centers.
-    rec = recon(stack,
-                theta,
-                center=center,
-                sinogram_order=True,
-                algorithm=algorithm,
-                filter_name=filter_name,
-                nchunk=1)
+    if algorithm == 'gridrec':
+        rec = _sweep_gridrec(sino, theta, center, filter_name=filter_name)
+    else:
+        stack = dtype.empty_shared_array((len(center), dt, dx))
+        stack[:] = sino
+        rec = recon(stack,
+                    theta,
+                    center=center,
+                    sinogram_order=True,
+                    algorithm=algorithm,
+                    filter_name=filter_name,
+                    nchunk=1)
 
     # Apply circular mask.
     if mask is True:
@@ -555,6 +615,45 @@ def write_center(
         write_tiff(data=rec[m], fname=dpath, digit='{0:.2f}'.format(center[m]))
 
 
+def _sweep_gridrec(sino, theta, center, filter_name='shepp', filter_par=None):
+    """
+    Reconstruct a single sinogram with gridrec at every given center.
+
+    The projections are Fourier transformed once and only the phase factor
+    changes between centers.
+
+    Parameters
+    ----------
+    sino : ndarray
+        2D sinogram (theta, x).
+    theta : array
+        Projection angles in radian.
+    center : float or array
+        Rotation centers.
+    filter_name : str, optional
+        Name of the gridrec filter.
+    filter_par : array, optional
+        Filter parameters.
+
+    Returns
+    -------
+    ndarray
+        Reconstructed slices, one per center.
+    """
+    sino = np.ascontiguousarray(dtype.as_float32(sino))
+    theta = dtype.as_float32(theta)
+    center = dtype.as_float32(np.atleast_1d(center))
+    if filter_par is None:
+        filter_par = np.array([0.5, 8], dtype='float32')
+    dx = sino.shape[1]
+    rec = np.empty((center.size, dx, dx), dtype='float32')
+    extern.c_gridrec_sweep(
+        sino, center, rec, theta,
+        num_gridx=dx, num_gridy=dx, filter_name=filter_name,
+        filter_par=dtype.as_float32(filter_par))
+    return rec
+
+
 def mask_empty_slice(tomo, threshold=0.25):
     """
     Generate a mask to indicate whether current slice contains sample
@@ -57,6 +57,7 @@ import numpy as np
 import tomopy.util.extern as extern
 import tomopy.util.dtype as dtype
 import tomopy.util.mproc as mproc
+from tomopy.misc.morph import swap_stack_order
 import logging
 
 logger = logging.getLogger(__name__)
@@ -69,6 +70,7 @@ __all__ = ['angles',
            'project',
            'project2',
            'project3',
+           'project_cone',
            'fan_to_para',
            'para_to_fan',
            'add_gaussian',
@@ -201,15 +203,16 @@ def project(
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
-        Chunk size for each core.
+        Maximum number of slices projected together. By default the slab of
+        slices is bounded by memory.
 
     Returns
     -------
     ndarray
         3D tomographic data.
     """
-    obj = dtype.as_float32(obj)
-    theta = dtype.as_float32(theta)
+    obj = np.ascontiguousarray(dtype.as_float32(obj))
+    theta = np.ascontiguousarray(dtype.as_float32(theta))
 
     # Estimate data dimensions.
     oy, ox, oz = obj.shape
@@ -220,26 +223,19 @@ def project(
     elif pad is False:
         dx = ox
     shape = dy, dt, dx
-    tomo = dtype.empty_shared_array(shape)
-    tomo[:] = 0.0
+    tomo = np.zeros(shape, dtype='float32')
     center = get_center(shape, center)
 
-    tomo = mproc.distribute_jobs(
-        (obj, center, tomo),
-        func=extern.c_project,
-        args=(theta,),
-        axis=0,
-        ncore=ncore,
-        nchunk=nchunk)
+    # Rays are traced once per slab and gather all of its slices; the
+    # angles are spread over the cores.
+    extern.c_project(obj, center, tomo, theta, ncore=ncore, nchunk=nchunk)
     # NOTE: returns sinogram order with emmission=True
     if not emission:
         # convert data to be transmission type
         np.exp(-tomo, tomo)
     if not sinogram_order:
         # rotate to radiograph order
-        tomo = np.swapaxes(tomo, 0, 1)  # doesn't copy data
-        # copy data to sharedmem
-        tomo = dtype.as_sharedmem(tomo, copy=True)
+        tomo = swap_stack_order(tomo, ncore=ncore)
 
     return tomo
 
@@ -270,16 +266,17 @@ def project2(
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
-        Chunk size for each core.
+        Maximum number of slices projected together. By default the slab of
+        slices is bounded by memory.
 
     Returns
     -------
     ndarray
         3D tomographic data.
     """
-    objx = dtype.as_float32(objx)
-    objy = dtype.as_float32(objy)
-    theta = dtype.as_float32(theta)
+    objx = np.ascontiguousarray(dtype.as_float32(objx))
+    objy = np.ascontiguousarray(dtype.as_float32(objy))
+    theta = np.ascontiguousarray(dtype.as_float32(theta))
 
     # Estimate data dimensions.
     oy, ox, oz = objx.shape
@@ -290,21 +287,19 @@ def project2(
     elif pad is False:
         dx = ox
     shape = dy, dt, dx
-    tomo = dtype.empty_shared_array(shape)
-    tomo[:] = 0.0
+    tomo = np.zeros(shape, dtype='float32')
     center = get_center(shape, center)
 
-    extern.c_project2(objx, objy, center, tomo, theta)
-    
+    extern.c_project2(objx, objy, center, tomo, theta, ncore=ncore,
+                      nchunk=nchunk)
+
     # NOTE: returns sinogram order with emmission=True
     if not emission:
         # convert data to be transmission type
         np.exp(-tomo, tomo)
     if not sinogram_order:
         # rotate to radiograph order
-        tomo = np.swapaxes(tomo, 0, 1)  # doesn't copy data
-        # copy data to sharedmem
-        tomo = dtype.as_sharedmem(tomo, copy=True)
+        tomo = swap_stack_order(tomo, ncore=ncore)
 
     return tomo
 
@@ -336,17 +331,18 @@ def project3(
     ncore : int, optional
         Number of cores that will be assigned to jobs.
     nchunk : int, optional
-        Chunk size for each core.
+        Maximum number of slices projected together. By default the slab of
+        slices is bounded by memory.
 
     Returns
     -------
     ndarray
         3D tomographic data.
     """
-    objx = dtype.as_float32(objx)
-    objy = dtype.as_float32(objy)
-    objz = dtype.as_float32(objz)
-    theta = dtype.as_float32(theta)
+    objx = np.ascontiguousarray(dtype.as_float32(objx))
+    objy = np.ascontiguousarray(dtype.as_float32(objy))
+    objz = np.ascontiguousarray(dtype.as_float32(objz))
+    theta = np.ascontiguousarray(dtype.as_float32(theta))
 
     # Estimate data dimensions.
     oy, ox, oz = objx.shape
@@ -357,23 +353,95 @@ def project3(
     elif pad is False:
         dx = ox
     shape = dy, dt, dx
-    # print (shape)
-    tomo = dtype.empty_shared_array(shape)
-    tomo[:] = 0.0
+    tomo = np.zeros(shape, dtype='float32')
     center = get_center(shape, center)
 
-    extern.c_project3(objx, objy, objz, center, tomo, theta, axis)
-    
+    extern.c_project3(objx, objy, objz, center, tomo, theta, axis,
+                      ncore=ncore, nchunk=nchunk)
+
+    # NOTE: returns sinogram order with emmission=True
+    if not emission:
+        # convert data to be transmission type
+        np.exp(-tomo, tomo)
+    if not sinogram_order:
+        # rotate to radiograph order
+        tomo = swap_stack_order(tomo, ncore=ncore)
+
+    return tomo
+
+
+def project_cone(
+        obj, theta, dist, center=None, vcenter=None, emission=True,
+        pad=True, sinogram_order=False, ncore=None, nchunk=None):
+    """
+    Project a cone beam from a point source through a given 3D object onto
+    a flat detector, the source moving on a circle around the object.
+
+    Lengths are in voxels, with the detector scaled down to the rotation
+    axis. For a source-to-axis distance ``sod``, source-to-detector
+    distance ``sdd`` and detector pixel size ``pixel``, the voxel size is
+    ``pixel * sod / sdd`` and ``dist = sdd / pixel``.
+
+    Parameters
+    ----------
+    obj : ndarray
+        Voxelized 3D object.
+    theta : array
+        Projection angles in radian.
+    dist : float
+        Distance from the source to the rotation axis in voxels.
+    center: float, optional
+        Location of rotation axis along the detector columns.
+    vcenter: float, optional
+        Detector row hit by the central ray.
+    emission : bool, optional
+        Determines whether output data is emission or transmission type.
+    pad : bool, optional
+        Determines if the projection image will be padded or not. If True,
+        the detector covers the magnified object.
+    sinogram_order: bool, optional
+        Determines whether output data is a stack of sinograms (True, y-axis first axis)
+        or a stack of radiographs (False, theta first axis).
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+    nchunk : int, optional
+        Number of detector rows projected together. By default the slab of
+        slices they read is bounded by memory.
+
+    Returns
+    -------
+    ndarray
+        3D tomographic data.
+    """
+    obj = np.ascontiguousarray(dtype.as_float32(obj))
+    theta = np.ascontiguousarray(dtype.as_float32(theta))
+
+    # Estimate data dimensions.
+    oy, ox, oz = obj.shape
+    rad = 0.5 * np.sqrt(ox * ox + oz * oz)
+    if dist <= rad:
+        raise ValueError('The source must be outside the object.')
+    dt = theta.size
+    if pad is True:
+        dy = _round_to_even(oy * dist / (dist - rad) + 2)
+        dx = _round_to_even(2 * rad * dist / np.sqrt(dist**2 - rad**2) + 2)
+    elif pad is False:
+        dy, dx = oy, ox
+    center = dx / 2. if center is None else center
+    vcenter = dy / 2. if vcenter is None else vcenter
+    tomo = np.zeros((dy, dt, dx), dtype='float32')
+
+    extern.c_project_cone(obj, center, vcenter, tomo, theta, dist,
+                          ncore=ncore, nchunk=nchunk)
+
     # NOTE: returns sinogram order with emmission=True
     if not emission:
         # convert data to be transmission type
         np.exp(-tomo, tomo)
     if not sinogram_order:
         # rotate to radiograph order
-        tomo = np.swapaxes(tomo, 0, 1)  # doesn't copy data
-        # copy data to sharedmem
-        tomo = dtype.as_sharedmem(tomo, copy=True)
-        
+        tomo = swap_stack_order(tomo, ncore=ncore)
+
     return tomo
 
 
@@ -54,6 +54,9 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import numpy as np
+import tomopy.util.extern as extern
+import tomopy.util.dtype as dtype
+from tomopy.prep.phase import _wavelength
 import logging
 
 logger = logging.getLogger(__name__)
@@ -64,10 +67,11 @@ __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
 __docformat__ = 'restructuredtext en'
 __all__ = ['calc_intensity',
            'propagate_tie',
+           'propagate_fresnel',
            'probe_gauss']
 
 
-def propagate_tie(mu, delta, pixel_size, dist):
+def propagate_tie(mu, delta, pixel_size, dist, ncore=None):
     """
     Propagate emitting x-ray wave based on Transport of Intensity.
 
@@ -81,20 +85,63 @@ def propagate_tie(mu, delta, pixel_size, dist):
         Detector pixel size in cm.
     dist : float
         Propagation distance of the wavefront in cm.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
 
     Returns
     -------
     ndarray
-        3D propagated tomographic intensity.
+        3D propagated tomographic intensity, as float32.
     """
-    i1 = np.exp(-mu)
-    i2 = np.zeros(delta.shape)
-    for m in range(delta.shape[0]):
-        dx, dy = np.gradient(delta[m], pixel_size)
-        d2x, _ = np.gradient(i1[m] * dx, pixel_size)
-        _, d2y = np.gradient(i1[m] * dy, pixel_size)
-        i2[m] = i1[m] + dist * (d2x + d2y)
-    return i2
+    mu, delta = _as_stacks(mu, delta)
+    out = np.empty(delta.shape, dtype=np.float32)
+    return extern.c_propagate_tie(mu, delta, out, pixel_size, dist, ncore)
+
+
+def propagate_fresnel(mu, delta, pixel_size, dist, energy, ncore=None):
+    """
+    Propagate emitting x-ray wave with the Fresnel propagator.
+
+    The exit wave exp(-mu / 2 - i k delta), with k the wavenumber, is
+    propagated in Fourier space with periodic boundaries. For short
+    distances the intensity approaches that of :func:`propagate_tie`.
+
+    Parameters
+    ----------
+    mu : ndarray
+        3D tomographic data for attenuation.
+    delta : ndarray
+        3D tomographic data for refractive index.
+    pixel_size : float
+        Detector pixel size in cm.
+    dist : float
+        Propagation distance of the wavefront in cm.
+    energy : float
+        Energy of incident wave in keV.
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
+
+    Returns
+    -------
+    ndarray
+        3D propagated tomographic intensity, as float32.
+    """
+    mu, delta = _as_stacks(mu, delta)
+    out = np.empty(delta.shape, dtype=np.float32)
+    return extern.c_propagate_fresnel(
+        mu, delta, out, pixel_size, dist, _wavelength(energy), ncore)
+
+
+def _as_stacks(mu, delta):
+    """
+    C-contiguous float32 copies of the attenuation and refractive index
+    stacks, which must share one 3D shape.
+    """
+    mu = np.ascontiguousarray(dtype.as_float32(mu))
+    delta = np.ascontiguousarray(dtype.as_float32(delta))
+    if mu.shape != delta.shape or delta.ndim != 3:
+        raise ValueError('mu and delta must be 3D arrays of one shape')
+    return mu, delta
 
 
 def probe_gauss(nx, ny, fwhm=None, center=None, max_int=1):
@@ -157,27 +204,50 @@ def _rect_scan_coords(probe_grid, proj_grid, shift_x, shift_y):
     return x, y
 
 
-def _rect_scan_probe(probe, proj, shift_x=None, shift_y=None):
+def _as_complex64(arr):
+    return dtype.as_dtype(arr, np.complex64)
+
+
+def calc_intensity(probe, proj, shift_x=None, shift_y=None, mode='near',
+                   ncore=None):
     """
-    Calculate individual raster scanned images for a given rectangular
-    x-ray probe and an object plane intensity.
+    Calculate the intensity of a probe raster scanned over projections.
+
+    At each scan position the probe multiplies the window of the projection
+    it covers. The near field intensity is the squared modulus of that
+    product, the far field intensity the squared modulus of its centered 2D
+    Fourier transform.
 
     Parameters
     ----------
     probe : ndarray
-        Rectangular x-ray source kernel.
+        Rectangular x-ray source kernel, real or complex.
     proj : ndarray
-        Object plane intensity image.
+        Object plane image, or a 3D stack of them, real or complex.
     shift_x, shift_y : int, optional
         Shift amount of probe along x and y axes.
+    mode : str, optional
+        Specify the regime. 'near' or 'far'
+    ncore : int, optional
+        Number of cores that will be assigned to jobs.
 
     Returns
     -------
     ndarray
-        Individual raster scanned images as 3D array.
+        Intensity images of the scan positions as 3D float32 array, or one
+        such array per projection for a stack.
     """
+    if mode not in ('near', 'far'):
+        raise ValueError("mode must be 'near' or 'far'")
+    proj = np.asarray(proj)
+    probe = np.asarray(probe)
+    # Complex input keeps its phase, both are taken as complex64 then.
+    cplx = np.iscomplexobj(probe) or np.iscomplexobj(proj)
+    as_dtype = _as_complex64 if cplx else dtype.as_float32
+    probe = np.ascontiguousarray(as_dtype(probe))
+    stack = np.ascontiguousarray(
+        as_dtype(proj.reshape((-1,) + proj.shape[-2:])))
     sx, sy = probe.shape
-    px, py = proj.shape
 
     # Assume half overlap.
     if shift_x is None:
@@ -186,36 +256,12 @@ def _rect_scan_probe(probe, proj, shift_x=None, shift_y=None):
         shift_y = sy // 2
 
     # Calculate upper-left scan coordinates along x and y axes.
-    x, y = _rect_scan_coords(probe.shape, proj.shape, shift_x, shift_y)
-
-    # Convert to image stack.
-    arr = [probe * proj[i:i + sx, j:j + sy] for i in x for j in y]
-    return np.array(arr)
-
-
-def calc_intensity(probe, proj, shift_x=None, shift_y=None, mode='near'):
-    """
-    Calculate far field intensity.
-
-    Parameters
-    ----------
-    probe : ndarray
-        Rectangular x-ray source kernel.
-    proj : ndarray
-        Object plane intensity image.
-    shift_x, shift_y : int, optional
-        Shift amount of probe along x and y axes.
-    mode : str, optional
-        Specify the regime. 'near' or 'far'
+    x, y = _rect_scan_coords(probe.shape, stack.shape[1:], shift_x, shift_y)
+    x = np.ascontiguousarray(x, dtype=np.int32)
+    y = np.ascontiguousarray(y, dtype=np.int32)
 
-    Returns
-    -------
-    ndarray
-        Individual raster scanned far field images as 3D array.
-    """
-    psi = _rect_scan_probe(probe, proj, shift_x, shift_y)
-    if mode == 'near':
-        intensity = abs(psi) ** 2
-    elif mode == 'far':
-        intensity = abs(np.fft.fftshift(np.fft.fft2(psi))) ** 2
-    return intensity
+    out = np.empty((stack.shape[0], x.size * y.size, sx, sy),
+                   dtype=np.float32)
+    extern.c_calc_intensity(
+        probe, stack, x, y, cplx, mode == 'far', out, ncore)
+    return out if proj.ndim == 3 else out[0]
@@ -54,6 +54,10 @@ from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
 import ctypes
+import mmap
+import os
+import tempfile
+import weakref
 import numpy as np
 import multiprocessing as mp
 import logging
@@ -74,6 +78,7 @@ __all__ = ['as_ndarray',
            'as_c_float_p',
            'as_c_int',
            'as_c_int_p',
+           'as_c_uint16_p',
            'as_c_float',
            'as_c_char_p',
            'as_c_void_p']
@@ -125,6 +130,11 @@ def as_c_int_p(arr):
     return arr.ctypes.data_as(c_int_p)
 
 
+def as_c_uint16_p(arr):
+    c_uint16_p = ctypes.POINTER(ctypes.c_uint16)
+    return arr.ctypes.data_as(c_uint16_p)
+
+
 def as_c_float(arr):
     return ctypes.c_float(arr)
 
@@ -200,3 +210,142 @@ def empty_shared_array(shape, dtype=np.float32):
     arr = np.frombuffer(shared_obj, dtype)
     arr = arr.reshape(shape)
     return arr
+
+
+# Directory holding the files behind mapped arrays. /dev/shm keeps them in
+# POSIX shared memory where available and large enough, see _mapped_dir.
+MAPPED_DIR = '/dev/shm' if os.path.isdir('/dev/shm') else tempfile.gettempdir()
+
+
+class _NamedMap(mmap.mmap):
+    """Shared mapping that remembers the file it can be reopened from."""
+    name = None
+    release = None
+
+
+def _unlink_quietly(name):
+    try:
+        os.unlink(name)
+    except OSError:
+        pass
+
+
+def _free_bytes(path):
+    if not hasattr(os, 'statvfs'):
+        return None
+    try:
+        st = os.statvfs(path)
+    except OSError:
+        return None
+    return st.f_bavail * st.f_frsize
+
+
+def _mapped_dir(nbytes):
+    """
+    MAPPED_DIR if it has room for ``nbytes``, otherwise the temp dir. A
+    small /dev/shm (64 MB in Docker by default) would otherwise fault on
+    the first page written past its capacity.
+    """
+    free = _free_bytes(MAPPED_DIR)
+    if free is None or free >= nbytes:
+        return MAPPED_DIR
+    logger.warning('%s has %d bytes free, mapping %d bytes in %s',
+                   MAPPED_DIR, free, nbytes, tempfile.gettempdir())
+    return tempfile.gettempdir()
+
+
+def _mapped_file(nbytes, dirname):
+    # Blocks are reserved up front, so a full file system fails here with
+    # an OSError rather than with SIGBUS on a later page fault.
+    fd, name = tempfile.mkstemp(prefix='tomopy-', dir=dirname)
+    try:
+        if hasattr(os, 'posix_fallocate'):
+            os.posix_fallocate(fd, 0, nbytes)
+        else:
+            os.ftruncate(fd, nbytes)
+        buf = _NamedMap(fd, nbytes)
+    except BaseException:
+        os.close(fd)
+        _unlink_quietly(name)
+        raise
+    os.close(fd)
+    return buf, name
+
+
+def empty_mapped_array(shape, dtype=np.float32):
+    """
+    Create an ndarray in a named shared mapping.
+
+    Other processes attach to the same memory with :func:`map_array`, so
+    arrays allocated here are handed to workers without any copy. The
+    backing file is removed once the array is garbage collected or
+    :func:`release_mapped` is called.
+    """
+    dtype = np.dtype(dtype)
+    nbytes = max(int(np.prod(shape)) * dtype.itemsize, 1)
+    dirname = _mapped_dir(nbytes)
+    try:
+        buf, name = _mapped_file(nbytes, dirname)
+    except OSError:
+        if dirname == tempfile.gettempdir():
+            raise
+        buf, name = _mapped_file(nbytes, tempfile.gettempdir())
+    buf.name = name
+    buf.release = weakref.finalize(buf, _unlink_quietly, name)
+    return np.frombuffer(buf, dtype, int(np.prod(shape))).reshape(shape)
+
+
+def _mapped_base(arr):
+    base = arr
+    while isinstance(base, np.ndarray):
+        base = base.base
+    if isinstance(base, memoryview):
+        base = base.obj
+    return base if isinstance(base, _NamedMap) else None
+
+
+def release_mapped(arr):
+    """
+    Remove the file behind a mapped array now. ``arr`` stays usable in
+    this process, but no other process can attach to it any more.
+    """
+    base = _mapped_base(arr)
+    if base is not None and base.release is not None:
+        base.release()
+
+
+def get_mapped_name(arr):
+    """
+    Name of the shared mapping that ``arr`` covers entirely, or None.
+    """
+    base = _mapped_base(arr)
+    if base is None or not arr.flags.c_contiguous:
+        return None
+    if arr.__array_interface__['data'][0] != \
+            np.frombuffer(base, np.uint8, 1).__array_interface__['data'][0]:
+        return None
+    return base.name
+
+
+def as_mapped(arr):
+    """
+    Return ``arr`` if it already lives in a named shared mapping, otherwise
+    a copy of it in a new one.
+    """
+    if get_mapped_name(arr) is not None:
+        return arr
+    mapped = empty_mapped_array(arr.shape, arr.dtype)
+    mapped[...] = arr
+    return mapped
+
+
+def map_array(name, dtype, shape):
+    """
+    Attach to the shared mapping ``name`` created by another process.
+    """
+    dtype = np.dtype(dtype)
+    nbytes = int(np.prod(shape)) * dtype.itemsize
+    with open(name, 'r+b') as f:
+        buf = mmap.mmap(f.fileno(), max(nbytes, 1))
+    return np.frombuffer(buf, dtype, int(np.prod(shape))).reshape(shape)
+
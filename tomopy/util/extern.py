@@ -70,22 +70,40 @@ __all__ = ['c_shared_lib',
            'c_project',
            'c_project2',
            'c_project3',
+           'c_project_cone',
+           'c_propagate_tie',
+           'c_propagate_fresnel',
+           'c_calc_intensity',
            'c_normalize_bg',
+           'c_normalize_fused',
+           'c_retrieve_phase',
            'c_remove_stripe_sf',
+           'c_remove_stripe_based_sorting',
+           'c_remove_stripe_based_filtering',
+           'c_remove_stripe_based_fitting',
+           'c_remove_large_stripe',
+           'c_remove_dead_stripe',
+           'c_remove_all_stripe',
            'c_sample',
-           'c_art',
-           'c_bart',
-           'c_fbp',
-           'c_gridrec',
-           'c_mlem',
-           'c_osem',
-           'c_ospml_hybrid',
-           'c_ospml_quad',
-           'c_pml_hybrid',
-           'c_pml_quad',
-           'c_sirt',
-           'c_tv',
-           'c_grad',
+           'c_swap_stack',
+           'c_swap_stack_inplace',
+           'c_sino_360_to_180',
+           'c_pad_volume',
+           'c_profile_enabled',
+           'c_profile_reset',
+           'c_profile_phases',
+           'c_profile_events',
+           'c_set_num_threads',
+           'c_get_num_threads',
+           'c_has_openmp',
+           'c_set_numa_mode',
+           'c_get_numa_mode',
+           'c_touch_volume',
+           'c_volume_bandwidth',
+           'c_recon_volume',
+           'c_vo_center_metric',
+           'c_fdk',
+           'c_gridrec_sweep',
            'c_vector',
            'c_vector2',
            'c_vector3',
@@ -113,8 +131,12 @@ def c_shared_lib(lib_name):
 
 LIB_TOMOPY = c_shared_lib('libtomopy')
 
+# Padding modes of the pad-aware kernels, PAD_* in utils.h.
+PAD_MODES = {'constant': 0, 'edge': 1, 'reflect': 2}
 
-def c_normalize_bg(tomo, air):
+
+def c_normalize_bg(tomo, air, median=False, ncore=None, nchunk=None):
+    # tomo must be C-contiguous float32, threads are spawned on the C side.
     dt, dy, dx = tomo.shape
 
     LIB_TOMOPY.normalize_bg.restype = dtype.as_c_void_p()
@@ -123,30 +145,135 @@ def c_normalize_bg(tomo, air):
         dtype.as_c_int(dt),
         dtype.as_c_int(dy),
         dtype.as_c_int(dx),
-        dtype.as_c_int(air))
+        dtype.as_c_int(air),
+        dtype.as_c_int(median),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else nchunk))
 
 
-def c_remove_stripe_sf(tomo, size):
-    # TODO: we should fix this elsewhere...
-    # TOMO object must be contiguous for c function to work
-    contiguous_tomo = np.require(tomo, requirements="AC")
-    dx, dy, dz = tomo.shape
-    istart = 0
-    iend = dy
+def c_normalize_fused(tomo, flat, dark, out, cutoff, dif, size, air,
+                      air_median, minus_log, ncore=None):
+    # tomo is uint16 or float32, flat, dark and out are float32, all
+    # C-contiguous. Threads are spawned on the C side.
+    dt, dy, dx = tomo.shape
+    if tomo.dtype == np.uint16:
+        func = LIB_TOMOPY.normalize_fused_uint16
+        data = dtype.as_c_uint16_p(tomo)
+    else:
+        func = LIB_TOMOPY.normalize_fused_float32
+        data = dtype.as_c_float_p(tomo)
+
+    func.restype = dtype.as_c_void_p()
+    func(
+        data,
+        dtype.as_c_float_p(flat),
+        dtype.as_c_float_p(dark),
+        dtype.as_c_float_p(out),
+        dtype.as_c_int(dt),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dx),
+        dtype.as_c_float(cutoff),
+        dtype.as_c_float(dif),
+        dtype.as_c_int(size),
+        dtype.as_c_int(air),
+        dtype.as_c_int(air_median),
+        dtype.as_c_int(minus_log),
+        dtype.as_c_int(0 if ncore is None else ncore))
+
 
+def c_retrieve_phase(tomo, phase_filter, py, pz, mode='edge', cval=0,
+                     ncore=None, nchunk=None):
+    # All projections are filtered in C, threads are spawned there.
+    # tomo must be a C-contiguous float32 array, it is filtered in place.
+    dx, dy, dz = tomo.shape
+    LIB_TOMOPY.retrieve_phase.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.retrieve_phase(
+        dtype.as_c_float_p(tomo),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        dtype.as_c_float_p(phase_filter),
+        dtype.as_c_int(py),
+        dtype.as_c_int(pz),
+        dtype.as_c_int(PAD_MODES[mode]),
+        dtype.as_c_float(float(cval)),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else nchunk))
+
+
+def c_remove_stripe_sf(tomo, size, ncore=None, nchunk=None):
+    # All slices are corrected in C, threads are spawned there.
+    # tomo must be a C-contiguous float32 array, it is corrected in place.
+    dx, dy, dz = tomo.shape
     LIB_TOMOPY.remove_stripe_sf.restype = dtype.as_c_void_p()
     LIB_TOMOPY.remove_stripe_sf(
-        dtype.as_c_float_p(contiguous_tomo),
+        dtype.as_c_float_p(tomo),
         dtype.as_c_int(dx),
         dtype.as_c_int(dy),
         dtype.as_c_int(dz),
         dtype.as_c_int(size),
-        dtype.as_c_int(istart),
-        dtype.as_c_int(iend))
-    tomo[:] = contiguous_tomo[:]
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else nchunk))
+
+
+def _c_remove_stripe_vo(name, tomo, args, ncore, nchunk):
+    # Vo's methods run over all slices in C, threads are spawned there.
+    # tomo must be a C-contiguous float32 array, it is corrected in place.
+    dx, dy, dz = tomo.shape
+    func = getattr(LIB_TOMOPY, name)
+    func.restype = dtype.as_c_void_p()
+    func(
+        dtype.as_c_float_p(tomo),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        *(args + (dtype.as_c_int(0 if ncore is None else ncore),
+                  dtype.as_c_int(0 if nchunk is None else nchunk))))
+
+
+def c_remove_stripe_based_sorting(tomo, size, ncore=None, nchunk=None):
+    _c_remove_stripe_vo(
+        'remove_stripe_based_sorting', tomo,
+        (dtype.as_c_int(size),), ncore, nchunk)
+
+
+def c_remove_stripe_based_filtering(tomo, sigma, size, ncore=None,
+                                    nchunk=None):
+    _c_remove_stripe_vo(
+        'remove_stripe_based_filtering', tomo,
+        (dtype.as_c_float(sigma), dtype.as_c_int(size)), ncore, nchunk)
+
+
+def c_remove_stripe_based_fitting(tomo, order, sigma, ncore=None,
+                                  nchunk=None):
+    sigmax, sigmay = sigma
+    _c_remove_stripe_vo(
+        'remove_stripe_based_fitting', tomo,
+        (dtype.as_c_int(order), dtype.as_c_float(sigmax),
+         dtype.as_c_float(sigmay)), ncore, nchunk)
+
+
+def c_remove_large_stripe(tomo, snr, size, ncore=None, nchunk=None):
+    _c_remove_stripe_vo(
+        'remove_large_stripe', tomo,
+        (dtype.as_c_float(snr), dtype.as_c_int(size)), ncore, nchunk)
+
+
+def c_remove_dead_stripe(tomo, snr, size, ncore=None, nchunk=None):
+    _c_remove_stripe_vo(
+        'remove_dead_stripe', tomo,
+        (dtype.as_c_float(snr), dtype.as_c_int(size)), ncore, nchunk)
+
+
+def c_remove_all_stripe(tomo, snr, la_size, sm_size, ncore=None,
+                        nchunk=None):
+    _c_remove_stripe_vo(
+        'remove_all_stripe', tomo,
+        (dtype.as_c_float(snr), dtype.as_c_int(la_size),
+         dtype.as_c_int(sm_size)), ncore, nchunk)
 
 
-def c_project(obj, center, tomo, theta):
+def c_project(obj, center, tomo, theta, ncore=None, nchunk=None):
     # TODO: we should fix this elsewhere...
     # TOMO object must be contiguous for c function to work
 
@@ -176,11 +303,13 @@ def c_project(obj, center, tomo, theta):
         dtype.as_c_int(dt),
         dtype.as_c_int(dx),
         dtype.as_c_float_p(center),
-        dtype.as_c_float_p(theta))
+        dtype.as_c_float_p(theta),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
     tomo[:] = contiguous_tomo[:]
 
 
-def c_project2(objx, objy, center, tomo, theta):
+def c_project2(objx, objy, center, tomo, theta, ncore=None, nchunk=None):
     # TODO: we should fix this elsewhere...
     # TOMO object must be contiguous for c function to work
 
@@ -211,11 +340,14 @@ def c_project2(objx, objy, center, tomo, theta):
         dtype.as_c_int(dt),
         dtype.as_c_int(dx),
         dtype.as_c_float_p(center),
-        dtype.as_c_float_p(theta))
+        dtype.as_c_float_p(theta),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
     tomo[:] = contiguous_tomo[:]
 
 
-def c_project3(objx, objy, objz, center, tomo, theta, axis):
+def c_project3(objx, objy, objz, center, tomo, theta, axis, ncore=None,
+               nchunk=None):
     # TODO: we should fix this elsewhere...
     # TOMO object must be contiguous for c function to work
 
@@ -248,11 +380,100 @@ def c_project3(objx, objy, objz, center, tomo, theta, axis):
         dtype.as_c_int(dx),
         dtype.as_c_float_p(center),
         dtype.as_c_float_p(theta),
-        dtype.as_c_int(axis))
+        dtype.as_c_int(axis),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
     tomo[:] = contiguous_tomo[:]
 
 
-def c_sample(mode, arr, dx, dy, dz, level, axis, out):
+def c_project_cone(obj, center, vcenter, tomo, theta, dist, ncore=None,
+                   nchunk=None):
+    oy, ox, oz = obj.shape
+    dy, dt, dx = tomo.shape
+
+    LIB_TOMOPY.project_cone.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.project_cone(
+        dtype.as_c_float_p(obj),
+        dtype.as_c_int(oy),
+        dtype.as_c_int(ox),
+        dtype.as_c_int(oz),
+        dtype.as_c_float_p(tomo),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dt),
+        dtype.as_c_int(dx),
+        dtype.as_c_float(center),
+        dtype.as_c_float(vcenter),
+        dtype.as_c_float_p(theta),
+        dtype.as_c_float(dist),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
+    return tomo
+
+
+def c_propagate_tie(mu, delta, out, pixel_size, dist, ncore=None):
+    # mu, delta and out are C-contiguous float32 stacks of one shape.
+    dx, dy, dz = delta.shape
+    LIB_TOMOPY.propagate_tie.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.propagate_tie(
+        dtype.as_c_float_p(mu),
+        dtype.as_c_float_p(delta),
+        dtype.as_c_float_p(out),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        dtype.as_c_float(pixel_size),
+        dtype.as_c_float(dist),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return out
+
+
+def c_propagate_fresnel(mu, delta, out, pixel_size, dist, wavelength,
+                        ncore=None):
+    # mu, delta and out are C-contiguous float32 stacks of one shape.
+    dx, dy, dz = delta.shape
+    LIB_TOMOPY.propagate_fresnel.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.propagate_fresnel(
+        dtype.as_c_float_p(mu),
+        dtype.as_c_float_p(delta),
+        dtype.as_c_float_p(out),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        dtype.as_c_float(pixel_size),
+        dtype.as_c_float(dist),
+        dtype.as_c_float(wavelength),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return out
+
+
+def c_calc_intensity(probe, proj, x, y, cplx, far, out, ncore=None):
+    # probe (sx, sy) and proj (nproj, px, py) are C-contiguous float32, or
+    # complex64 if cplx, x and y int32 scan corners, out is
+    # (nproj, x.size * y.size, sx, sy).
+    sx, sy = probe.shape
+    nproj, px, py = proj.shape
+    LIB_TOMOPY.calc_intensity.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.calc_intensity(
+        dtype.as_c_float_p(probe),
+        dtype.as_c_int(sx),
+        dtype.as_c_int(sy),
+        dtype.as_c_float_p(proj),
+        dtype.as_c_int(nproj),
+        dtype.as_c_int(px),
+        dtype.as_c_int(py),
+        dtype.as_c_int_p(x),
+        dtype.as_c_int(x.size),
+        dtype.as_c_int_p(y),
+        dtype.as_c_int(y.size),
+        dtype.as_c_int(cplx),
+        dtype.as_c_int(far),
+        dtype.as_c_float_p(out),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return out
+
+
+def c_sample(mode, arr, factor, median, ncore, out):
+    dx, dy, dz = arr.shape
     LIB_TOMOPY.sample.restype = dtype.as_c_void_p()
     LIB_TOMOPY.sample(
         dtype.as_c_int(mode),
@@ -260,96 +481,279 @@ def c_sample(mode, arr, dx, dy, dz, level, axis, out):
         dtype.as_c_int(dx),
         dtype.as_c_int(dy),
         dtype.as_c_int(dz),
-        dtype.as_c_int(level),
-        dtype.as_c_int(axis),
+        dtype.as_c_int_p(factor),
+        dtype.as_c_int(median),
+        dtype.as_c_int(0 if ncore is None else ncore),
         dtype.as_c_float_p(out))
     return out
 
 
-def c_art(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.art.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.art(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']))
-
+def c_swap_stack(arr, out, ncore):
+    # arr and out are C-contiguous with the same dtype
+    n0, n1 = arr.shape[:2]
+    LIB_TOMOPY.swap_stack.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.swap_stack(
+        arr.ctypes.data_as(ctypes.c_void_p),
+        out.ctypes.data_as(ctypes.c_void_p),
+        dtype.as_c_int(n0),
+        dtype.as_c_int(n1),
+        dtype.as_c_int(arr.size // max(n0 * n1, 1)),
+        dtype.as_c_int(arr.itemsize),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return out
 
-def c_bart(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
 
-    LIB_TOMOPY.bart.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.bart(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_int(kwargs['num_block']),
-            dtype.as_c_float_p(kwargs['ind_block']))  # TODO: I think this should be int_p
+def c_swap_stack_inplace(arr, ncore):
+    n0, n1 = arr.shape[:2]
+    LIB_TOMOPY.swap_stack_inplace.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.swap_stack_inplace(
+        arr.ctypes.data_as(ctypes.c_void_p),
+        dtype.as_c_int(n0),
+        dtype.as_c_int(n1),
+        dtype.as_c_int(arr.size // max(n0 * n1, 1)),
+        dtype.as_c_int(arr.itemsize),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return arr.reshape((n1, n0) + arr.shape[2:])
 
 
-def c_fbp(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
+def c_sino_360_to_180(arr, overlap, left, ncore, out):
+    dx, dy, dz = arr.shape
+    LIB_TOMOPY.sino_360_to_180.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.sino_360_to_180(
+        dtype.as_c_float_p(arr),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        dtype.as_c_int(overlap),
+        dtype.as_c_int(left),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_float_p(out))
+    return out
 
-    LIB_TOMOPY.fbp.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.fbp(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_char_p(kwargs['filter_name']),
-            dtype.as_c_float_p(kwargs['filter_par']))  # filter_par
 
+def c_pad_volume(arr, axis, npad, mode, cval, ncore, out):
+    dx, dy, dz = arr.shape
+    LIB_TOMOPY.pad_volume.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.pad_volume(
+        dtype.as_c_float_p(arr),
+        dtype.as_c_int(dx),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dz),
+        dtype.as_c_int(axis),
+        dtype.as_c_int(npad),
+        dtype.as_c_int(PAD_MODES[mode]),
+        dtype.as_c_float(float(cval)),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_float_p(out))
+    return out
 
-def c_gridrec(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
 
-    LIB_TOMOPY.gridrec.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.gridrec(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
+def c_profile_enabled():
+    LIB_TOMOPY.profile_enabled.restype = ctypes.c_int
+    return bool(LIB_TOMOPY.profile_enabled())
+
+
+def c_profile_reset():
+    LIB_TOMOPY.profile_reset.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.profile_reset()
+
+
+# Must match PROFILE_NAME_LEN and PROFILE_MAX_PHASES in the C library.
+_PROFILE_NAME_LEN = 32
+_PROFILE_MAX_PHASES = 64
+
+
+def c_profile_phases():
+    # returns names, call counts, seconds and bytes of the timed phases
+    nmax = _PROFILE_MAX_PHASES
+    names = ctypes.create_string_buffer(nmax * _PROFILE_NAME_LEN)
+    counts = np.zeros(nmax, dtype='int64')
+    seconds = np.zeros(nmax, dtype='float64')
+    nbytes = np.zeros(nmax, dtype='float64')
+    LIB_TOMOPY.profile_phases.restype = ctypes.c_int
+    n = LIB_TOMOPY.profile_phases(
+        dtype.as_c_int(nmax),
+        names,
+        counts.ctypes.data_as(ctypes.POINTER(ctypes.c_longlong)),
+        seconds.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+        nbytes.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+    n = min(n, nmax)
+    raw = names.raw
+    labels = [raw[i * _PROFILE_NAME_LEN:(i + 1) * _PROFILE_NAME_LEN]
+              .split(b'\0', 1)[0].decode() for i in range(n)]
+    return labels, counts[:n], seconds[:n], nbytes[:n]
+
+
+def c_profile_events():
+    # returns phase index, thread, start and duration of the logged events
+    LIB_TOMOPY.profile_events.restype = ctypes.c_int
+    n = LIB_TOMOPY.profile_events(0, None, None, None, None)
+    phase = np.zeros(n, dtype='int32')
+    thread = np.zeros(n, dtype='int32')
+    start = np.zeros(n, dtype='float64')
+    duration = np.zeros(n, dtype='float64')
+    n = min(n, LIB_TOMOPY.profile_events(
+        dtype.as_c_int(n),
+        dtype.as_c_int_p(phase),
+        dtype.as_c_int_p(thread),
+        start.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+        duration.ctypes.data_as(ctypes.POINTER(ctypes.c_double))))
+    return phase[:n], thread[:n], start[:n], duration[:n]
+
+
+def c_vo_center_metric(sino, mask, shift, ncore, metric):
+    nsino, nrow, ncol = sino.shape
+    LIB_TOMOPY.vo_center_metric.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.vo_center_metric(
+        dtype.as_c_float_p(sino),
+        dtype.as_c_int(nsino),
+        dtype.as_c_int(nrow),
+        dtype.as_c_int(ncol),
+        dtype.as_c_float_p(mask),
+        dtype.as_c_float_p(shift),
+        dtype.as_c_int(shift.shape[-1]),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_float_p(metric))
+    return metric
+
+
+def c_set_num_threads(nthreads):
+    LIB_TOMOPY.set_num_threads.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.set_num_threads(dtype.as_c_int(nthreads))
+
+
+def c_get_num_threads():
+    LIB_TOMOPY.get_num_threads.restype = ctypes.c_int
+    return LIB_TOMOPY.get_num_threads()
+
+
+def c_has_openmp():
+    LIB_TOMOPY.has_openmp.restype = ctypes.c_int
+    return bool(LIB_TOMOPY.has_openmp())
+
+
+def c_set_numa_mode(mode):
+    LIB_TOMOPY.set_numa_mode.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.set_numa_mode(dtype.as_c_int(mode))
+
+
+def c_get_numa_mode():
+    LIB_TOMOPY.get_numa_mode.restype = ctypes.c_int
+    return bool(LIB_TOMOPY.get_numa_mode())
+
+
+def c_touch_volume(arr, val, ncore=None):
+    # arr is C-contiguous float32, split along its first axis
+    LIB_TOMOPY.touch_volume.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.touch_volume(
+        dtype.as_c_float_p(arr),
+        dtype.as_c_int(arr.shape[0]),
+        dtype.as_c_int(arr.size // max(arr.shape[0], 1)),
+        dtype.as_c_float(val),
+        dtype.as_c_int(0 if ncore is None else ncore))
+    return arr
+
+
+def c_volume_bandwidth(arr, nrep, ncore=None):
+    # returns the seconds taken and the NUMA node of each thread
+    nthreads = ncore or c_get_num_threads()
+    seconds = np.zeros(nthreads, dtype='float64')
+    node = np.full(nthreads, -1, dtype='int32')
+    LIB_TOMOPY.volume_bandwidth.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.volume_bandwidth(
+        dtype.as_c_float_p(arr),
+        dtype.as_c_int(arr.shape[0]),
+        dtype.as_c_int(arr.size // max(arr.shape[0], 1)),
+        dtype.as_c_int(nrep),
+        dtype.as_c_int(nthreads),
+        seconds.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+        dtype.as_c_int_p(node))
+    return seconds, node
+
+
+def _volume_nchunk(nchunk):
+    # The whole-volume kernels give each thread one block in NUMA mode, so
+    # the pages a thread first touched stay local; a chunk size is ignored.
+    if nchunk and c_get_numa_mode():
+        logger.warning('NUMA mode is on, ignoring nchunk=%d', nchunk)
+    return nchunk
+
+
+def c_recon_volume(algorithm, tomo, center, recon, theta, ncore, nchunk,
+                   init=None, **kwargs):
+    # One call for the whole volume, slices are split over threads in C.
+    dy, dt, dx = tomo.shape
+    nchunk = _volume_nchunk(nchunk)
+    raw = tomo.dtype == np.uint16
+
+    def optional(key, as_c):
+        return as_c(kwargs[key]) if key in kwargs else None
+
+    LIB_TOMOPY.recon_volume.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.recon_volume(
+        dtype.as_c_char_p(algorithm),
+        None if raw else dtype.as_c_float_p(tomo),
+        dtype.as_c_uint16_p(tomo) if raw else None,
+        optional('flat', dtype.as_c_float_p),
+        optional('dark', dtype.as_c_float_p),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dt),
+        dtype.as_c_int(dx),
+        dtype.as_c_float_p(center),
+        dtype.as_c_float_p(theta),
+        dtype.as_c_float_p(recon),
+        dtype.as_c_int(kwargs['num_gridx']),
+        dtype.as_c_int(kwargs['num_gridy']),
+        optional('num_iter', dtype.as_c_int),
+        optional('reg_par', dtype.as_c_float_p),
+        optional('num_block', dtype.as_c_int),
+        optional('ind_block', dtype.as_c_float_p),
+        optional('filter_name', dtype.as_c_char_p),
+        optional('filter_par', dtype.as_c_float_p),
+        optional('pad_width', dtype.as_c_int),
+        dtype.as_c_int(PAD_MODES[kwargs.get('pad_mode', 'constant')]),
+        None if init is None else ctypes.byref(ctypes.c_float(init)),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        # nchunk=0 means one slice at a time in tomopy, auto in C
+        dtype.as_c_int(1 if nchunk == 0 else nchunk or 0))
+    return recon
+
+
+def c_fdk(tomo, center, vcenter, recon, theta, dist, filter_name,
+          filter_par, ncore=None, nchunk=None):
+    dy, dt, dx = tomo.shape
+    nz, ngridx, ngridy = recon.shape
+
+    LIB_TOMOPY.fdk.restype = dtype.as_c_void_p()
+    LIB_TOMOPY.fdk(
+        dtype.as_c_float_p(tomo),
+        dtype.as_c_int(dy),
+        dtype.as_c_int(dt),
+        dtype.as_c_int(dx),
+        dtype.as_c_float(center),
+        dtype.as_c_float(vcenter),
+        dtype.as_c_float_p(theta),
+        dtype.as_c_float(dist),
+        dtype.as_c_float_p(recon),
+        dtype.as_c_int(nz),
+        dtype.as_c_int(ngridx),
+        dtype.as_c_int(ngridy),
+        dtype.as_c_char_p(filter_name),
+        dtype.as_c_float_p(filter_par),
+        dtype.as_c_int(0 if ncore is None else ncore),
+        dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
+    return recon
+
+
+def c_gridrec_sweep(sino, center, recon, theta, **kwargs):
+    dt, dx = sino.shape
+    LIB_TOMOPY.gridrec_sweep.restype = dtype.as_c_void_p()
+    return LIB_TOMOPY.gridrec_sweep(
+            dtype.as_c_float_p(sino),
             dtype.as_c_int(dt),
             dtype.as_c_int(dx),
             dtype.as_c_float_p(center),
+            dtype.as_c_int(center.size),
             dtype.as_c_float_p(theta),
             dtype.as_c_float_p(recon),
             dtype.as_c_int(kwargs['num_gridx']),
@@ -358,214 +762,8 @@ def c_gridrec(tomo, center, recon, theta, **kwargs):
             dtype.as_c_float_p(kwargs['filter_par']))
 
 
-def c_mlem(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.mlem.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.mlem(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']))
-
-
-def c_osem(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.osem.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.osem(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_int(kwargs['num_block']),
-            dtype.as_c_float_p(kwargs['ind_block']))  # TODO: should be int?
-
-
-def c_ospml_hybrid(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.ospml_hybrid.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.ospml_hybrid(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']),
-            dtype.as_c_int(kwargs['num_block']),
-            dtype.as_c_float_p(kwargs['ind_block']))  # TODO: should be int?
-
-
-def c_ospml_quad(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.ospml_quad.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.ospml_quad(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']),
-            dtype.as_c_int(kwargs['num_block']),
-            dtype.as_c_float_p(kwargs['ind_block']))  # TODO: should be int?
-
-
-def c_pml_hybrid(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.pml_hybrid.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.pml_hybrid(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']))
-
-
-def c_pml_quad(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.pml_quad.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.pml_quad(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']))
-
-
-def c_sirt(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.sirt.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.sirt(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']))
-
-def c_tv(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.tv.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.tv(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']))
-
-def c_grad(tomo, center, recon, theta, **kwargs):
-    if len(tomo.shape) == 2:
-        # no y-axis (only one slice)
-        dy = 1
-        dt, dx = tomo.shape
-    else:
-        dy, dt, dx = tomo.shape
-
-    LIB_TOMOPY.grad.restype = dtype.as_c_void_p()
-    return LIB_TOMOPY.grad(
-            dtype.as_c_float_p(tomo),
-            dtype.as_c_int(dy),
-            dtype.as_c_int(dt),
-            dtype.as_c_int(dx),
-            dtype.as_c_float_p(center),
-            dtype.as_c_float_p(theta),
-            dtype.as_c_float_p(recon),
-            dtype.as_c_int(kwargs['num_gridx']),
-            dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']),
-            dtype.as_c_float_p(kwargs['reg_par']))
-
-def c_vector(tomo, center, recon1, recon2, theta, **kwargs):
+def c_vector(tomo, center, recon1, recon2, theta, ncore=None, nchunk=None,
+             **kwargs):
     if len(tomo.shape) == 2:
         # no y-axis (only one slice)
         dy = 1
@@ -573,6 +771,7 @@ def c_vector(tomo, center, recon1, recon2, theta, **kwargs):
     else:
         dy, dt, dx = tomo.shape
 
+    nchunk = _volume_nchunk(nchunk)
     LIB_TOMOPY.vector.restype = dtype.as_c_void_p()
     return LIB_TOMOPY.vector(
             dtype.as_c_float_p(tomo),
@@ -585,10 +784,12 @@ def c_vector(tomo, center, recon1, recon2, theta, **kwargs):
             dtype.as_c_float_p(recon2),
             dtype.as_c_int(kwargs['num_gridx']),
             dtype.as_c_int(kwargs['num_gridy']),
-            dtype.as_c_int(kwargs['num_iter']))
+            dtype.as_c_int(kwargs['num_iter']),
+            dtype.as_c_int(0 if ncore is None else ncore),
+            dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
 
 
-def c_vector2(tomo1, tomo2, center1, center2, recon1, recon2, recon3, theta1, theta2, axis1, axis2, **kwargs):
+def c_vector2(tomo1, tomo2, center1, center2, recon1, recon2, recon3, theta1, theta2, axis1, axis2, ncore=None, nchunk=None, **kwargs):
     if len(tomo1.shape) == 2:
         # no y-axis (only one slice)
         dy = 1
@@ -596,6 +797,7 @@ def c_vector2(tomo1, tomo2, center1, center2, recon1, recon2, recon3, theta1, th
     else:
         dy, dt, dx = tomo1.shape
 
+    nchunk = _volume_nchunk(nchunk)
     LIB_TOMOPY.vector2.restype = dtype.as_c_void_p()
     return LIB_TOMOPY.vector2(
             dtype.as_c_float_p(tomo1),
@@ -614,10 +816,12 @@ def c_vector2(tomo1, tomo2, center1, center2, recon1, recon2, recon3, theta1, th
             dtype.as_c_int(kwargs['num_gridy']),
             dtype.as_c_int(kwargs['num_iter']),
             dtype.as_c_int(axis1),
-            dtype.as_c_int(axis2))
+            dtype.as_c_int(axis2),
+            dtype.as_c_int(0 if ncore is None else ncore),
+            dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
 
 
-def c_vector3(tomo1, tomo2, tomo3, center1, center2, center3, recon1, recon2, recon3, theta1, theta2, theta3, axis1, axis2, axis3, **kwargs):
+def c_vector3(tomo1, tomo2, tomo3, center1, center2, center3, recon1, recon2, recon3, theta1, theta2, theta3, axis1, axis2, axis3, ncore=None, nchunk=None, **kwargs):
     if len(tomo1.shape) == 2:
         # no y-axis (only one slice)
         dy = 1
@@ -625,6 +829,7 @@ def c_vector3(tomo1, tomo2, tomo3, center1, center2, center3, recon1, recon2, re
     else:
         dy, dt, dx = tomo1.shape
 
+    nchunk = _volume_nchunk(nchunk)
     LIB_TOMOPY.vector3.restype = dtype.as_c_void_p()
     return LIB_TOMOPY.vector3(
             dtype.as_c_float_p(tomo1),
@@ -647,13 +852,17 @@ def c_vector3(tomo1, tomo2, tomo3, center1, center2, center3, recon1, recon2, re
             dtype.as_c_int(kwargs['num_iter']),
             dtype.as_c_int(axis1),
             dtype.as_c_int(axis2),
-            dtype.as_c_int(axis3))
+            dtype.as_c_int(axis3),
+            dtype.as_c_int(0 if ncore is None else ncore),
+            dtype.as_c_int(0 if nchunk is None else max(nchunk, 1)))
 
 
 
-def c_remove_ring(rec, *args):
+def c_remove_ring(rec, *args, **kwargs):
+    # All slices in one call, split over threads in C.
     istart = 0
     iend = rec.shape[0]
+    ncore = kwargs.get('ncore')
     LIB_TOMOPY.remove_ring.restype = dtype.as_c_void_p()
     return LIB_TOMOPY.remove_ring(
             dtype.as_c_float_p(rec),
@@ -669,4 +878,5 @@ def c_remove_ring(rec, *args):
             dtype.as_c_int(args[9]),  # rwidth
             dtype.as_c_int(args[10]),  # int_mode
             dtype.as_c_int(istart),  # istart
-            dtype.as_c_int(iend))  # iend
+            dtype.as_c_int(iend),  # iend
+            dtype.as_c_int(0 if ncore is None else ncore))  # ncore
@@ -53,11 +53,14 @@ Module for multiprocessing tasks.
 from __future__ import (absolute_import, division, print_function,
                         unicode_literals)
 
+import atexit
 import numpy as np
 import multiprocessing as mp
+import concurrent.futures as cf
+import threading
 import math
-from contextlib import closing
-from .dtype import as_sharedmem, to_numpy_array, get_shared_mem
+from .dtype import as_mapped, get_mapped_name, map_array, release_mapped
+from . import extern
 import logging
 import numexpr as ne
 
@@ -67,19 +70,25 @@ logger = logging.getLogger(__name__)
 __author__ = "Doga Gursoy"
 __copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
 __docformat__ = 'restructuredtext en'
-__all__ = ['distribute_jobs']
-
-# global shared variables
-SHARED_ARRAYS = None
-SHARED_OUT = None
-SHARED_QUEUE = None
-INTYPE = None
-INSHAPE = None
-OUTTYPE = None
-OUTSHAPE = None
-ON_HOST = False
+__all__ = ['distribute_jobs',
+           'get_dispatcher',
+           'get_num_threads',
+           'get_numa_mode',
+           'get_pool',
+           'set_num_threads',
+           'set_numa_mode',
+           'shutdown_pool']
+
 DEBUG = False
 
+# Persistent worker pool, see get_pool.
+POOL = None
+POOL_SIZE = 0
+
+# Persistent dispatcher thread for native calls, see get_dispatcher.
+DISPATCHER = None
+DISPATCHER_LOCK = threading.Lock()
+
 
 def set_debug(val=True):
     """
@@ -94,6 +103,47 @@ def set_debug(val=True):
     DEBUG = val
 
 
+def set_num_threads(nthreads):
+    """
+    Set the size of the thread team used by the C library.
+
+    Functions that run in the C library split the volume over this many
+    threads whenever they are called with ``ncore=None``. The default is taken
+    from the ``TOMOPY_NUM_THREADS`` environment variable, or the number of
+    processors if that is unset. A value of 0 restores the default.
+    """
+    extern.c_set_num_threads(nthreads)
+
+
+def get_num_threads():
+    """
+    Return the size of the thread team used by the C library.
+    """
+    return extern.c_get_num_threads()
+
+
+def set_numa_mode(val=True):
+    """
+    Turn NUMA-aware scheduling in the C library on or off.
+
+    In NUMA mode, whole-volume functions such as :func:`tomopy.recon` pin
+    their threads to CPUs node by node and give each thread one contiguous
+    block of slices. Each thread first touches the output pages it writes, so
+    on multi-socket machines they land on its own node instead of the node of
+    the calling thread. A user-supplied ``nchunk`` is ignored by these
+    functions in NUMA mode, with a warning. The default is taken from the
+    ``TOMOPY_NUMA`` environment variable.
+    """
+    extern.c_set_numa_mode(int(val))
+
+
+def get_numa_mode():
+    """
+    Return whether NUMA-aware scheduling is on in the C library.
+    """
+    return extern.c_get_numa_mode()
+
+
 def get_ncore_nchunk(axis_size, ncore=None, nchunk=None):
     # limit chunk size to size of array along axis
     if nchunk and nchunk > axis_size:
@@ -133,6 +183,66 @@ def get_ncore_slices(axis_size, ncore=None, nchunk=None):
     return ncore, slcs
 
 
+def get_pool(ncore=None):
+    """
+    Return the persistent worker pool, starting it on first use with one
+    process per CPU, or ``ncore`` processes if that is more.
+
+    The pool is never shrunk: a call that wants fewer cores submits fewer
+    jobs (see :func:`distribute_jobs`) and leaves the other workers idle.
+
+    Workers live across calls. Arrays are handed to them as named shared
+    mappings (see :func:`tomopy.util.dtype.empty_mapped_array`), so any
+    picklable function, including the ctypes wrappers in
+    :mod:`tomopy.util.extern`, can be dispatched through the pool.
+    """
+    global POOL
+    global POOL_SIZE
+    size = max(mp.cpu_count(), ncore or 0)
+    if POOL is not None and POOL_SIZE < size:
+        shutdown_pool()
+    if POOL is None:
+        POOL = mp.Pool(processes=size)
+        POOL_SIZE = size
+    return POOL
+
+
+def get_dispatcher():
+    """
+    Return the persistent thread that queues work for the C library.
+
+    Jobs submitted to it run one at a time in submission order, each over
+    the whole thread team of the C library (see :func:`set_num_threads`),
+    so the caller is not blocked and the team is never oversubscribed.
+    """
+    global DISPATCHER
+    with DISPATCHER_LOCK:
+        if DISPATCHER is None:
+            DISPATCHER = cf.ThreadPoolExecutor(1)
+        return DISPATCHER
+
+
+def shutdown_pool():
+    """
+    Stop the persistent worker pool and the dispatcher thread.
+    """
+    global POOL
+    global POOL_SIZE
+    global DISPATCHER
+    if POOL is not None:
+        POOL.terminate()
+        POOL.join()
+    POOL = None
+    POOL_SIZE = 0
+    with DISPATCHER_LOCK:
+        if DISPATCHER is not None:
+            DISPATCHER.shutdown()
+        DISPATCHER = None
+
+
+atexit.register(shutdown_pool)
+
+
 def distribute_jobs(arr,
                     func,
                     axis,
@@ -145,6 +255,10 @@ def distribute_jobs(arr,
     Distribute N-dimensional shared-memory array into cores by splitting along
     an axis.
 
+    Arrays that already live in a named shared mapping are used in place,
+    all others are copied into one. The work is run on the persistent pool
+    returned by :func:`get_pool`.
+
     Parameters
     ----------
     arr : ndarray, or iterable(ndarray)
@@ -186,145 +300,121 @@ def distribute_jobs(arr,
     args = args or tuple()
     kwargs = kwargs or dict()
 
-    # prepare global sharedmem arrays
+    # map all arrays into named shared memory
     shared_arrays = []
-    shared_shape = []
     shared_out = None
-    shared_out_shape = None
     for arr in arrs:
-        arr_shared = as_sharedmem(arr)
-        shared_arrays.append(get_shared_mem(arr_shared))
-        shared_shape.append(arr.shape)
+        arr_shared = as_mapped(arr)
+        shared_arrays.append(arr_shared)
         if out is not None and np.may_share_memory(arr, out) and \
                 arr.shape == out.shape and arr.dtype == out.dtype:
             # assume these are the same array
             shared_out = arr_shared
     if out is None:
         # default out to last array in list
-        out = shared_arrays[-1]
-        shared_out = out
-        out = to_numpy_array(out, arrs[-1].dtype, shared_shape[-1])
-        shared_out_shape = shared_shape[-1]
-        shared_out_type = arrs[-1].dtype
-    else:
-        shared_out_shape = out.shape
-        shared_out_type = out.dtype
-        shared_out = as_sharedmem(out)
-
-    # kick off process
-    # testing single threaded
-#    init_shared(shared_arrays, shared_out)
-#    for i in xrange(0, axis_size, nchunk or 1):
-#        logger.warning("loop %d of %d"%(i+1, axis_size))
-#        if nchunk:
-#            _arg_parser((func, args, kwargs, np.s_[i:i+nchunk], axis))
-#        else:
-#            _arg_parser((func, args, kwargs, i, axis))
-
-    # Set up queue
-    man = mp.Manager()
-    queue = man.Queue()
+        shared_out = shared_arrays[-1]
+        out = shared_out
+    elif shared_out is None:
+        shared_out = as_mapped(out)
+
+    # mapped copies made above are only needed while the jobs run; their
+    # files are removed even if a worker dies, the returned array is kept
+    copies = [a for a, b in zip(shared_arrays + [shared_out], arrs + [out])
+              if a is not b and a is not out]
 
     # if nchunk is zero, remove dimension from slice.
-    map_args = []
+    slcs = []
     for i in range(0, axis_size, nchunk or 1):
         if nchunk:
-            map_args.append((func, args, kwargs, np.s_[i:i + nchunk], axis))
+            slcs.append(np.s_[i:i + nchunk])
         else:
-            map_args.append((func, args, kwargs, i, axis))
-
-    init_shared(shared_arrays, shared_out, arr.dtype, shared_shape, shared_out_type, shared_out_shape, queue=queue, on_host=True)
-    if ncore > 1 and DEBUG is False:
-        with closing(mp.Pool(processes=ncore,
-                             initializer=init_shared,
-                             initargs=(shared_arrays, shared_out, arr.dtype, shared_shape, shared_out_type, shared_out_shape, queue))) as p:
-            if p._pool:
-                proclist = p._pool[:]
-                res = p.map_async(_arg_parser, map_args)
-                try:
-                    while not res.ready():
-                        if any(proc.exitcode for proc in proclist):
-                            p.terminate()
-                            raise RuntimeError(
-                                "Child process terminated before finishing")
-                        res.wait(timeout=1)
-                except KeyboardInterrupt:
-                    p.terminate()
-                    raise
-            else:
-                res = p.map_async(_arg_parser, map_args)
-        try:
-            p.close()
-            res.get()
-            p.join()
-        except:
-            p.terminate()
-            raise
-
-        clear_queue(queue, shared_arrays, shared_out)
-    else:
-        for m in map_args:
-            _arg_parser(m)
+            slcs.append(i)
+
+    try:
+        if ncore > 1 and DEBUG is False:
+            _run_on_pool(func, args, kwargs, slcs, axis, ncore,
+                         shared_arrays, shared_out)
+        else:
+            for slc in slcs:
+                _run_job(func, args, kwargs, slc, axis, shared_arrays,
+                         shared_out)
+    finally:
+        for a in copies:
+            release_mapped(a)
 
     # NOTE: will only copy if out wasn't sharedmem
-    out[:] = to_numpy_array(shared_out, shared_out_type, shared_out_shape)
-    clear_shared()
+    if shared_out is not out:
+        out[:] = shared_out
     return out
 
 
-def init_shared(
-        shared_arrays, shared_out, intype, inshape,
-        outtype, outshape, queue=None, on_host=False):
-    global SHARED_ARRAYS
-    global SHARED_OUT
-    global SHARED_QUEUE
-    global ON_HOST
-    global INTYPE
-    global OUTTYPE
-    global INSHAPE
-    global OUTSHAPE
-    SHARED_ARRAYS = shared_arrays
-    SHARED_OUT = shared_out
-    SHARED_QUEUE = queue
-    ON_HOST = on_host
-    INTYPE = intype
-    OUTTYPE = outtype
-    INSHAPE = inshape
-    OUTSHAPE = outshape
-
-
-def clear_shared():
-    global SHARED_ARRAYS
-    global SHARED_OUT
-    global SHARED_QUEUE
-    global INTYPE
-    global OUTTYPE
-    SHARED_ARRAYS = None
-    SHARED_OUT = None
-    SHARED_QUEUE = None
-    INTYPE = None
-    OUTTYPE = None
+def _run_on_pool(func, args, kwargs, slcs, axis, ncore, arrs, out):
+    # One job per core, each working through its share of the slices, so at
+    # most ncore workers of the pool are busy and each attaches once.
+    specs = [_mapped_spec(a) for a in arrs]
+    out_spec = _mapped_spec(out)
+    batches = [slcs[i::ncore] for i in range(min(ncore, len(slcs)))]
+    map_args = [(func, args, kwargs, batch, axis, specs, out_spec)
+                for batch in batches]
+    p = get_pool(ncore)
+    proclist = p._pool[:]
+    res = p.map_async(_arg_parser, map_args)
+    try:
+        while not res.ready():
+            if any(proc.exitcode for proc in proclist):
+                raise RuntimeError(
+                    "Child process terminated before finishing")
+            res.wait(timeout=1)
+        on_host = [slc for rerun in res.get() for slc in rerun]
+    except BaseException:
+        shutdown_pool()
+        raise
+    # jobs that asked to be run on the host process
+    for slc in on_host:
+        _run_job(func, args, kwargs, slc, axis, arrs, out)
+
+
+def _mapped_spec(arr):
+    return (get_mapped_name(arr), arr.dtype.str, arr.shape)
+
+
+def _run_job(func, args, kwargs, slc, axis, arrs, out):
+    func_args = tuple(slice_axis(a, slc, axis) for a in arrs) + args
+    result = func(*func_args, **kwargs)
+    if result is not None and isinstance(result, np.ndarray):
+        outslice = slice_axis(out, slc, axis)
+        outslice[:] = result[:]
+
+
+def _attach(specs):
+    """
+    Worker side mappings for ``specs``, one per distinct file.
+    """
+    maps = {}
+    for spec in specs:
+        if spec not in maps:
+            maps[spec] = map_array(*spec)
+    return [maps[spec] for spec in specs]
 
 
 def _arg_parser(params):
-    global SHARED_ARRAYS
-    global SHARED_OUT
-    global SHARED_QUEUE
-    global INTYPE
-    global OUTTYPE
-    global INSHAPE
-    global OUTSHAPE
-    func, args, kwargs, slc, axis = params
-    func_args = tuple((slice_axis(to_numpy_array(a, INTYPE, INSHAPE[idx]), slc, axis) for idx, a in enumerate(SHARED_ARRAYS))) + args
-    # NOTE: will only copy if actually different arrays
-    try:
-        result = func(*func_args, **kwargs)
+    """
+    Worker side of distribute_jobs: attach to the shared arrays by name and
+    run a batch of jobs. Returns the slices that have to be run on the host
+    instead. The mappings are dropped when the batch is done, so an idle
+    worker holds no memory of past calls.
+    """
+    func, args, kwargs, slcs, axis, specs, out_spec = params
+    arrs = _attach(list(specs) + [out_spec])
+    out = arrs.pop()
+    rerun = []
+    for slc in slcs:
+        try:
+            _run_job(func, args, kwargs, slc, axis, arrs, out)
+        except RunOnHostException:
+            rerun.append(slc)
+    return rerun
 
-        if result is not None and isinstance(result, np.ndarray):
-            outslice = slice_axis(to_numpy_array(SHARED_OUT, OUTTYPE, OUTSHAPE), slc, axis)
-            outslice[:] = result[:]
-    except RunOnHostException:
-        SHARED_QUEUE.put(params)
 
 # apply slice to specific axis on ndarray
 
@@ -333,12 +423,6 @@ def slice_axis(arr, slc, axis):
     return arr[tuple(slice(None) if i != axis else slc for i in range(arr.ndim))]
 
 
-def clear_queue(queue, shared_arrays, shared_out):
-    while not queue.empty():
-        params = queue.get(False)
-        _arg_parser(params)
-
-
 class RunOnHostException(Exception):
     pass
 
@@ -0,0 +1,144 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# #########################################################################
+# Copyright (c) 2015-2019, UChicago Argonne, LLC. All rights reserved.    #
+#                                                                         #
+# Copyright 2015-2019. UChicago Argonne, LLC. This software was produced  #
+# under U.S. Government contract DE-AC02-06CH11357 for Argonne National   #
+# Laboratory (ANL), which is operated by UChicago Argonne, LLC for the    #
+# U.S. Department of Energy. The U.S. Government has rights to use,       #
+# reproduce, and distribute this software.  NEITHER THE GOVERNMENT NOR    #
+# UChicago Argonne, LLC MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR        #
+# ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If software is     #
+# modified to produce derivative works, such modified software should     #
+# be clearly marked, so as not to confuse it with the version available   #
+# from ANL.                                                               #
+#                                                                         #
+# Additionally, redistribution and use in source and binary forms, with   #
+# or without modification, are permitted provided that the following      #
+# conditions are met:                                                     #
+#                                                                         #
+#     * Redistributions of source code must retain the above copyright    #
+#       notice, this list of conditions and the following disclaimer.     #
+#                                                                         #
+#     * Redistributions in binary form must reproduce the above copyright #
+#       notice, this list of conditions and the following disclaimer in   #
+#       the documentation and/or other materials provided with the        #
+#       distribution.                                                     #
+#                                                                         #
+#     * Neither the name of UChicago Argonne, LLC, Argonne National       #
+#       Laboratory, ANL, the U.S. Government, nor the names of its        #
+#       contributors may be used to endorse or promote products derived   #
+#       from this software without specific prior written permission.     #
+#                                                                         #
+# THIS SOFTWARE IS PROVIDED BY UChicago Argonne, LLC AND CONTRIBUTORS     #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT       #
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS       #
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL UChicago     #
+# Argonne, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,        #
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,    #
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;        #
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        #
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT      #
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN       #
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE         #
+# POSSIBILITY OF SUCH DAMAGE.                                             #
+
+"""
+Module for the phase timers of the C library.
+
+The C kernels time their phases (e.g. the gridding and FFTs of gridrec, or
+the projection and update steps of the iterative solvers) when libtomopy is
+built with ``CFLAGS=-DTOMOPY_PROFILE``. In other builds the timers are
+compiled out and the functions below report nothing.
+"""
+
+from __future__ import (absolute_import, division, print_function,
+                        unicode_literals)
+
+import json
+import tomopy.util.extern as extern
+
+
+__author__ = "Doga Gursoy"
+__copyright__ = "Copyright (c) 2015, UChicago Argonne, LLC."
+__docformat__ = 'restructuredtext en'
+__all__ = ['profile_enabled',
+           'reset_profile',
+           'get_profile',
+           'get_profile_events',
+           'dump_profile']
+
+
+def profile_enabled():
+    """
+    Return whether the loaded C library was built with phase timers.
+    """
+    return extern.c_profile_enabled()
+
+
+def reset_profile():
+    """
+    Clear all phase totals and logged events.
+    """
+    extern.c_profile_reset()
+
+
+def get_profile():
+    """
+    Return the totals of every timed phase since the last reset.
+
+    Returns
+    -------
+    dict
+        Maps each phase name to a dict with its number of ``calls``, total
+        wall time in ``seconds`` summed over threads, and ``bytes`` of data
+        touched.
+    """
+    names, counts, seconds, nbytes = extern.c_profile_phases()
+    return {name: {'calls': int(c), 'seconds': float(t), 'bytes': float(b)}
+            for name, c, t, b in zip(names, counts, seconds, nbytes)}
+
+
+def get_profile_events():
+    """
+    Return the logged phase events since the last reset, oldest first.
+
+    Only the first 65536 events after a reset are logged.
+
+    Returns
+    -------
+    list of dict
+        Each with the ``phase`` name, the ``thread`` number it ran on, and
+        its ``start`` and ``duration`` in seconds.
+    """
+    names = extern.c_profile_phases()[0]
+    phase, thread, start, duration = extern.c_profile_events()
+    return [{'phase': names[p], 'thread': int(t), 'start': float(s),
+             'duration': float(d)}
+            for p, t, s, d in zip(phase, thread, start, duration)]
+
+
+def dump_profile(fname, trace=False):
+    """
+    Write the profile to a JSON file.
+
+    Parameters
+    ----------
+    fname : str
+        Output file name.
+    trace : bool, optional
+        Write the logged events in Chrome trace format (for
+        chrome://tracing or Perfetto) instead of the phase totals.
+    """
+    if trace:
+        data = {'traceEvents': [
+            {'name': e['phase'], 'cat': e['phase'].split('.')[0],
+             'ph': 'X', 'pid': 0, 'tid': e['thread'],
+             'ts': e['start'] * 1e6, 'dur': e['duration'] * 1e6}
+            for e in get_profile_events()]}
+    else:
+        data = get_profile()
+    with open(fname, 'w') as f:
+        json.dump(data, f, indent=1)